@@ -81,6 +81,10 @@ protocol BORGVRDatasetProtocol {
    */
   func getFirstBrick(outputBuffer: UnsafeMutablePointer<UInt8>) throws
 
+  /// Whether `getBrick` may be called from several threads at once, e.g. by the
+  /// worker pool of a `BrickLoader`.
+  var supportsConcurrentGetBrick: Bool { get }
+
   /**
    Allocates and returns a new memory buffer suitable for storing a brick.
 
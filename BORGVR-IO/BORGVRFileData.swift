@@ -22,20 +22,14 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
   /// The memory‑mapped file containing the brick data.
   private let memoryMappedFile: MemoryMappedFile
 
-  /// A scratch buffer used during decompression (allocated only if compression is enabled).
-  private let compressionScratchBuffer: UnsafeMutableRawPointer?
-
-  /// A buffer used to temporarily hold compressed brick data (allocated only if compression is enabled).
-  private let compressedDataBuffer: UnsafeMutablePointer<UInt8>?
-
   /// The expected full brick size in bytes.
   private let fullBrickSize: Int
 
   // MARK: Initialization
 
   /**
-   Initializes a new instance of BORGVRFileData by loading metadata from the specified file,
-   opening the associated memory‑mapped data file, and allocating compression buffers if needed.
+   Initializes a new instance of BORGVRFileData by loading metadata from the specified file
+   and opening the associated memory‑mapped data file.
 
    - Parameter filename: The file name containing the dataset metadata.
    - Throws: An error if loading metadata or mapping the data file fails.
@@ -48,32 +42,14 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
     // Compute the expected size of a full brick.
     fullBrickSize = metadata.brickSize * metadata.brickSize * metadata.brickSize *
     metadata.componentCount * metadata.bytesPerComponent
-    // If compression is enabled, allocate buffers for scratch space and temporary compressed data.
-    if metadata.compression {
-      let scratchBufferSize = compression_decode_scratch_buffer_size(COMPRESSION_LZ4)
-      compressionScratchBuffer = UnsafeMutableRawPointer.allocate(
-        byteCount: scratchBufferSize,
-        alignment: MemoryLayout<UInt8>.alignment
-      )
-      compressedDataBuffer = UnsafeMutablePointer<UInt8>.allocate(capacity: fullBrickSize)
-    } else {
-      compressionScratchBuffer = nil
-      compressedDataBuffer = nil
-    }
-  }
-
-  /**
-   Deinitializes the BORGVRFileData instance, deallocating any allocated compression buffers.
-   */
-  deinit {
-    // Deallocate the compression scratch buffer if allocated.
-    compressionScratchBuffer?.deallocate()
-    // Deallocate the compressed data buffer if allocated.
-    compressedDataBuffer?.deallocate()
   }
 
   // MARK: Methods
 
+  /// Bricks are decoded straight from the mapped file without shared buffers, so
+  /// `getBrick` may be called from several threads at once.
+  var supportsConcurrentGetBrick: Bool { true }
+
   /**
    Returns the dataset metadata.
 
@@ -90,8 +66,8 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
    - Parameters:
    - index: The 1D index of the brick.
    - outputBuffer: A pointer to a memory area with capacity at least `fullBrickSize` bytes.
-   - Throws: A BORGVRDataError if the memory mapping is missing, compression buffers are unavailable,
-   decompression fails, or the decompressed size does not match the expected full brick size.
+   - Throws: A BORGVRDataError if decompression fails, or the decompressed size does not match
+   the expected full brick size.
    */
   public func getBrick(index: Int, outputBuffer: UnsafeMutablePointer<UInt8>) throws {
     // Retrieve the metadata for the requested brick and load the brick.
@@ -120,8 +96,8 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
    - y: The y-coordinate index of the brick.
    - z: The z-coordinate index of the brick.
    - outputBuffer: A pointer to a memory area with capacity at least `fullBrickSize` bytes.
-   - Throws: A BORGVRDataError if the memory mapping is missing, compression buffers are unavailable,
-   decompression fails, or the decompressed size does not match the expected full brick size.
+   - Throws: A BORGVRDataError if decompression fails, or the decompressed size does not match
+   the expected full brick size.
    */
   public func getBrick(level: Int, x: Int, y: Int, z: Int,
                        outputBuffer: UnsafeMutablePointer<UInt8>) throws {
@@ -137,8 +113,8 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
    - Parameters:
    - brickMeta: The metadata for the brick to be loaded.
    - outputBuffer: A pointer to a memory area with capacity at least `fullBrickSize` bytes.
-   - Throws: A BORGVRDataError if the memory mapping is missing, compression buffers are unavailable,
-   decompression fails, or the decompressed size does not match the expected full brick size.
+   - Throws: A BORGVRDataError if decompression fails, or the decompressed size does not match
+   the expected full brick size.
    */
   private func getBrick(brickMeta: BrickMetadata,
                         outputBuffer: UnsafeMutablePointer<UInt8>) throws {
@@ -152,21 +128,14 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
     // If compression is enabled and the stored brick size is less than the full brick size,
     // decompress the brick data.
     if metadata.compression && brickMeta.size < fullBrickSize {
-      guard let compBuffer = compressedDataBuffer,
-            let scratchBuffer = compressionScratchBuffer else {
-        throw BORGVRDataError.compressionBuffersUnavailable
-      }
-
-      // Copy the compressed data from the memory-mapped file to the temporary buffer.
-      memcpy(compBuffer, brickPointer, brickMeta.size)
-
-      // Decompress the data into the output buffer.
+      // Decompress the data straight from the mapped file into the output buffer; without
+      // a scratch buffer the decoder uses its own, so concurrent calls do not interfere.
       let decompressedSize = compression_decode_buffer(
         outputBuffer,
         fullBrickSize,
-        compBuffer,
+        brickPointer,
         brickMeta.size,
-        scratchBuffer,
+        nil,
         COMPRESSION_LZ4
       )
 
@@ -202,6 +171,18 @@ final class BORGVRFileData: BORGVRDatasetProtocol {
     memcpy(outputBuffer, brickPointer, brickMeta.size)
   }
 
+  /**
+   Returns a pointer to the stored (possibly compressed) bytes of a brick inside the
+   memory-mapped file, without copying them.
+
+   - Parameter brickMeta: The metadata for the brick.
+   - Returns: A pointer to `brickMeta.size` bytes of brick data.
+   - Note: The pointer is only valid while this instance is alive and must not be written to.
+   */
+  func rawBrickPointer(brickMeta: BrickMetadata) -> UnsafeMutableRawPointer {
+    return memoryMappedFile.mappedMemory.advanced(by: brickMeta.offset)
+  }
+
   /**
    Allocates and returns a new memory buffer suitable for storing a full brick.
 
@@ -0,0 +1,410 @@
+import Foundation
+
+// MARK: - BrickedVolumeAccessor
+
+/**
+ Provides read-only access to the full-resolution level of an existing BorgVR `.data` file as
+ if it were a plain voxel volume.
+
+ Voxels are assembled from the level 0 bricks, skipping the overlap region of every brick.
+ Decoded bricks are kept in an LRU cache of at most `maxCacheBytes`, so streaming through the
+ volume slice by slice (as `BrickedVolumeReorganizer` does) decodes every brick only once as
+ long as a few rows of bricks fit into the cache, and memory stays bounded when they do not.
+ `prefetch(zRange:)` decodes all bricks of the requested slab in parallel, with one file
+ reader per worker.
+
+ This makes it possible to re-brick or re-compress a dataset without its original source.
+ */
+public class BrickedVolumeAccessor: VolumeDataAccessor {
+
+  // MARK: - Error Enumeration
+
+  /**
+   Errors that can occur while accessing a bricked volume.
+   */
+  public enum Error: Swift.Error, LocalizedError {
+    /// Attempted to read outside the valid voxel bounds.
+    case outOfBoundsAccess
+    /// Attempted to write to the read-only bricked volume.
+    case readOnlyAccessViolation
+    /// The requested reinterpretation type size is incompatible with the data size.
+    case incompatibleTypeSize
+
+    /// A localized description for each error case.
+    public var errorDescription: String? {
+      switch self {
+        case .outOfBoundsAccess:
+          return "Attempted to access data out of bounds."
+        case .readOnlyAccessViolation:
+          return "Bricked volumes can only be accessed in read-only mode."
+        case .incompatibleTypeSize:
+          return "The total byte count is not compatible with the requested type size."
+      }
+    }
+  }
+
+  // MARK: - Properties
+
+  /// The readers used to decode bricks, one per parallel worker. Reader 0 serves `getData`.
+  private let readers: [BORGVRFileData]
+
+  /// The brick size of the source dataset in voxels, including overlap.
+  private let brickSize: Int
+
+  /// The overlap of the source dataset in voxels.
+  private let overlap: Int
+
+  /// The number of voxels each brick contributes along one axis (brick size minus overlap).
+  private let brickStride: Int
+
+  /// The number of level 0 bricks along each axis.
+  private let brickCount: Vec3<Int>
+
+  /// The size of one decoded brick in bytes.
+  private let brickByteSize: Int
+
+  /// The default upper bound of the brick cache in bytes.
+  public static let defaultMaxCacheBytes = 1024 * 1024 * 1024
+
+  /// The maximum number of decoded bricks kept in memory.
+  private let maxCachedBricks: Int
+
+  /// The decoded brick in each cache slot.
+  private var slotData: [[UInt8]]
+
+  /// The brick index held by each cache slot, or -1 if the slot is free.
+  private var slotBricks: [Int]
+
+  /// The cache slot of each cached brick.
+  private var brickSlots: [Int: Int] = [:]
+
+  /// The use order of the cache slots; free slots come first, as they were never used.
+  private var slotOrder: SlotOrder
+
+  /// Lock protecting the cache and reader 0.
+  private let cacheLock = NSLock()
+
+  /// The description of the source dataset.
+  public let datasetDescription: String
+
+  /// The meta description of the source dataset.
+  public let metaDescription: String
+
+  // MARK: - Initialization
+
+  /**
+   Opens an existing BorgVR `.data` file for voxel access.
+
+   - Parameters:
+   - filename: The path to the `.data` file.
+   - maxCacheBytes: The maximum size of the decoded bricks kept in memory. No more than three
+   full rows of bricks in z are cached, as the reorganizer never needs more.
+   - workerCount: The number of parallel brick decoders used by `prefetch(zRange:)`
+   (default is the number of active processors).
+   - Throws: An error if the file or its metadata cannot be read.
+   */
+  public init(filename: String,
+              maxCacheBytes: Int = BrickedVolumeAccessor.defaultMaxCacheBytes,
+              workerCount: Int = ProcessInfo.processInfo.activeProcessorCount) throws {
+    let firstReader = try BORGVRFileData(filename: filename)
+    var readers = [firstReader]
+    for _ in 1..<max(1, workerCount) {
+      readers.append(try BORGVRFileData(filename: filename))
+    }
+    self.readers = readers
+
+    let metadata = firstReader.getMetadata()
+    self.brickSize = metadata.brickSize
+    self.overlap = metadata.overlap
+    self.brickStride = metadata.brickSize - 2 * metadata.overlap
+    self.brickCount = metadata.levelMetadata[0].totalBricks
+    self.brickByteSize = metadata.brickSize * metadata.brickSize * metadata.brickSize
+      * metadata.componentCount * metadata.bytesPerComponent
+    let maxCachedBricks = max(1, min(brickCount.x * brickCount.y * 3,
+                                     maxCacheBytes / max(1, brickByteSize)))
+    self.maxCachedBricks = maxCachedBricks
+    self.slotData = [[UInt8]](repeating: [], count: maxCachedBricks)
+    self.slotBricks = [Int](repeating: -1, count: maxCachedBricks)
+    self.slotOrder = SlotOrder(slotCount: maxCachedBricks)
+    self.datasetDescription = metadata.datasetDescription
+    self.metaDescription = metadata.metaDescription
+
+    super.init(size: Vec3<Int>(x: metadata.width, y: metadata.height, z: metadata.depth),
+               bytesPerComponent: metadata.bytesPerComponent,
+               componentCount: metadata.componentCount,
+               aspect: Vec3<Float>(x: metadata.aspectX, y: metadata.aspectY, z: metadata.aspectZ),
+               readOnly: true)
+  }
+
+  // MARK: - Brick Cache
+
+  /**
+   Computes the level 0 brick index for the given brick coordinates.
+   */
+  private func brickIndex(_ bx: Int, _ by: Int, _ bz: Int) -> Int {
+    return bx + by * brickCount.x + bz * brickCount.x * brickCount.y
+  }
+
+  /**
+   Decodes a brick with the given reader.
+
+   - Parameters:
+   - index: The brick index.
+   - reader: The reader to decode with. Readers must not be shared between threads.
+   - Returns: The decoded brick.
+   - Throws: A `BORGVRDataError` if decoding fails.
+   */
+  private func decodeBrick(_ index: Int, with reader: BORGVRFileData) throws -> [UInt8] {
+    return try [UInt8](unsafeUninitializedCapacity: brickByteSize) { buffer, initializedCount in
+      try reader.getBrick(index: index, outputBuffer: buffer.baseAddress!)
+      initializedCount = brickByteSize
+    }
+  }
+
+  /**
+   Inserts a decoded brick into the cache, evicting the least recently used brick if needed.
+   Must be called with `cacheLock` held.
+   */
+  private func insertBrick(_ index: Int, data: [UInt8]) {
+    guard let slot = brickSlots[index] ?? slotOrder.leastRecentlyUsed else { return }
+    if slotBricks[slot] != index {
+      if slotBricks[slot] >= 0 {
+        brickSlots[slotBricks[slot]] = nil
+      }
+      slotBricks[slot] = index
+      brickSlots[index] = slot
+    }
+    slotData[slot] = data
+    slotOrder.touch(slot)
+  }
+
+  /**
+   Returns the decoded brick with the given index, decoding it on a cache miss.
+   Must be called with `cacheLock` held.
+   */
+  private func brick(_ index: Int) throws -> [UInt8] {
+    if let slot = brickSlots[index] {
+      slotOrder.touch(slot)
+      return slotData[slot]
+    }
+    let data = try decodeBrick(index, with: readers[0])
+    insertBrick(index, data: data)
+    return data
+  }
+
+  /**
+   Decodes all bricks that intersect the given slices in parallel.
+
+   At most `maxCachedBricks` bricks are decoded, so prefetching never evicts bricks it just
+   decoded.
+
+   - Parameter zRange: The range of slices that will be accessed next.
+   */
+  public override func prefetch(zRange: Range<Int>) {
+    let clamped = zRange.clamped(to: 0..<size.z)
+    guard !clamped.isEmpty else { return }
+
+    let firstBrickZ = clamped.lowerBound / brickStride
+    let lastBrickZ = (clamped.upperBound - 1) / brickStride
+
+    var missing: [Int] = []
+    cacheLock.withLock {
+      for bz in firstBrickZ...lastBrickZ {
+        for by in 0..<brickCount.y {
+          for bx in 0..<brickCount.x {
+            let index = brickIndex(bx, by, bz)
+            if brickSlots[index] == nil { missing.append(index) }
+          }
+        }
+      }
+    }
+    missing = Array(missing.prefix(maxCachedBricks))
+    guard !missing.isEmpty else { return }
+
+    // Reader 0 is reserved for getData, which may run concurrently.
+    let workers = Array(readers.dropFirst())
+    if workers.isEmpty { return }
+
+    DispatchQueue.concurrentPerform(iterations: workers.count) { worker in
+      for i in stride(from: worker, to: missing.count, by: workers.count) {
+        guard let data = try? decodeBrick(missing[i], with: workers[worker]) else { continue }
+        cacheLock.withLock { insertBrick(missing[i], data: data) }
+      }
+    }
+  }
+
+  // MARK: - Data Access
+
+  /**
+   Reads and reinterprets voxel data at the specified coordinate.
+
+   Reads that run past the end of a row continue at the start of the next row, just as they
+   would in a contiguous raw volume.
+
+   - Parameters:
+   - x: X-coordinate of the voxel.
+   - y: Y-coordinate of the voxel.
+   - z: Z-coordinate of the voxel.
+   - count: Number of voxels to read (default is `1`).
+   - Returns: An array of type `T` containing the requested voxel data.
+   - Throws:
+   - `Error.outOfBoundsAccess` if the coordinates are outside the volume.
+   - `Error.incompatibleTypeSize` if the byte count does not align with `T`.
+   - A `BORGVRDataError` if a brick cannot be decoded.
+   */
+  public override func getData<T: FixedWidthInteger>(
+    x: Int, y: Int, z: Int, count: Int = 1
+  ) throws -> [T] {
+    guard (0..<size.x).contains(x),
+          (0..<size.y).contains(y),
+          (0..<size.z).contains(z) else {
+      throw Error.outOfBoundsAccess
+    }
+
+    let byteCount = count * voxelByteSize
+    guard byteCount % MemoryLayout<T>.size == 0 else {
+      throw Error.incompatibleTypeSize
+    }
+    guard calculateIndex(x: x, y: y, z: z) + byteCount <= totalBytes else {
+      throw Error.outOfBoundsAccess
+    }
+
+    var bytes = [UInt8](repeating: 0, count: byteCount)
+    var written = 0
+    var (cx, cy, cz) = (x, y, z)
+
+    try cacheLock.withLock {
+      while written < byteCount {
+        let bx = cx / brickStride
+        let by = cy / brickStride
+        let bz = cz / brickStride
+        let lx = cx - bx * brickStride + overlap
+        let ly = cy - by * brickStride + overlap
+        let lz = cz - bz * brickStride + overlap
+
+        // Copy the part of the row that lies inside this brick.
+        let run = min((byteCount - written) / voxelByteSize,
+                      min(brickStride - (lx - overlap), size.x - cx))
+        let data = try brick(brickIndex(bx, by, bz))
+        let source = ((lz * brickSize + ly) * brickSize + lx) * voxelByteSize
+        bytes.withUnsafeMutableBytes { target in
+          data.withUnsafeBytes { brickBytes in
+            target.baseAddress!.advanced(by: written)
+              .copyMemory(from: brickBytes.baseAddress!.advanced(by: source),
+                          byteCount: run * voxelByteSize)
+          }
+        }
+        written += run * voxelByteSize
+
+        cx += run
+        if cx == size.x {
+          cx = 0
+          cy += 1
+          if cy == size.y {
+            cy = 0
+            cz += 1
+          }
+        }
+      }
+    }
+
+    return bytes.withUnsafeBytes { Array($0.bindMemory(to: T.self)) }
+  }
+
+  /**
+   Bricked volumes are read-only; this method always throws.
+
+   - Throws: `Error.readOnlyAccessViolation`.
+   */
+  public override func setData<T: FixedWidthInteger>(
+    x: Int, y: Int, z: Int, data: [T], count: Int = 1
+  ) throws {
+    throw Error.readOnlyAccessViolation
+  }
+
+  // MARK: - CustomStringConvertible
+
+  /// A string representation including the source brick layout.
+  public override var description: String {
+    "BrickedVolumeAccessor(size: \(size), bricks: \(brickCount), " +
+    "brickSize: \(brickSize), overlap: \(overlap))"
+  }
+}
+
+// MARK: - SlotOrder
+
+/**
+ The least-recently-used order of the brick cache slots, linked through two index arrays so
+ that finding the oldest slot and marking a slot as used are both O(1).
+ */
+private struct SlotOrder {
+  /// The previous (less recently used) slot of each slot, or -1.
+  private var previous: [Int]
+  /// The next (more recently used) slot of each slot, or -1.
+  private var next: [Int]
+  /// The least recently used slot, or -1 if there are no slots.
+  private var head = -1
+  /// The most recently used slot, or -1 if there are no slots.
+  private var tail = -1
+
+  /**
+   Initializes the order with all slots, in slot order.
+
+   - Parameter slotCount: The number of cache slots.
+   */
+  init(slotCount: Int) {
+    previous = [Int](repeating: -1, count: slotCount)
+    next = [Int](repeating: -1, count: slotCount)
+    for slot in 0..<slotCount {
+      append(slot)
+    }
+  }
+
+  /// The slot to reuse next, or `nil` if there are no slots.
+  var leastRecentlyUsed: Int? {
+    head >= 0 ? head : nil
+  }
+
+  /**
+   Marks a slot as used, so it is reused after all other slots.
+
+   - Parameter slot: The slot index.
+   */
+  mutating func touch(_ slot: Int) {
+    guard slot != tail else { return }
+    let p = previous[slot]
+    let n = next[slot]
+    if p >= 0 { next[p] = n } else { head = n }
+    if n >= 0 { previous[n] = p } else { tail = p }
+    append(slot)
+  }
+
+  private mutating func append(_ slot: Int) {
+    previous[slot] = tail
+    next[slot] = -1
+    if tail >= 0 { next[tail] = slot } else { head = slot }
+    tail = slot
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-
+ Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -676,6 +676,9 @@ public class BrickedVolumeReorganizer {
     var uncompressedBrickCounter = 0
 
     for z in stride(from: 0, to: source.size.z, by: bStride) {
+      // Let the source load the slab covered by this row of bricks ahead of time.
+      source.prefetch(zRange: max(0, z - overlap)..<min(source.size.z, z - overlap + brickSize))
+
       for y in stride(from: 0, to: source.size.y, by: bStride) {
         for x in stride(from: 0, to: source.size.x, by: bStride) {
           let isBoundary = isBoundaryBrick(volumeSize: source.size, x: x, y: y, z: z)
@@ -178,6 +178,25 @@ public final class MemoryMappedFile {
     }
   }
 
+  /**
+   Synchronizes modifications in a byte range of the mapped memory back to the file.
+
+   The range is widened to page boundaries as required by msync.
+
+   - Parameter range: The byte range, relative to the start of the file.
+   - Throws: A `MemoryMappedFile.Error.msyncFailed` if the msync call fails.
+   */
+  public func sync(range: Range<Int>) throws {
+    guard !isReadOnly, !range.isEmpty else { return }
+    let pageSize = Int(getpagesize())
+    let start = max(0, range.lowerBound) / pageSize * pageSize
+    let end = min(Int(fileSize), range.upperBound)
+    guard start < end else { return }
+    if msync(mappedMemory.advanced(by: start), end - start, MS_SYNC) != 0 {
+      throw Error.msyncFailed
+    }
+  }
+
   /**
    Closes the memory-mapped file by unmapping the memory and closing the file descriptor.
 
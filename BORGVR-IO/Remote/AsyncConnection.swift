@@ -0,0 +1,594 @@
+import Foundation
+import Network
+import Synchronization
+
+// MARK: - Transports
+
+/**
+ A bidirectional byte stream that `AsyncConnection` reads from and writes to.
+
+ The production transport wraps an `NWConnection`; `SocketTransport` wraps a plain socket
+ and can be created as a connected local pair, so the protocol code can be exercised
+ without a server.
+ */
+protocol ByteStreamTransport: AnyObject {
+  /// Establishes the stream. Returns once it is ready for I/O.
+  func start() async throws
+  /// Writes all bytes of `data`.
+  func send(_ data: Data) async throws
+  /**
+   Reads up to `maximumLength` bytes, waiting until at least one byte is available.
+
+   - Returns: The bytes read, or empty data if the peer closed the stream.
+   */
+  func receive(maximumLength: Int) async throws -> Data
+  /// Tears the stream down. Pending and future operations fail.
+  func cancel()
+  /// Returns a fresh, unstarted transport to the same endpoint, or `nil` if not possible.
+  func makeReplacement() -> ByteStreamTransport?
+}
+
+/**
+ A transport over an `NWConnection`.
+
+ All operations bridge the callback API with continuations. Cancelling the calling task
+ cancels the connection, since a half-finished read or write leaves the stream in an
+ unknown state.
+ */
+final class NWConnectionTransport: ByteStreamTransport {
+  private let connection: NWConnection
+  private let queue = DispatchQueue(label: "NWConnectionTransport")
+  private let logger: LoggerBase?
+
+  init(connection: NWConnection, logger: LoggerBase? = nil) {
+    self.connection = connection
+    self.logger = logger
+  }
+
+  convenience init(host: String, port: UInt16, logger: LoggerBase? = nil) {
+    self.init(connection: NWConnection(host: NWEndpoint.Host(host),
+                                       port: NWEndpoint.Port(rawValue: port)!,
+                                       using: .tcp),
+              logger: logger)
+  }
+
+  func start() async throws {
+    let lock = NSLock()
+    var resumed = false
+    let logger = self.logger
+
+    try await withTaskCancellationHandler {
+      try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+        func resume(_ result: Result<Void, Error>) {
+          let first = lock.withLock {
+            defer { resumed = true }
+            return !resumed
+          }
+          if first { continuation.resume(with: result) }
+        }
+
+        connection.stateUpdateHandler = { state in
+          switch state {
+            case .ready:
+              logger?.dev("Connected to server.")
+              resume(.success(()))
+            case .failed(let error):
+              logger?.error("Connection failed: \(error)")
+              resume(.failure(BORGVRRemoteDataManagerError.connectionFailed(reason: "\(error)")))
+            case .waiting(let error):
+              logger?.warning("Connection waiting: \(error)")
+              resume(.failure(BORGVRRemoteDataManagerError.connectionFailed(reason: "\(error)")))
+            case .cancelled:
+              resume(.failure(CancellationError()))
+            case .preparing:
+              logger?.dev("Preparing connection...")
+            default:
+              break
+          }
+        }
+        connection.start(queue: queue)
+      }
+    } onCancel: {
+      self.connection.cancel()
+    }
+  }
+
+  func send(_ data: Data) async throws {
+    try await withTaskCancellationHandler {
+      try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+        connection.send(content: data, completion: .contentProcessed({ error in
+          if let error = error {
+            continuation.resume(throwing: BORGVRRemoteDataManagerError.sendFailed(error))
+          } else {
+            continuation.resume()
+          }
+        }))
+      }
+    } onCancel: {
+      self.connection.cancel()
+    }
+  }
+
+  func receive(maximumLength: Int) async throws -> Data {
+    try await withTaskCancellationHandler {
+      try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Data, Error>) in
+        connection.receive(minimumIncompleteLength: 1,
+                           maximumLength: maximumLength) { data, _, isComplete, error in
+          if let data = data, !data.isEmpty {
+            continuation.resume(returning: data)
+          } else if let error = error {
+            continuation.resume(throwing: BORGVRRemoteDataManagerError.receiveFailed(
+              reason: error.localizedDescription))
+          } else if isComplete {
+            continuation.resume(returning: Data())
+          } else {
+            continuation.resume(throwing: BORGVRRemoteDataManagerError.receiveFailed(
+              reason: "No data received"))
+          }
+        }
+      }
+    } onCancel: {
+      self.connection.cancel()
+    }
+  }
+
+  func cancel() {
+    connection.cancel()
+  }
+
+  func makeReplacement() -> ByteStreamTransport? {
+    guard case let .hostPort(host, port) = connection.endpoint else { return nil }
+    return NWConnectionTransport(connection: NWConnection(host: host, port: port, using: .tcp),
+                                 logger: logger)
+  }
+}
+
+/**
+ A transport over a connected stream socket, for example one end of a local socket pair.
+
+ Reads and writes block on their own serial queues; cancelling shuts the socket down,
+ which wakes a blocked read.
+ */
+final class SocketTransport: ByteStreamTransport {
+  private let fileDescriptor: Int32
+  private let readQueue = DispatchQueue(label: "SocketTransport.read")
+  private let writeQueue = DispatchQueue(label: "SocketTransport.write")
+
+  /**
+   Takes ownership of a connected stream socket.
+
+   - Parameter fileDescriptor: The socket, closed when the transport is released.
+   */
+  init(fileDescriptor: Int32) {
+    self.fileDescriptor = fileDescriptor
+    var on: Int32 = 1
+    setsockopt(fileDescriptor, SOL_SOCKET, SO_NOSIGPIPE, &on, socklen_t(MemoryLayout<Int32>.size))
+  }
+
+  deinit {
+    close(fileDescriptor)
+  }
+
+  /**
+   Creates two connected transports, e.g. a client and a server stand-in.
+
+   - Throws: `BORGVRRemoteDataManagerError.connectionFailed` if the sockets cannot be created.
+   */
+  static func makePair() throws -> (SocketTransport, SocketTransport) {
+    var descriptors: [Int32] = [0, 0]
+    guard socketpair(AF_UNIX, SOCK_STREAM, 0, &descriptors) == 0 else {
+      throw BORGVRRemoteDataManagerError.connectionFailed(reason: String(cString: strerror(errno)))
+    }
+    return (SocketTransport(fileDescriptor: descriptors[0]),
+            SocketTransport(fileDescriptor: descriptors[1]))
+  }
+
+  func start() async throws {}
+
+  func send(_ data: Data) async throws {
+    try await withTaskCancellationHandler {
+      try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+        writeQueue.async { [fileDescriptor] in
+          let errorCode: Int32 = data.withUnsafeBytes { bytes in
+            var offset = 0
+            while offset < bytes.count {
+              let written = write(fileDescriptor, bytes.baseAddress! + offset, bytes.count - offset)
+              if written < 0 {
+                if errno == EINTR { continue }
+                return errno
+              }
+              offset += written
+            }
+            return 0
+          }
+          if errorCode == 0 {
+            continuation.resume()
+          } else {
+            continuation.resume(throwing: BORGVRRemoteDataManagerError.sendFailed(
+              POSIXError(POSIXErrorCode(rawValue: errorCode) ?? .EIO)))
+          }
+        }
+      }
+    } onCancel: {
+      self.cancel()
+    }
+  }
+
+  func receive(maximumLength: Int) async throws -> Data {
+    try await withTaskCancellationHandler {
+      try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Data, Error>) in
+        readQueue.async { [fileDescriptor] in
+          var data = Data(count: maximumLength)
+          var bytesRead = 0
+          repeat {
+            bytesRead = data.withUnsafeMutableBytes { read(fileDescriptor, $0.baseAddress!, maximumLength) }
+          } while bytesRead < 0 && errno == EINTR
+          if bytesRead < 0 {
+            continuation.resume(throwing: BORGVRRemoteDataManagerError.receiveFailed(
+              reason: String(cString: strerror(errno))))
+          } else {
+            data.count = bytesRead
+            continuation.resume(returning: data)
+          }
+        }
+      }
+    } onCancel: {
+      self.cancel()
+    }
+  }
+
+  func cancel() {
+    shutdown(fileDescriptor, SHUT_RDWR)
+  }
+
+  func makeReplacement() -> ByteStreamTransport? {
+    nil
+  }
+}
+
+// MARK: - Connection
+
+/**
+ An async connection speaking the BorgVR remote protocol.
+
+ All reads go through one buffered reader that pulls large chunks from the transport and
+ serves text responses, size-prefixed binary responses and version 2 frames from that
+ buffer, so a response spread over many packets costs a few receive calls instead of one per
+ field. Every operation has a timeout that limits how long it may go without progress; it is
+ implemented by cancelling the pending operation, which closes the connection, because the
+ stream position is unknown afterwards.
+
+ Reads must not be issued concurrently. Sends may be issued at any time.
+
+ Existing synchronous code uses `AsyncConnection.blocking`, which must not be called from
+ within a Swift concurrency task.
+ */
+actor AsyncConnection {
+  /// The preferred number of bytes pulled from the transport per receive call.
+  static let chunkSize = 256 * 1024
+
+  /// The default timeout for sends and short text responses, in seconds.
+  static let defaultTimeout: Double = 5
+  /// The default timeout until the first byte of a binary response arrives, in seconds.
+  static let responseTimeout: Double = 15
+  /// The default timeout for the remaining bytes of a large payload, in seconds.
+  static let payloadTimeout: Double = 50
+
+  /// The underlying byte stream.
+  nonisolated let transport: ByteStreamTransport
+  /// An optional logger for debug and error messages.
+  private let logger: LoggerBase?
+
+  /// Received bytes that have not been consumed yet, starting at `readIndex`.
+  private var buffer = Data()
+  private var readIndex = 0
+
+  /// The number of bytes buffered but not consumed.
+  private var available: Int { buffer.count - readIndex }
+
+  init(transport: ByteStreamTransport, logger: LoggerBase? = nil) {
+    self.transport = transport
+    self.logger = logger
+  }
+
+  /**
+   Opens a TCP connection to a server.
+
+   - Parameters:
+   - host: The host name or IP address.
+   - port: The port number.
+   - timeout: The connection timeout in seconds.
+   - logger: An optional logger.
+   - Returns: The ready connection.
+   - Throws: A BORGVRRemoteDataManagerError if connecting fails or times out.
+   */
+  static func connect(host: String, port: UInt16, timeout: Double,
+                      logger: LoggerBase? = nil) async throws -> AsyncConnection {
+    let connection = AsyncConnection(
+      transport: NWConnectionTransport(host: host, port: port, logger: logger),
+      logger: logger)
+    try await connection.start(timeout: timeout)
+    return connection
+  }
+
+  /**
+   Starts the transport.
+
+   - Parameter timeout: The connection timeout in seconds.
+   - Throws: A BORGVRRemoteDataManagerError if connecting fails or times out.
+   */
+  func start(timeout: Double) async throws {
+    let transport = self.transport
+    try await AsyncConnection.withTimeout(timeout) {
+      try await transport.start()
+    }
+  }
+
+  /**
+   Opens a new connection to the same endpoint, e.g. after this one broke.
+
+   - Parameter timeout: The connection timeout in seconds.
+   - Returns: The ready connection.
+   - Throws: A BORGVRRemoteDataManagerError if the transport cannot be replaced or connecting fails.
+   */
+  nonisolated func reconnected(timeout: Double) async throws -> AsyncConnection {
+    guard let replacement = transport.makeReplacement() else {
+      throw BORGVRRemoteDataManagerError.connectionFailed(reason: "Endpoint cannot be reconnected")
+    }
+    let connection = AsyncConnection(transport: replacement, logger: logger)
+    try await connection.start(timeout: timeout)
+    return connection
+  }
+
+  /// Closes the connection. Pending operations fail.
+  nonisolated func cancel() {
+    transport.cancel()
+  }
+
+  // MARK: - Sending
+
+  /**
+   Sends raw bytes.
+
+   - Parameters:
+   - data: The bytes to send.
+   - timeout: The timeout in seconds.
+   - Throws: A BORGVRRemoteDataManagerError if sending fails or times out.
+   */
+  nonisolated func send(_ data: Data, timeout: Double = AsyncConnection.defaultTimeout) async throws {
+    let transport = self.transport
+    try await AsyncConnection.withTimeout(timeout) {
+      try await transport.send(data)
+    }
+  }
+
+  /**
+   Sends a newline-terminated text command.
+
+   - Parameters:
+   - command: The command, with or without the terminating newline.
+   - timeout: The timeout in seconds.
+   - Throws: A BORGVRRemoteDataManagerError if sending fails or times out.
+   */
+  nonisolated func sendCommand(_ command: String,
+                               timeout: Double = AsyncConnection.defaultTimeout) async throws {
+    let terminatedCommand = command.hasSuffix("\n") ? command : command + "\n"
+    try await send(Data(terminatedCommand.utf8), timeout: timeout)
+  }
+
+  /**
+   Sends bytes without waiting for them to be processed, for callers that must not block.
+
+   - Parameters:
+   - data: The bytes to send.
+   - completion: Called with the error if sending fails.
+   */
+  nonisolated func sendDetached(_ data: Data, completion: ((Error) -> Void)? = nil) {
+    Task {
+      do {
+        try await send(data)
+      } catch {
+        completion?(error)
+      }
+    }
+  }
+
+  // MARK: - Receiving
+
+  /**
+   Receives exactly `count` bytes.
+
+   - Parameters:
+   - count: The number of bytes to receive.
+   - timeout: The maximum time in seconds to wait for more data.
+   - Returns: The received bytes.
+   - Throws: A BORGVRRemoteDataManagerError if reception fails, times out or the peer closes.
+   */
+  func receiveExactly(_ count: Int, timeout: Double = AsyncConnection.payloadTimeout) async throws -> Data {
+    while available < count {
+      try await fill(atLeast: count - available, timeout: timeout)
+    }
+    return consume(count)
+  }
+
+  /**
+   Receives a text response terminated by `terminator`.
+
+   - Parameters:
+   - terminator: The end marker of the response.
+   - timeout: The maximum time in seconds to wait for more data.
+   - Returns: The response including its first line break, without the rest of the terminator.
+   - Throws: A BORGVRRemoteDataManagerError if reception fails, times out or the peer closes.
+   */
+  func receiveText(terminator: String = "\n\n",
+                   timeout: Double = AsyncConnection.defaultTimeout) async throws -> String {
+    let marker = Data(terminator.utf8)
+    var searchStart = readIndex
+    while true {
+      if let range = buffer.range(of: marker, in: searchStart..<buffer.count) {
+        let text = consume(range.lowerBound - readIndex + 1)
+        _ = consume(marker.count - 1)
+        return String(decoding: text, as: UTF8.self)
+      }
+      searchStart = max(readIndex, buffer.count - marker.count + 1)
+      let offset = searchStart - readIndex
+      try await fill(atLeast: 1, timeout: timeout)
+      searchStart = readIndex + offset
+    }
+  }
+
+  /**
+   Receives a version 1 binary response: a 4-byte size prefix followed by the payload.
+
+   - Parameters:
+   - timeout: The maximum time in seconds to wait for the response to start.
+   - payloadTimeout: The maximum time in seconds to wait for more payload data.
+   - Returns: The payload.
+   - Throws: A BORGVRRemoteDataManagerError if reception fails or times out.
+   */
+  func receiveBinaryResponse(timeout: Double = AsyncConnection.responseTimeout,
+                             payloadTimeout: Double = AsyncConnection.payloadTimeout) async throws -> Data {
+    let sizeData = try await receiveExactly(4, timeout: timeout)
+    let size = sizeData.withUnsafeBytes { $0.loadUnaligned(as: UInt32.self) }
+    return try await receiveExactly(Int(UInt32(littleEndian: size)), timeout: payloadTimeout)
+  }
+
+  /**
+   Receives a single version 2 frame.
+
+   - Parameters:
+   - timeout: The maximum time in seconds to wait for the frame to start.
+   - payloadTimeout: The maximum time in seconds to wait for more payload data.
+   - Returns: The frame header and its payload.
+   - Throws: A network or protocol error if reception fails or the frame is malformed.
+   */
+  func receiveFrame(timeout: Double = AsyncConnection.responseTimeout,
+                    payloadTimeout: Double = AsyncConnection.payloadTimeout) async throws
+  -> (WireProtocol.FrameHeader, Data) {
+    let header = try WireProtocol.FrameHeader(
+      from: try await receiveExactly(WireProtocol.FrameHeader.size, timeout: timeout))
+    let payload = try await receiveExactly(header.payloadLength, timeout: payloadTimeout)
+    return (header, payload)
+  }
+
+  /// Reads at least one chunk from the transport into the buffer.
+  private func fill(atLeast count: Int, timeout: Double) async throws {
+    // Drop consumed bytes before growing the buffer.
+    if readIndex > 0 && readIndex >= buffer.count / 2 {
+      buffer.removeSubrange(0..<readIndex)
+      readIndex = 0
+    }
+    let transport = self.transport
+    let maximumLength = max(AsyncConnection.chunkSize, count)
+    let chunk = try await AsyncConnection.withTimeout(timeout) {
+      try await transport.receive(maximumLength: maximumLength)
+    }
+    if chunk.isEmpty {
+      throw BORGVRRemoteDataManagerError.receiveFailed(reason: "Connection closed by peer")
+    }
+    buffer.append(chunk)
+  }
+
+  /// Removes `count` buffered bytes and returns them.
+  private func consume(_ count: Int) -> Data {
+    let result = buffer.subdata(in: readIndex..<readIndex + count)
+    readIndex += count
+    if readIndex == buffer.count {
+      buffer = Data()
+      readIndex = 0
+    }
+    return result
+  }
+
+  // MARK: - Helpers
+
+  /**
+   Runs an operation and cancels it if it does not finish in time.
+
+   - Parameters:
+   - seconds: The timeout in seconds.
+   - operation: The operation, which must react to cancellation.
+   - Returns: The result of the operation.
+   - Throws: `BORGVRRemoteDataManagerError.timeout` or the error of the operation.
+   */
+  static func withTimeout<T>(_ seconds: Double,
+                             operation: @escaping () async throws -> T) async throws -> T {
+    try await withThrowingTaskGroup(of: T.self) { group in
+      group.addTask {
+        try await operation()
+      }
+      group.addTask {
+        try await Task.sleep(nanoseconds: UInt64(seconds * 1_000_000_000))
+        throw BORGVRRemoteDataManagerError.timeout(seconds: seconds)
+      }
+      defer { group.cancelAll() }
+      return try await group.next()!
+    }
+  }
+
+  /**
+   Runs an async operation and blocks the calling thread until it finishes. This is the bridge
+   for the synchronous API; it must not be called from within a Swift concurrency task.
+
+   - Parameter operation: The operation to run.
+   - Returns: The result of the operation.
+   - Throws: The error of the operation.
+   */
+  static func blocking<T>(_ operation: @escaping @Sendable () async throws -> T) throws -> T {
+    let semaphore = DispatchSemaphore(value: 0)
+    let box = BlockingResult<T>()
+    Task.detached {
+      do {
+        box.store(.success(try await operation()))
+      } catch {
+        box.store(.failure(error))
+      }
+      semaphore.signal()
+    }
+    semaphore.wait()
+    return try box.take().get()
+  }
+}
+
+/**
+ Hands the result of the task started by `AsyncConnection.blocking` to the waiting thread.
+ */
+private final class BlockingResult<T>: Sendable {
+  private let result = Mutex<Result<T, Error>?>(nil)
+
+  /// Stores the result; called once by the task.
+  func store(_ value: sending Result<T, Error>) {
+    result.withLock { $0 = value }
+  }
+
+  /// Takes the result; called once by the waiting thread after the task has stored it.
+  func take() -> sending Result<T, Error> {
+    result.withLock { stored in
+      guard let value = stored.take() else {
+        preconditionFailure("AsyncConnection.blocking finished without a result")
+      }
+      return value
+    }
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
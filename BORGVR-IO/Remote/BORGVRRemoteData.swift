@@ -85,13 +85,19 @@ class BORGVRRemoteData: BORGVRDatasetProtocol {
    If no targetFilename is provided, a remote data source is used.
 
    - Parameters:
-   - connection: The NWConnection to the remote server.
+   - connection: The connection to the remote server.
    - datasetID: The identifier of the dataset.
+   - maxBricksPerGetRequest: The maximum number of bricks per request accepted by the server.
+   - protocolVersion: The negotiated wire protocol version, see `WireProtocol`.
+   - prefetchConnections: The number of additional connections used to cache the dataset,
+   or `nil` for an automatic choice.
    - targetFilename: An optional file path for a local data source.
    - Throws: An error if initializing the underlying data source fails.
    */
-  init(connection: NWConnection, datasetID: String,
+  init(connection: AsyncConnection, datasetID: String,
        maxBricksPerGetRequest: Int,
+       protocolVersion: Int = 1,
+       prefetchConnections: Int? = nil,
        targetFilename: String?,
        logger:LoggerBase?,
        notifier:NotificationBase?) throws {
@@ -112,6 +118,8 @@ class BORGVRRemoteData: BORGVRDatasetProtocol {
             connection: connection,
             datasetID: datasetID,
             maxBricksPerGetRequest: maxBricksPerGetRequest,
+            protocolVersion: protocolVersion,
+            prefetchConnections: prefetchConnections,
             filename: targetFilename,
             logger:logger,
             notifier: notifier
@@ -123,6 +131,8 @@ class BORGVRRemoteData: BORGVRDatasetProtocol {
           connection: connection,
           datasetID: datasetID,
           maxBricksPerGetRequest: maxBricksPerGetRequest,
+          protocolVersion: protocolVersion,
+          prefetchConnections: prefetchConnections,
           filename: targetFilename,
           logger:logger,
           notifier: notifier)
@@ -132,6 +142,7 @@ class BORGVRRemoteData: BORGVRDatasetProtocol {
       self.brickDataSource = try RemoteDataSource(
         connection: connection,
         datasetID: datasetID,
+        protocolVersion: protocolVersion,
         logger:logger)
     }
     logger?.dev("BORGVRRemoteData initialized")
@@ -156,6 +167,12 @@ class BORGVRRemoteData: BORGVRDatasetProtocol {
     try self.brickDataSource.getBrick(index: index, outputBuffer: outputBuffer)
   }
 
+  /// Local and cached bricks are decoded without shared buffers; a purely remote source
+  /// fetches one brick at a time.
+  var supportsConcurrentGetBrick: Bool {
+    sourceType != .remote
+  }
+
   /**
    Retrieves the first brick and writes its data into the provided output buffer.
    In contrast to getBrick, this call is always synchronous.
@@ -196,6 +213,25 @@ class BORGVRRemoteData: BORGVRDatasetProtocol {
     }
   }
 
+  /// Whether the dataset is still being cached, so a prefetch plan would be used.
+  var acceptsPrefetchPlan: Bool {
+    guard let cachingSource = brickDataSource as? CachingRemoteDataSource else {
+      return false
+    }
+    return !cachingSource.cachingComplete
+  }
+
+  /**
+   Sets the bricks that are prefetched next, see `PrefetchPlanner`.
+
+   - Parameter indices: The brick indices, most urgent first.
+   */
+  func setPrefetchPlan(_ indices: [Int]) {
+    if let cachingSource = brickDataSource as? CachingRemoteDataSource {
+      cachingSource.setPrefetchPlan(indices)
+    }
+  }
+
 }
 
 /*
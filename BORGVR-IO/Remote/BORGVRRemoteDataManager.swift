@@ -40,13 +40,14 @@ enum BORGVRRemoteDataManagerError: Error {
 /**
  A manager for remote BorgVR dataset operations via a TCP connection.
 
- This class handles the network connection using NWConnection, and allows the user
+ This class handles the network connection using an AsyncConnection, and allows the user
  to request a dataset list, open a dataset on a new connection, and send/receive
- commands and binary responses.
+ commands and binary responses. Every operation is available as an async function; the
+ synchronous variants block the calling thread and remain for existing callers.
  */
 class BORGVRRemoteDataManager {
-  /// The underlying NWConnection for this manager.
-  private let connection: NWConnection
+  /// The underlying connection for this manager.
+  private let connection: AsyncConnection
   /// The local list of datasets.
   private var datasets: [(id: String, description: String)] = []
   /// An optional logger for logging messages.
@@ -60,6 +61,8 @@ class BORGVRRemoteDataManager {
 
   private static let protocolVersionName : String = "1"
   private(set) var maxBricksPerGetRequest : Int = 1
+  /// The highest wire protocol version both sides speak, see `WireProtocol`.
+  private(set) var protocolVersion : Int = 1
   /**
    Initializes a new instance of the remote data manager.
 
@@ -78,9 +81,9 @@ class BORGVRRemoteDataManager {
     self.notifier = notifier
     self.host = host
     self.port = port
-    self.connection = NWConnection(host: NWEndpoint.Host(host),
-                                   port: NWEndpoint.Port(rawValue: port)!,
-                                   using: .tcp)
+    self.connection = AsyncConnection(
+      transport: NWConnectionTransport(host: host, port: port, logger: logger),
+      logger: logger)
     logger?.dev("BORGVRRemoteDataManager initialized")
   }
 
@@ -96,62 +99,23 @@ class BORGVRRemoteDataManager {
    - Throws: A BORGVRRemoteDataManagerError if the connection cannot be
    established within the timeout period.
    */
-  func connect(timeout: Double) throws {
-    try BORGVRRemoteDataManager.connect(connection: connection,
-                                        timeout: timeout, logger: logger)
-    try getInfo()
+  func connect(timeout: Double) async throws {
+    try await connection.start(timeout: timeout)
+    try await getInfo()
   }
 
   /**
-   A helper method that performs the connection process on a given NWConnection.
-
-   - Parameters:
-   - connection: The NWConnection to establish.
-   - timeout: The timeout period in seconds.
-   - logger: An optional logger to log connection status.
-   - Throws: A BORGVRRemoteDataManagerError in case of timeout or failure.
+   Blocking variant of `connect(timeout:) async`.
    */
-  static func connect(connection: NWConnection, timeout: Double,
-                      logger: LoggerBase? = nil) throws {
-    let semaphore = DispatchSemaphore(value: 0)
-    var success = false
-
-    connection.stateUpdateHandler = { state in
-      switch state {
-        case .ready:
-          logger?.dev("Connected to server.")
-          success = true
-          semaphore.signal()
-        case .failed(let error):
-          logger?.error("Connection failed: \(error)")
-          semaphore.signal()
-        case .waiting(let error):
-          logger?.warning("Connection waiting: \(error)")
-          semaphore.signal()
-        case .preparing:
-          logger?.dev("Preparing connection...")
-        default:
-          break
-      }
-    }
-    connection.start(queue: .global())
-
-    let timeoutResult = semaphore.wait(timeout: .now() + timeout)
-    if timeoutResult == .timedOut {
-      connection.cancel()
-      throw BORGVRRemoteDataManagerError.timeout(seconds: timeout)
-    }
-
-    if !success {
-      throw BORGVRRemoteDataManagerError.connectionFailed(
-        reason: "Failed to connect to server."
-      )
+  func connect(timeout: Double) throws {
+    try AsyncConnection.blocking {
+      try await self.connect(timeout: timeout)
     }
   }
-  
-  private func getInfo() throws {
-    try sendCommand("INFO")
-    let response = try receiveTextResponse()
+
+  private func getInfo() async throws {
+    try await connection.sendCommand("INFO")
+    let response = try await connection.receiveText()
 
     let data = KeyValuePairHandler(text:response)
 
@@ -168,6 +132,13 @@ class BORGVRRemoteDataManager {
     } else {
       throw BORGVRRemoteDataManagerError.invalidResponse(reason: "Could not parse brick request limit from server response.")
     }
+
+    // Servers that predate the binary protocol do not send the key.
+    let serverProtocols = (data[WireProtocol.infoKey] ?? "1")
+      .split(separator: ",")
+      .compactMap { Int($0.trimmingCharacters(in: .whitespaces)) }
+    self.protocolVersion = serverProtocols.contains(WireProtocol.version) ? WireProtocol.version : 1
+    logger?.dev("Using wire protocol version \(protocolVersion)")
   }
     /**
    Requests the dataset list from the remote server.
@@ -175,9 +146,9 @@ class BORGVRRemoteDataManager {
    - Returns: An array of tuples containing dataset id and description.
    - Throws: An error if sending or receiving the command fails.
    */
-  func requestDatasetList() throws -> [(id: String, description: String)] {
-    try sendCommand("LIST")
-    let response = try receiveTextResponse()
+  func requestDatasetList() async throws -> [(id: String, description: String)] {
+    try await connection.sendCommand("LIST")
+    let response = try await connection.receiveText()
 
     let lines = response.split(separator: "\n")
     self.datasets = try lines.compactMap { line in
@@ -198,116 +169,45 @@ class BORGVRRemoteDataManager {
     return self.datasets
   }
 
+  /**
+   Blocking variant of `requestDatasetList() async`.
+   */
+  func requestDatasetList() throws -> [(id: String, description: String)] {
+    try AsyncConnection.blocking {
+      try await self.requestDatasetList()
+    }
+  }
+
   /**
    Opens a dataset on a new connection.
 
-   A new NWConnection is created and used to open the dataset.
+   A new connection is created and used to open the dataset.
 
    - Parameters:
    - datasetID: The dataset identifier.
    - timeout: The timeout for establishing the connection.
    - localCacheFilename: An optional local cache file name.
+   - prefetchConnections: The number of additional connections used to fill the local cache,
+   or `nil` for an automatic choice.
    - Returns: A BORGVRRemoteData instance representing the open dataset.
    - Throws: An error if the connection fails.
    */
   func openDataset(datasetID: String, timeout: Double,
-                   localCacheFilename: String? = nil) throws -> BORGVRRemoteData  {
-    let datasetConnection = NWConnection(
-      host: NWEndpoint.Host(host),
-      port: NWEndpoint.Port(rawValue: port)!,
-      using: .tcp
-    )
-
-    try BORGVRRemoteDataManager.connect(connection: datasetConnection,
+                   localCacheFilename: String? = nil,
+                   prefetchConnections: Int? = nil) throws -> BORGVRRemoteData  {
+    let datasetConnection = try AsyncConnection.blocking { [host, port, logger] in
+      try await AsyncConnection.connect(host: host, port: port,
                                         timeout: timeout, logger: logger)
+    }
     return try BORGVRRemoteData(connection: datasetConnection,
                                 datasetID: datasetID,
                                 maxBricksPerGetRequest: maxBricksPerGetRequest,
+                                protocolVersion: protocolVersion,
+                                prefetchConnections: prefetchConnections,
                                 targetFilename: localCacheFilename,
                                 logger:logger,
                                 notifier: notifier)
   }
-
-  /**
-   Sends a command string over the connection.
-
-   - Parameter command: The command to send.
-   - Throws: A BORGVRRemoteDataManagerError if sending fails or times out.
-   */
-  private func sendCommand(_ command: String) throws {
-    let semaphore = DispatchSemaphore(value: 0)
-    var sendError: Error?
-
-    let terminatedCommand = command.hasSuffix("\n") ? command : command + "\n"
-    guard let commandData = terminatedCommand.data(using: .utf8) else {
-      throw BORGVRRemoteDataManagerError.sendFailed(
-        NSError(domain: "Encoding", code: 1,
-                userInfo: [NSLocalizedDescriptionKey: "Failed to encode command"])
-      )
-    }
-
-    connection.send(content: commandData,
-                    completion: .contentProcessed({ error in
-      sendError = error
-      semaphore.signal()
-    }))
-
-    let result = semaphore.wait(timeout: .now() + 5)
-    if result == .timedOut {
-      throw BORGVRRemoteDataManagerError.timeout(seconds: 5)
-    }
-    if let error = sendError {
-      throw BORGVRRemoteDataManagerError.sendFailed(error)
-    }
-  }
-
-  /**
-   Receives a textual response from the server.
-
-   This method attempts to read data until a double newline ("\n\n") is encountered.
-
-   - Parameter timeout: The timeout in seconds for the response.
-   - Returns: A string containing the response.
-   - Throws: A BORGVRRemoteDataManagerError if reception times out or fails.
-   */
-  private func receiveTextResponse(timeout: TimeInterval = 5.0) throws -> String {
-    let deadline = Date().addingTimeInterval(timeout)
-    var buffer = Data()
-
-    while Date() < deadline {
-      let semaphore = DispatchSemaphore(value: 0)
-      var chunk: Data?
-      var receiveError: Error?
-
-      connection.receive(minimumIncompleteLength: 1, maximumLength: 4096) { data, _, _, error in
-        chunk = data
-        receiveError = error
-        semaphore.signal()
-      }
-
-      let result = semaphore.wait(timeout: .now() + timeout)
-      if result == .timedOut {
-        throw BORGVRRemoteDataManagerError.timeout(seconds: timeout)
-      }
-
-      if let error = receiveError {
-        throw BORGVRRemoteDataManagerError.receiveFailed(
-          reason: error.localizedDescription
-        )
-      }
-
-      if let data = chunk {
-        buffer.append(data)
-        if let str = String(data: buffer, encoding: .utf8),
-           let range = str.range(of: "\n\n") {
-          let endIndex = str.index(before: range.upperBound)
-          return String(str[..<endIndex])
-        }
-      }
-    }
-
-    throw BORGVRRemoteDataManagerError.timeout(seconds: timeout)
-  }
 }
 
 /*
@@ -0,0 +1,230 @@
+import Foundation
+
+/**
+ A priority queue of brick requests that holds every brick at most once.
+
+ The renderer asks for the same missing brick every frame until it arrives, so a plain list
+ grows with duplicates and serves the oldest requests first. This queue keeps one entry per
+ brick in a binary heap and tracks the heap position of each brick in a dense array, so
+ finding a brick is O(1) and inserting, updating, and removing are O(log n).
+
+ Bricks requested in the most recent generation (see `newGeneration()`) come first, within a
+ generation coarser levels come before finer ones, and otherwise requests are served in the
+ order they arrived. Requesting a queued brick again moves it to the current generation.
+
+ The queue is not thread-safe; callers synchronize access.
+ */
+struct BrickRequestQueue {
+
+  private struct Entry {
+    /// The brick index.
+    let index: Int
+    /// The generation of the latest request for the brick.
+    var generation: Int
+    /// The resolution level of the brick, 0 is the finest.
+    let level: Int
+    /// The arrival order of the first request for the brick.
+    let sequence: Int
+
+    /// Whether this entry is served before `other`.
+    func precedes(_ other: Entry) -> Bool {
+      if generation != other.generation { return generation > other.generation }
+      if level != other.level { return level > other.level }
+      return sequence < other.sequence
+    }
+  }
+
+  /// The binary min-heap of requests, ordered by `Entry.precedes`.
+  private var heap: [Entry] = []
+  /// The heap position of each brick, or -1 if the brick is not queued.
+  private var positions: [Int32]
+  /// The resolution level of each brick.
+  private let levels: [UInt8]
+  /// The arrival counter for new entries.
+  private var nextSequence = 0
+
+  /// The current request generation.
+  private(set) var generation = 0
+
+  /**
+   Initializes an empty queue for the bricks of a dataset.
+
+   - Parameter metadata: The metadata of the dataset, used for the level of each brick.
+   */
+  init(metadata: BORGVRMetaData) {
+    var levels = [UInt8](repeating: 0, count: metadata.brickMetadata.count)
+    for (level, levelMetadata) in metadata.levelMetadata.enumerated() {
+      let bricks = levelMetadata.totalBricks
+      let end = min(levels.count, levelMetadata.prevBricks + bricks.x * bricks.y * bricks.z)
+      if levelMetadata.prevBricks < end {
+        for index in levelMetadata.prevBricks..<end {
+          levels[index] = UInt8(clamping: level)
+        }
+      }
+    }
+    self.init(levels: levels)
+  }
+
+  /**
+   Initializes an empty queue from the level of each brick.
+
+   - Parameter levels: The resolution level of each brick, 0 is the finest.
+   */
+  init(levels: [UInt8]) {
+    self.levels = levels
+    self.positions = [Int32](repeating: -1, count: levels.count)
+    heap.reserveCapacity(min(levels.count, 4096))
+  }
+
+  /// The number of queued bricks.
+  var count: Int { heap.count }
+
+  /// Whether no brick is queued.
+  var isEmpty: Bool { heap.isEmpty }
+
+  /// The brick that `popFirst()` returns next, if any.
+  var first: Int? { heap.first?.index }
+
+  /**
+   Returns whether a brick is queued.
+
+   - Parameter index: The brick index.
+   */
+  func contains(_ index: Int) -> Bool {
+    positions[index] >= 0
+  }
+
+  /**
+   Starts a new generation. Bricks requested from now on are served before all bricks that
+   were requested earlier and not requested again.
+   */
+  mutating func newGeneration() {
+    generation += 1
+  }
+
+  /**
+   Queues a brick in the current generation, or moves it there if it is already queued.
+
+   - Parameter index: The brick index.
+   */
+  mutating func push(_ index: Int) {
+    let position = Int(positions[index])
+    if position >= 0 {
+      if heap[position].generation != generation {
+        heap[position].generation = generation
+        siftUp(position)
+      }
+      return
+    }
+    heap.append(Entry(index: index, generation: generation,
+                      level: Int(levels[index]), sequence: nextSequence))
+    nextSequence += 1
+    positions[index] = Int32(heap.count - 1)
+    siftUp(heap.count - 1)
+  }
+
+  /**
+   Removes and returns the brick with the highest priority.
+
+   - Returns: The brick index, or `nil` if the queue is empty.
+   */
+  @discardableResult
+  mutating func popFirst() -> Int? {
+    guard !heap.isEmpty else { return nil }
+    return remove(at: 0)
+  }
+
+  /**
+   Removes a brick from the queue if it is queued.
+
+   - Parameter index: The brick index.
+   - Returns: `true` if the brick was queued.
+   */
+  @discardableResult
+  mutating func remove(_ index: Int) -> Bool {
+    let position = Int(positions[index])
+    guard position >= 0 else { return false }
+    remove(at: position)
+    return true
+  }
+
+  /**
+   Removes all bricks from the queue.
+   */
+  mutating func removeAll() {
+    for entry in heap {
+      positions[entry.index] = -1
+    }
+    heap.removeAll(keepingCapacity: true)
+  }
+
+  // MARK: - Heap Maintenance
+
+  @discardableResult
+  private mutating func remove(at position: Int) -> Int {
+    let index = heap[position].index
+    positions[index] = -1
+    let last = heap.removeLast()
+    if position < heap.count {
+      heap[position] = last
+      positions[last.index] = Int32(position)
+      siftDown(siftUp(position))
+    }
+    return index
+  }
+
+  @discardableResult
+  private mutating func siftUp(_ start: Int) -> Int {
+    var child = start
+    let entry = heap[child]
+    while child > 0 {
+      let parent = (child - 1) / 2
+      guard entry.precedes(heap[parent]) else { break }
+      heap[child] = heap[parent]
+      positions[heap[child].index] = Int32(child)
+      child = parent
+    }
+    heap[child] = entry
+    positions[entry.index] = Int32(child)
+    return child
+  }
+
+  private mutating func siftDown(_ start: Int) {
+    var parent = start
+    let entry = heap[parent]
+    while true {
+      var child = 2 * parent + 1
+      guard child < heap.count else { break }
+      if child + 1 < heap.count && heap[child + 1].precedes(heap[child]) {
+        child += 1
+      }
+      guard heap[child].precedes(entry) else { break }
+      heap[parent] = heap[child]
+      positions[heap[parent].index] = Int32(parent)
+      parent = child
+    }
+    heap[parent] = entry
+    positions[entry.index] = Int32(parent)
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
@@ -1,4 +1,5 @@
 import Foundation
+import Synchronization
 
 /**
  An enum representing errors that can occur when working with a cache map.
@@ -25,28 +26,34 @@ enum CacheMapError: Error, LocalizedError {
 /**
  A structure representing a cache map that tracks a series of Boolean flags.
 
- The CacheMap stores a fixed number of bits compactly in a byte array, allowing individual bits
- to be set and queried. It also provides methods for loading from and saving to a file, checking
- if a bit is set, finding the first unset bit, determining completeness, and clearing the map.
+ The CacheMap stores a fixed number of bits compactly in 64-bit atomic words, allowing
+ individual bits to be set and queried from any thread without locking. The number of set
+ bits is maintained alongside, and unset bits can be found a word at a time. It also provides
+ methods for loading from and saving to a file, determining completeness, and clearing the
+ map.
+
+ In memory, bit `index` is bit `index % 64` of word `index / 64`. The file format stores
+ bit `index` as bit `7 - index % 8` of byte `index / 8`; loading and saving convert between
+ the two.
  */
-class CacheMap {
+final class CacheMap {
   /// The total number of bits the cache map is designed to track.
-  private(set) var count: Int
-  /// The underlying byte array representing the bit map.
-  private var map: [UInt8]
+  let count: Int
+  /// The number of 64-bit words in `words`.
+  private let wordCount: Int
+  /// The bit map, one atomic word per 64 bits.
+  private let words: UnsafeMutablePointer<Atomic<UInt64>>
+  /// The number of bits that are currently set.
+  private let setBits = Atomic<Int>(0)
+
   /// The number of bits that are currently set.
-  private(set) var setCount: Int = 0
-  /// A serial dispatch queue to protect access to the Cachemap
-  private let queue = DispatchQueue(label: "CachemapQueue")
+  var setCount: Int {
+    setBits.load(ordering: .relaxed)
+  }
 
   /// The ratio of elements that have been cached so far.
   var fillRatio: Double {
-    return queue.sync {
-      if setCount == 0 {
-        return 0.0
-      }
-      return Double(setCount) / Double(count)
-    }
+    count == 0 ? 0.0 : Double(setCount) / Double(count)
   }
 
   /**
@@ -56,9 +63,11 @@ class CacheMap {
    */
   init(count: Int) {
     self.count = count
-    let byteCount = (count + 7) / 8
-    self.map = [UInt8](repeating: 0, count: byteCount)
-    self.setCount = 0
+    self.wordCount = (count + 63) / 64
+    self.words = UnsafeMutablePointer<Atomic<UInt64>>.allocate(capacity: max(1, wordCount))
+    for i in 0..<wordCount {
+      (words + i).initialize(to: Atomic(0))
+    }
   }
 
   /**
@@ -69,38 +78,92 @@ class CacheMap {
    - Parameter url: The URL of the file containing the cache map.
    - Throws: A CacheMapError if the file is too small or the bitmap is incomplete.
    */
-  init(fromFile url: URL) throws {
+  convenience init(fromFile url: URL) throws {
     let data = try Data(contentsOf: url)
     guard data.count >= 8 else {
       throw CacheMapError.tooSmall
     }
 
     // Load the count from the first 8 bytes (stored as a UInt64).
-    self.count = Int(data.prefix(8).withUnsafeBytes { $0.load(as: UInt64.self) })
+    let count = Int(data.prefix(8).withUnsafeBytes { $0.loadUnaligned(as: UInt64.self) })
 
     let byteCount = (count + 7) / 8
     guard data.count >= 8 + byteCount else {
       throw CacheMapError.incompleteBitmap(expected: 8 + byteCount, actual: data.count)
     }
 
-    self.map = Array(data[8..<8 + byteCount])
-    self.setCount = map.reduce(0) { $0 + $1.nonzeroBitCount }
+    self.init(count: count)
+    let bytes = [UInt8](data[8..<8 + byteCount])
+    var total = 0
+    for w in 0..<wordCount {
+      var word: UInt64 = 0
+      for k in 0..<8 where w * 8 + k < byteCount {
+        word |= UInt64(CacheMap.reversedBits(bytes[w * 8 + k])) << (8 * k)
+      }
+      word &= validMask(ofWord: w)
+      words[w].store(word, ordering: .relaxed)
+      total += word.nonzeroBitCount
+    }
+    setBits.store(total, ordering: .releasing)
+  }
+
+  deinit {
+    words.deinitialize(count: wordCount)
+    words.deallocate()
   }
 
   /**
    Saves the cache map to a file at the specified URL.
 
-   The file will contain the count (as a UInt64) followed by the bitmap.
+   The file will contain the count (as a UInt64) followed by the bitmap. The map is written
+   to a temporary file that is flushed and then renamed over the target, so the target
+   always holds either the previous or the new map, even if the process dies while saving.
 
    - Parameter url: The file URL where the cache map should be saved.
    - Throws: An error if writing to the file fails.
    */
   func save(to url: URL) throws {
-    var data = Data()
+    try CacheMap.write(serialized(), atomicallyTo: url)
+  }
+
+  /**
+   Writes serialized cache map data to a temporary file, flushes it to disk and renames it
+   over the target.
+
+   - Parameters:
+   - data: The data, usually from `serialized()`.
+   - url: The target file URL.
+   - Throws: An error if writing, flushing or renaming fails.
+   */
+  static func write(_ data: Data, atomicallyTo url: URL) throws {
+    let tempURL = url.appendingPathExtension("tmp")
+    try data.write(to: tempURL)
+    let handle = try FileHandle(forWritingTo: tempURL)
+    try handle.synchronize()
+    try handle.close()
+    if rename(tempURL.path, url.path) != 0 {
+      throw CocoaError(.fileWriteUnknown, userInfo: [NSFilePathErrorKey: url.path])
+    }
+  }
+
+  /**
+   Serializes the cache map in the file format. Bits set concurrently may or may not be
+   included, but every bit set before the call is.
+
+   - Returns: The count (as a UInt64) followed by the bitmap.
+   */
+  func serialized() -> Data {
+    let byteCount = (count + 7) / 8
+    var data = Data(capacity: 8 + byteCount)
     var count64 = UInt64(count)
     data.append(Data(bytes: &count64, count: MemoryLayout<UInt64>.size))
-    data.append(contentsOf: map)
-    try data.write(to: url)
+    for w in 0..<wordCount {
+      let word = words[w].load(ordering: .acquiring)
+      for k in 0..<8 where w * 8 + k < byteCount {
+        data.append(CacheMap.reversedBits(UInt8(truncatingIfNeeded: word >> (8 * k))))
+      }
+    }
+    return data
   }
 
   /**
@@ -110,11 +173,8 @@ class CacheMap {
    - Returns: True if the bit at the specified index is set; otherwise, false.
    */
   func isSet(index: Int) -> Bool {
-    return queue.sync {
-      let byte = map[index / 8]
-      let bit = 7 - (index % 8)
-      return (byte & (1 << bit)) != 0
-    }
+    let word = words[index >> 6].load(ordering: .acquiring)
+    return word & (1 << UInt64(index & 63)) != 0
   }
 
   /**
@@ -125,15 +185,55 @@ class CacheMap {
    - Parameter index: The index of the bit to set.
    */
   func set(index: Int) {
-    queue.sync {
-      let byteIndex = index / 8
-      let bit = 7 - (index % 8)
-      let mask: UInt8 = (1 << bit)
-      
-      if (map[byteIndex] & mask) == 0 {
-        map[byteIndex] |= mask
-        setCount += 1
+    let mask: UInt64 = 1 << UInt64(index & 63)
+    let (oldWord, _) = words[index >> 6].bitwiseOr(mask, ordering: .acquiringAndReleasing)
+    if oldWord & mask == 0 {
+      setBits.add(1, ordering: .relaxed)
+    }
+  }
+
+  /**
+   Finds the first unset bit at or after the specified index.
+
+   - Parameter index: The index to start at.
+   - Returns: The index of the unset bit, or nil if all bits from `index` on are set.
+   */
+  func nextUnset(from index: Int) -> Int? {
+    guard index < count else { return nil }
+    var w = max(0, index) >> 6
+    // Treat the bits before the start as set.
+    var unset = ~words[w].load(ordering: .acquiring) & (~UInt64(0) << UInt64(max(0, index) & 63))
+    while true {
+      unset &= validMask(ofWord: w)
+      if unset != 0 {
+        return w * 64 + unset.trailingZeroBitCount
       }
+      w += 1
+      guard w < wordCount else { return nil }
+      unset = ~words[w].load(ordering: .acquiring)
+    }
+  }
+
+  /**
+   Finds the last unset bit at or before the specified index.
+
+   - Parameter index: The index to start at.
+   - Returns: The index of the unset bit, or nil if all bits up to `index` are set.
+   */
+  func previousUnset(from index: Int) -> Int? {
+    guard index >= 0, count > 0 else { return nil }
+    let start = min(index, count - 1)
+    var w = start >> 6
+    // Treat the bits after the start as set.
+    var unset = ~words[w].load(ordering: .acquiring) & (~UInt64(0) >> UInt64(63 - (start & 63)))
+    while true {
+      unset &= validMask(ofWord: w)
+      if unset != 0 {
+        return w * 64 + 63 - unset.leadingZeroBitCount
+      }
+      w -= 1
+      guard w >= 0 else { return nil }
+      unset = ~words[w].load(ordering: .acquiring)
     }
   }
 
@@ -143,15 +243,30 @@ class CacheMap {
    - Returns: True if the number of set bits equals the total count; otherwise, false.
    */
   func isComplete() -> Bool {
-    return queue.sync {
-      return setCount == count
-    }
+    setCount == count
   }
 
   /// Clears all bits in the cache map, resetting the set count to zero.
   func clear() {
-    map = Array(repeating: 0, count: map.count)
-    setCount = 0
+    for w in 0..<wordCount {
+      words[w].store(0, ordering: .relaxed)
+    }
+    setBits.store(0, ordering: .releasing)
+  }
+
+  /// The bits of word `w` that correspond to valid indices.
+  private func validMask(ofWord w: Int) -> UInt64 {
+    let bitsInWord = count - w * 64
+    return bitsInWord >= 64 ? ~UInt64(0) : (UInt64(1) << UInt64(bitsInWord)) - 1
+  }
+
+  /// Reverses the bit order of a byte, converting between file and memory bit order.
+  private static func reversedBits(_ byte: UInt8) -> UInt8 {
+    var value = byte
+    value = (value & 0xF0) >> 4 | (value & 0x0F) << 4
+    value = (value & 0xCC) >> 2 | (value & 0x33) << 2
+    value = (value & 0xAA) >> 1 | (value & 0x55) << 1
+    return value
   }
 }
 
@@ -30,6 +30,19 @@ final class CachingRemoteDataSource: DataSource {
   /// How many bricks do we ant to request in a single call?
   private let maxBricksPerGetRequest: Int
 
+  /// The maximum number of requests kept in flight at once; 1 without pipelining.
+  private let pipelineDepth: Int
+
+  /// The time a demand request may occupy a connection, in seconds. Short, so newly visible
+  /// bricks never wait long behind a large request.
+  private static let demandLatencyBudget = 0.1
+
+  /// The time a prefetch request may occupy a connection, in seconds.
+  private static let prefetchLatencyBudget = 0.5
+
+  /// The compressed size of each brick in bytes, used to size requests.
+  private let brickSizes: [Int]
+
   /// Flag indicating if caching has been fully completed.
   private(set) var cachingComplete: Bool = false
 
@@ -39,26 +52,47 @@ final class CachingRemoteDataSource: DataSource {
   /// The memory‐mapped file used to store cached brick data.
   private var dataFile: MemoryMappedFile
 
-  /// Scratch buffer for decompression (if compression is enabled).
-  private var compressionScratchBuffer: UnsafeMutableRawPointer?
+  /// The full size of a brick in bytes.
+  private var fullBrickSize: Int
 
-  /// Temporary buffer for brick data (used during synchronous fetches).
-  private var tempDataBuffer: UnsafeMutablePointer<UInt8>
+  /// The queue of the demand lane, which serves bricks requested by `getBrick`.
+  private let workerQueue = DispatchQueue(label: "CachingWorkerQueue", qos: .userInitiated)
 
-  /// Temporary buffer for background brick fetches.
-  private var tempDataBufferBackground: UnsafeMutablePointer<UInt8>
+  /// The queue of the prefetch lanes, which download the rest of the dataset.
+  private let prefetchQueue = DispatchQueue(label: "CachingPrefetchQueue", qos: .background,
+                                            attributes: .concurrent)
 
-  /// The full size of a brick in bytes.
-  private var fullBrickSize: Int
+  /// The worker tasks of all lanes.
+  private var workerTasks: [DispatchWorkItem] = []
+
+  /// The number of additional connections used for prefetching.
+  let prefetchConnectionCount: Int
 
-  /// A background dispatch queue for caching work.
-  private let workerQueue = DispatchQueue(label: "CachingWorkerQueue", qos: .background)
+  /// A lock for the lane bookkeeping below.
+  private let laneLock = NSLock()
 
-  /// The background worker task.
-  private var workerTask: DispatchWorkItem?
+  /// Bricks currently being downloaded by any lane, so no brick is written twice at once.
+  private var inFlight = Set<Int>()
 
-  /// A queue of brick indices requested for caching.
-  private var requestQueue = [Int]()
+  /// The next brick index the prefetch walk considers; the walk runs from the coarsest
+  /// level (the last brick) down to the finest.
+  private var prefetchCursor: Int
+
+  /// Prefetch bricks that were claimed but not downloaded, e.g. after a network error.
+  private var returnedPrefetchIndices: [Int] = []
+
+  /// The bricks the prefetch planner predicts to be needed soon, in reverse order so the
+  /// next one is the last element. They are prefetched before the rest of the walk.
+  private var plannedPrefetchIndices: [Int] = []
+
+  /// The number of prefetch lanes with a working connection.
+  private var activePrefetchLanes = 0
+
+  /// The remote sources of the prefetch lanes, used to promote demanded bricks.
+  private var prefetchSources: [RemoteDataSource] = []
+
+  /// The bricks requested by getBrick, latest view and coarsest level first.
+  private var requestQueue: BrickRequestQueue
 
   /// A lock for synchronizing access to the request queue.
   private let requestQueueLock = DispatchQueue(label: "RequestQueueLock")
@@ -69,6 +103,44 @@ final class CachingRemoteDataSource: DataSource {
   /// Flag indicating if the background worker has been terminated.
   private var terminated = false
 
+  /// The time of the first miss since the view last converged, while the missing bricks are
+  /// still loading. Protected by `requestQueueLock`.
+  private var viewChangeTime: Date?
+
+  /// The number of bricks fetched on demand since the last view change.
+  /// Protected by `requestQueueLock`.
+  private var bricksSinceViewChange = 0
+
+  /// The bricks `getBrick` missed since the last call of `newRequest`, i.e., during the last
+  /// frame. Protected by `requestQueueLock`.
+  private var recentMisses = Set<Int>()
+
+  /// The transfer estimates of the demand connection followed by those of the prefetch
+  /// connections.
+  var transferMetrics: [TransferEstimator.Metrics] {
+    [remoteDataSource.transferEstimator.metrics] +
+    laneLock.withLock { prefetchSources }.map { $0.transferEstimator.metrics }
+  }
+
+  /// The interval between checkpoints of the cache map in seconds, 0 disables them.
+  let checkpointInterval: TimeInterval
+
+  /// The timer that triggers checkpoints.
+  private var checkpointTimer: DispatchSourceTimer?
+
+  /// The queue the checkpoint timer fires on.
+  private let checkpointQueue = DispatchQueue(label: "CachingCheckpointQueue", qos: .utility)
+
+  /// Serializes checkpoints, which run on the timer and once more from `deinit`.
+  private let checkpointLock = NSLock()
+
+  /// Byte ranges of the cache file written since the last checkpoint. Only recorded while
+  /// checkpoints are enabled; otherwise the final checkpoint flushes the whole file.
+  private var dirtyRanges: [Range<Int>] = []
+
+  /// A lock for `dirtyRanges`.
+  private let dirtyLock = NSLock()
+
   /// The current caching progress as a value between 0 and 1.
   public var cachingProgress: Double {
     Double(cacheMap.setCount) / Double(cacheMap.count)
@@ -85,22 +157,38 @@ final class CachingRemoteDataSource: DataSource {
    to fetch uncached bricks.
 
    - Parameters:
-   - connection: The NWConnection used for remote communication.
+   - connection: The connection used for remote communication.
    - datasetID: The identifier of the remote dataset.
+   - maxBricksPerGetRequest: The maximum number of bricks per request.
+   - protocolVersion: The negotiated wire protocol version (default is `1`).
+   - prefetchConnections: The number of additional connections that download the dataset in
+   the background, or `nil` to choose one based on the protocol version.
+   - checkpointInterval: The interval in seconds between checkpoints of the cache map, so an
+   interrupted download resumes where it left off. 0 disables checkpoints (default is 10).
    - filename: The target filename for the local cache.
    - Throws: An error if the backing file cannot be created or mapped.
    */
-  init(connection: NWConnection, datasetID: String, maxBricksPerGetRequest: Int,
+  init(connection: AsyncConnection, datasetID: String, maxBricksPerGetRequest: Int,
+       protocolVersion: Int = 1, prefetchConnections: Int? = nil,
+       checkpointInterval: TimeInterval = 10,
        filename: String, logger: LoggerBase?, notifier: NotificationBase?) throws {
     self.remoteDataSource = try RemoteDataSource(connection: connection,
                                                  datasetID: datasetID,
+                                                 protocolVersion: protocolVersion,
                                                  logger:logger)
     self.targetFilename = filename
     self.logger = logger
     self.notifier = notifier
     self.maxBricksPerGetRequest = maxBricksPerGetRequest
+    self.checkpointInterval = checkpointInterval
+    self.pipelineDepth = remoteDataSource.supportsPipelining ? 16 : 1
+    // Without pipelining every connection waits a full round trip per batch,
+    // so more connections are needed to fill a long, fat link.
+    self.prefetchConnectionCount = max(0, prefetchConnections ??
+                                       (remoteDataSource.supportsPipelining ? 2 : 4))
 
     let metadata = remoteDataSource.getMetadata()
+    self.brickSizes = metadata.brickMetadata.map { $0.size }
     let fileManager = FileManager.default
     let fullURL = URL(fileURLWithPath: targetFilename)
 
@@ -131,31 +219,42 @@ final class CachingRemoteDataSource: DataSource {
       // Store the file size at the beginning of the file.
       let pointer = self.dataFile.mappedMemory.assumingMemoryBound(to: UInt64.self)
       pointer[0] = UInt64(fileSize)
+      self.dirtyRanges = [0..<MemoryLayout<UInt64>.size]
     }
 
     // Decompression setup.
     self.fullBrickSize = metadata.brickSize * metadata.brickSize * metadata.brickSize *
     metadata.componentCount * metadata.bytesPerComponent
-    if metadata.compression {
-      let scratchBufferSize = compression_decode_scratch_buffer_size(COMPRESSION_LZ4)
-      self.compressionScratchBuffer = UnsafeMutableRawPointer.allocate(
-        byteCount: scratchBufferSize,
-        alignment: MemoryLayout<UInt8>.alignment
-      )
-    }
-    self.tempDataBuffer = UnsafeMutablePointer<UInt8>.allocate(capacity: fullBrickSize)
-    self.tempDataBufferBackground = UnsafeMutablePointer<UInt8>
-      .allocate(capacity: fullBrickSize*maxBricksPerGetRequest)
 
     // Initialize the request queue (initially empty).
-    self.requestQueue = []
+    self.requestQueue = BrickRequestQueue(metadata: metadata)
+    self.prefetchCursor = metadata.brickMetadata.count - 1
+
+    // Start the demand lane and the prefetch lanes.
+    let demandTask = DispatchWorkItem { [weak self] in
+      self?.demandWorkerLoop()
+    }
+    workerTasks.append(demandTask)
+    workerQueue.async(execute: demandTask)
 
-    // Start background worker.
-    let task = DispatchWorkItem { [weak self] in
-      self?.backgroundWorkerLoop()
+    for lane in 0..<prefetchConnectionCount {
+      let prefetchTask = DispatchWorkItem { [weak self] in
+        self?.prefetchWorkerLoop(lane: lane)
+      }
+      workerTasks.append(prefetchTask)
+      prefetchQueue.async(execute: prefetchTask)
+    }
+
+    if checkpointInterval > 0 {
+      let timer = DispatchSource.makeTimerSource(queue: checkpointQueue)
+      timer.schedule(deadline: .now() + checkpointInterval, repeating: checkpointInterval,
+                     leeway: .milliseconds(Int(checkpointInterval * 100)))
+      timer.setEventHandler { [weak self] in
+        self?.checkpoint()
+      }
+      timer.resume()
+      checkpointTimer = timer
     }
-    self.workerTask = task
-    workerQueue.async(execute: task)
 
     logger?.dev("CachingRemoteDataSource initialized")
   }
@@ -163,15 +262,18 @@ final class CachingRemoteDataSource: DataSource {
   // MARK: - Worker Control
 
   /**
-   Stops the background worker.
+   Stops the background workers.
 
-   This method signals termination, cancels the worker task, and wakes the worker if it is waiting.
+   This method signals termination, cancels the worker tasks, wakes the demand lane if it is
+   waiting, and waits until all lanes have finished.
    */
   func stopWorker() {
     terminated = true
-    workerTask?.cancel()
+    checkpointTimer?.cancel()
+    workerTasks.forEach { $0.cancel() }
     requestSemaphore.signal() // Wake worker if waiting.
     workerQueue.sync(flags: .barrier) {}
+    prefetchQueue.sync(flags: .barrier) {}
   }
 
   deinit {
@@ -196,14 +298,12 @@ final class CachingRemoteDataSource: DataSource {
         logger?.error("Error while completing dataset caching: \(error)")
       }
     } else {
-      try? cacheMap.save(to: cacheMapURL)
+      // Called directly: deinit may itself run on checkpointQueue when the timer handler
+      // held the last reference.
+      checkpoint()
       logger?.dev("Dataset caching incomplete, caching will continue later")
     }
 
-    compressionScratchBuffer?.deallocate()
-    tempDataBuffer.deallocate()
-    tempDataBufferBackground.deallocate()
-
     logger?.dev("CachingRemoteDataSource deinitialized")
   }
 
@@ -250,91 +350,302 @@ final class CachingRemoteDataSource: DataSource {
       return
     }
 
+    // If the brick is part of a prefetch request that is still queued on the
+    // server, have it sent before the other prefetch requests.
+    let sources = laneLock.withLock { prefetchSources }
+    _ = sources.first { $0.promote(index: index) }
+
     requestQueueLock.sync {
-      requestQueue.append(index)
+      requestQueue.push(index)
+      recentMisses.insert(index)
+      if viewChangeTime == nil {
+        viewChangeTime = Date()
+        bricksSinceViewChange = 0
+      }
     }
     requestSemaphore.signal()
     throw BORGVRDataError.brickNotYetAvailable(index: index)
   }
 
+  /**
+   Signals the start of a new frame. Bricks requested from now on are served before the still
+   queued bricks of previous frames. Demand requests pending on the server are dropped unless
+   the last frame still missed one of their bricks, so a request whose round trip spans
+   several frames survives as long as the view keeps needing it.
+   */
   func newRequest() {
-    requestQueueLock.sync {
-      requestQueue.removeAll()
+    let stillNeeded = requestQueueLock.sync {
+      requestQueue.newGeneration()
+      let misses = recentMisses
+      recentMisses.removeAll(keepingCapacity: true)
+      return misses
     }
+    remoteDataSource.cancelOutstanding(priority: WireProtocol.demandPriority,
+                                       keeping: stillNeeded)
   }
 
 
-  // MARK: - Background Worker
+  /**
+   Replaces the bricks that are prefetched first, e.g. with the plan of a `PrefetchPlanner`.
+   Bricks that are already cached are skipped.
+
+   - Parameter indices: The brick indices, most urgent first.
+   */
+  func setPrefetchPlan(_ indices: [Int]) {
+    let planned = indices.reversed().filter { !cacheMap.isSet(index: $0) }
+    laneLock.withLock {
+      plannedPrefetchIndices = planned
+    }
+    if !planned.isEmpty {
+      // Wake the demand lane in case it prefetches itself.
+      requestSemaphore.signal()
+    }
+  }
+
+  // MARK: - Background Workers
 
   /**
-   The main loop of the background worker.
+   The main loop of the demand lane.
 
-   This loop continuously processes brick requests from the requestQueue or prefetches
-   uncached bricks. It fetches brick data from the remote source, caches it locally, and
-   signals any waiting threads.
+   This loop serves the bricks requested by getBrick over the connection the data source was
+   created with, so they never queue behind bulk downloads. It only prefetches itself if
+   there is no working prefetch lane.
    */
-  private func backgroundWorkerLoop() {
-    var lastIndex = cacheMap.count - 1
+  private func demandWorkerLoop() {
+    // With pipelining, several requests are in flight per round trip.
+    let bricksPerRound = maxBricksPerGetRequest * pipelineDepth
     while !terminated {
-      var indicesToProcess =  Set<Int>()
+      var requested = [Int]()
+      let roundBytes = remoteDataSource.transferEstimator.roundBytes(
+        latencyBudget: CachingRemoteDataSource.demandLatencyBudget)
 
-      // First: priority requests from getBrick unless we have already
-      //        cached that brick
+      // Priority requests from getBrick unless we have already cached that brick
       requestQueueLock.sync {
-        requestQueue.removeAll { cacheMap.isSet(index: $0) }
-        let take = min(maxBricksPerGetRequest, requestQueue.count)
-        indicesToProcess = Set(requestQueue.prefix(take))
-        requestQueue.removeFirst(take)
-      }
+        var requestedBytes = 0
+        while requested.count < bricksPerRound, let index = requestQueue.first {
+          if cacheMap.isSet(index: index) {
+            requestQueue.popFirst()
+            continue
+          }
+          if !requested.isEmpty && requestedBytes + brickSizes[index] > roundBytes { break }
+          requestQueue.popFirst()
+          requested.append(index)
+          requestedBytes += brickSizes[index]
+        }
+        bricksSinceViewChange += requested.count
 
-      // Second: background prefetch from cacheMap to compete the dataset
-      //         load lower resolutions first
-      if indicesToProcess.count < maxBricksPerGetRequest && !cacheMap.isComplete() {
-        while lastIndex >= 0 && indicesToProcess.count < maxBricksPerGetRequest {
-          if !cacheMap.isSet(index: lastIndex) {
-            indicesToProcess.insert(lastIndex)
+        // The view has converged once the renderer stops missing bricks.
+        if requested.isEmpty, let start = viewChangeTime {
+          if bricksSinceViewChange > 0 {
+            logger?.dev("View converged after \(Int(Date().timeIntervalSince(start) * 1000)) ms " +
+                        "and \(bricksSinceViewChange) demand-loaded bricks")
           }
-          lastIndex-=1
+          viewChangeTime = nil
         }
       }
 
+      // Bricks a prefetch lane is already downloading are skipped; getBrick
+      // has promoted them on that lane.
+      let demandIndices = claim(requested)
+
+      var prefetchIndices = [Int]()
+      let demandBytes = demandIndices.reduce(0) { $0 + brickSizes[$1] }
+      if demandIndices.count < bricksPerRound && demandBytes < roundBytes &&
+          laneLock.withLock({ activePrefetchLanes == 0 }) {
+        prefetchIndices = claimPrefetchIndices(maxCount: bricksPerRound - demandIndices.count,
+                                               maxBytes: roundBytes - demandBytes)
+      }
 
       // Wait if no work is available.
-      if indicesToProcess.isEmpty {
+      if demandIndices.isEmpty && prefetchIndices.isEmpty {
+        if cachingComplete { break }
         requestSemaphore.wait()
         continue
       }
 
-      do {
-        let indexArray = Array(indicesToProcess.sorted())
-
-        let brickMeta = try remoteDataSource.getRawBricks(
-          indices: indexArray,
-          outputBuffer: tempDataBufferBackground,
-          outputBufferSize: fullBrickSize*maxBricksPerGetRequest
-        )
-
-        var offset = 0
-        for (meta,index) in zip(brickMeta,indexArray) {
-          let brickPtr = tempDataBufferBackground.advanced(by: offset)
-          try setLocalBrick(index: index,
-                            brickMeta: meta,
-                            buffer: brickPtr)
-          offset += meta.size
+      if fetch(demand: demandIndices, prefetch: prefetchIndices, using: remoteDataSource) {
+        break
+      }
+    }
+  }
+
+  /**
+   The main loop of a prefetch lane.
+
+   Each lane opens its own connection and repeatedly claims the next uncached bricks of the
+   shared prefetch walk, so the download is striped across all lanes in the order of the
+   walk, lower resolutions first.
+
+   - Parameter lane: The number of the lane, used for logging.
+   */
+  private func prefetchWorkerLoop(lane: Int) {
+    let source: RemoteDataSource
+    do {
+      source = try remoteDataSource.openAdditionalConnection()
+    } catch {
+      logger?.warning("Prefetch lane \(lane) could not connect: \(error.localizedDescription)")
+      return
+    }
+    laneLock.withLock {
+      prefetchSources.append(source)
+      activePrefetchLanes += 1
+    }
+    defer {
+      laneLock.withLock {
+        prefetchSources.removeAll { $0 === source }
+        activePrefetchLanes -= 1
+      }
+      // Let the demand lane take over prefetching if this was the last lane.
+      requestSemaphore.signal()
+    }
+
+    let bricksPerRound = maxBricksPerGetRequest * pipelineDepth
+    while !terminated && !cachingComplete {
+      let roundBytes = source.transferEstimator.roundBytes(
+        latencyBudget: CachingRemoteDataSource.prefetchLatencyBudget)
+      let prefetchIndices = claimPrefetchIndices(maxCount: bricksPerRound, maxBytes: roundBytes)
+      if prefetchIndices.isEmpty {
+        // Other lanes may still return bricks after an error.
+        if laneLock.withLock({ inFlight.isEmpty && returnedPrefetchIndices.isEmpty }) {
+          break
         }
-        logger?.dev("Cached \(cacheMap.fillRatio*100) % of the dataset.")
+        Thread.sleep(forTimeInterval: 0.05)
+        continue
+      }
+      if fetch(demand: [], prefetch: prefetchIndices, using: source) {
+        break
+      }
+    }
+  }
+
+  /**
+   Marks the given bricks as in flight, skipping those that are cached or already in flight.
+
+   - Parameter indices: The candidate brick indices.
+   - Returns: The indices the caller is now responsible for.
+   */
+  private func claim(_ indices: [Int]) -> [Int] {
+    laneLock.withLock {
+      var claimed = [Int]()
+      for index in indices where !inFlight.contains(index) && !cacheMap.isSet(index: index) {
+        inFlight.insert(index)
+        claimed.append(index)
+      }
+      return claimed
+    }
+  }
 
+  /**
+   Claims uncached bricks from the prefetch walk, starting with bricks that were returned after
+   a failed download and then the planned bricks, until `maxCount` bricks or `maxBytes` bytes
+   are reached.
 
-        if cacheMap.isComplete() {
-          cachingComplete = true
-          logger?.dev("All bricks are locally cached")
-          notifier?.silent(title:"Remote Dataset Complete",
-                           message:"The dataset has been downloaded in its entirety and is now available locally.")
+   - Parameters:
+   - maxCount: The maximum number of bricks.
+   - maxBytes: The maximum total size in bytes; at least one brick is claimed.
+   - Returns: The claimed brick indices.
+   */
+  private func claimPrefetchIndices(maxCount: Int, maxBytes: Int) -> [Int] {
+    laneLock.withLock {
+      var claimed = [Int]()
+      var claimedBytes = 0
+      func tryClaim(_ index: Int) {
+        if !inFlight.contains(index) && !cacheMap.isSet(index: index) {
+          inFlight.insert(index)
+          claimed.append(index)
+          claimedBytes += brickSizes[index]
+        }
+      }
+      func isFull() -> Bool {
+        claimed.count >= maxCount || claimedBytes >= maxBytes
+      }
+      while !isFull(), let index = returnedPrefetchIndices.popLast() {
+        tryClaim(index)
+      }
+      while !isFull(), let index = plannedPrefetchIndices.popLast() {
+        tryClaim(index)
+      }
+      // Skip runs of cached bricks a word at a time.
+      while !isFull() {
+        guard let index = cacheMap.previousUnset(from: prefetchCursor) else {
+          prefetchCursor = -1
           break
         }
-      } catch {
-        // Handle fetch or write failure as needed.
+        tryClaim(index)
+        prefetchCursor = index - 1
+      }
+      return claimed
+    }
+  }
+
+  /**
+   Downloads claimed bricks over one connection and stores them in the cache.
+
+   Demand and prefetch bricks go into separate requests, so the server can send the former
+   first and a view change only cancels those. All claims are released afterwards; prefetch
+   bricks that were not stored are returned to the prefetch walk.
+
+   - Parameters:
+   - demand: Claimed bricks requested by the renderer.
+   - prefetch: Claimed bricks of the prefetch walk.
+   - source: The connection to use.
+   - Returns: `true` if the dataset is now completely cached.
+   */
+  private func fetch(demand: [Int], prefetch: [Int], using source: RemoteDataSource) -> Bool {
+    defer {
+      laneLock.withLock {
+        inFlight.subtract(demand)
+        inFlight.subtract(prefetch)
+        returnedPrefetchIndices.append(contentsOf: prefetch.filter { !cacheMap.isSet(index: $0) })
+      }
+    }
+
+    do {
+      // Requests are sized in bytes from the connection's throughput, so each
+      // occupies the link for about the latency budget of its lane.
+      var batches: [[Int]] = []
+      var priorities: [Int] = []
+      for (indices, priority, budget) in
+            [(demand, WireProtocol.demandPriority, CachingRemoteDataSource.demandLatencyBudget),
+             (prefetch, WireProtocol.prefetchPriority, CachingRemoteDataSource.prefetchLatencyBudget)] {
+        let indexArray = indices.sorted()
+        let split = TransferEstimator.split(indexArray,
+                                            sizes: indexArray.map { brickSizes[$0] },
+                                            targetBytes: source.transferEstimator.batchBytes(latencyBudget: budget),
+                                            maxCount: maxBricksPerGetRequest)
+        batches += split
+        priorities += Array(repeating: priority, count: split.count)
+      }
+
+      try source.getRawBricksPipelined(batches: batches, priorities: priorities) { indices, brickMeta, data in
+        try data.withUnsafeBytes { rawBuffer in
+          var offset = 0
+          for (meta,index) in zip(brickMeta,indices) {
+            try setLocalBrick(index: index,
+                              brickMeta: meta,
+                              buffer: rawBuffer.baseAddress!.advanced(by: offset))
+            offset += meta.size
+          }
+        }
       }
+      let metrics = source.transferEstimator.metrics
+      logger?.dev("Cached \(cacheMap.fillRatio*100) % of the dataset " +
+                  "(\(Int(metrics.throughput / 1_000_000)) MB/s, RTT \(Int(metrics.minRTT * 1000)) ms).")
+    } catch {
+      // Unstored prefetch bricks are retried by the next claims; demand
+      // bricks are requested again by the renderer.
+      logger?.warning("Brick download failed: \(error.localizedDescription)")
+      Thread.sleep(forTimeInterval: 0.1)
+      return false
+    }
+
+    return laneLock.withLock {
+      guard cacheMap.isComplete() && !cachingComplete else { return cachingComplete }
+      cachingComplete = true
+      logger?.dev("All bricks are locally cached")
+      notifier?.silent(title:"Remote Dataset Complete",
+                       message:"The dataset has been downloaded in its entirety and is now available locally.")
+      return true
     }
   }
 
@@ -347,15 +658,73 @@ final class CachingRemoteDataSource: DataSource {
    - Throws: An error if the memory mapping is unavailable.
    */
   private func setLocalBrick(index: Int, brickMeta: BrickMetadata,
-                             buffer: UnsafeMutablePointer<UInt8>) throws {
+                             buffer: UnsafeRawPointer) throws {
     memcpy(
       dataFile.mappedMemory.advanced(by: brickMeta.offset),
       buffer,
       brickMeta.size
     )
+    // The range must be recorded before the bit is set, see checkpoint().
+    if checkpointInterval > 0 {
+      dirtyLock.withLock {
+        dirtyRanges.append(brickMeta.offset..<brickMeta.offset + brickMeta.size)
+      }
+    }
     cacheMap.set(index: index)
   }
 
+  // MARK: - Checkpoints
+
+  /**
+   Makes the current download state durable: flushes the cache file ranges written since the
+   last checkpoint and then atomically replaces the cache map file.
+
+   The map is captured before the dirty ranges are taken. As setLocalBrick records a range
+   before it sets the brick's bit, every brick in the captured map has its data in a range
+   flushed now or by an earlier checkpoint, so the saved map never claims data that could be
+   lost. With checkpoints disabled no ranges are recorded, and the whole file is flushed.
+
+   Serialized by `checkpointLock`, so it may be called from any thread.
+   */
+  private func checkpoint() {
+    checkpointLock.lock()
+    defer { checkpointLock.unlock() }
+
+    let map = cacheMap.serialized()
+    let ranges = dirtyLock.withLock {
+      defer { dirtyRanges.removeAll(keepingCapacity: true) }
+      return dirtyRanges
+    }
+    guard !ranges.isEmpty || checkpointInterval == 0 else { return }
+
+    do {
+      if checkpointInterval == 0 {
+        try dataFile.sync()
+      } else {
+        // Bricks are mostly written in runs, so merging adjacent ranges keeps
+        // the number of msync calls small.
+        var merged: [Range<Int>] = []
+        for range in ranges.sorted(by: { $0.lowerBound < $1.lowerBound }) {
+          if let last = merged.last, range.lowerBound <= last.upperBound {
+            merged[merged.count - 1] = last.lowerBound..<max(last.upperBound, range.upperBound)
+          } else {
+            merged.append(range)
+          }
+        }
+        for range in merged {
+          try dataFile.sync(range: range)
+        }
+      }
+
+      let cacheMapURL = URL(fileURLWithPath: targetFilename).appendingPathExtension("cachemap")
+      try CacheMap.write(map, atomicallyTo: cacheMapURL)
+    } catch {
+      // Flush the ranges again with the next checkpoint.
+      dirtyLock.withLock { dirtyRanges.append(contentsOf: ranges) }
+      logger?.warning("Cache checkpoint failed: \(error.localizedDescription)")
+    }
+  }
+
   /**
    Retrieves a locally cached brick and decompresses it into the output buffer.
 
@@ -366,8 +735,9 @@ final class CachingRemoteDataSource: DataSource {
    */
   private func getLocalBrick(index: Int, outputBuffer: UnsafeMutablePointer<UInt8>) throws {
     let brickMeta = getMetadata().brickMetadata[index]
-    memcpy(tempDataBuffer, dataFile.mappedMemory.advanced(by: brickMeta.offset), brickMeta.size)
-    try decompressRawBrick(inputBuffer: tempDataBuffer, outputBuffer: outputBuffer, brickMeta: brickMeta)
+    let brickPointer = dataFile.mappedMemory.advanced(by: brickMeta.offset)
+      .assumingMemoryBound(to: UInt8.self)
+    try decompressRawBrick(inputBuffer: brickPointer, outputBuffer: outputBuffer, brickMeta: brickMeta)
   }
 
   /**
@@ -386,15 +756,13 @@ final class CachingRemoteDataSource: DataSource {
                                   outputBuffer: UnsafeMutablePointer<UInt8>,
                                   brickMeta: BrickMetadata) throws {
     if getMetadata().compression && brickMeta.size < fullBrickSize {
-      guard let scratchBuffer = compressionScratchBuffer else {
-        throw BORGVRDataError.compressionBuffersUnavailable
-      }
+      // No shared scratch buffer, so bricks can be decoded on several threads at once.
       let decompressedSize = compression_decode_buffer(
         outputBuffer,
         fullBrickSize,
         inputBuffer,
         brickMeta.size,
-        scratchBuffer,
+        nil,
         COMPRESSION_LZ4
       )
       if decompressedSize == 0 {
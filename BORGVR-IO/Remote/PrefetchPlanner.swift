@@ -0,0 +1,463 @@
+import Foundation
+
+/**
+ Predicts which bricks the renderer will need in the near future from the recent head
+ motion, so a caching data source can download them before they are missed.
+
+ The renderer reports the camera pose and clip box every frame. The planner extrapolates
+ the motion over the next `horizon` seconds, intersects the predicted views with the brick
+ hierarchy, and selects the bricks at the level of detail the raycaster would choose, using
+ the same level table and LOD formula as the shaders. The resulting plan is ordered by the
+ time a brick is predicted to become visible, then coarse levels before fine ones, then by
+ distance to the camera.
+
+ The planner only depends on Foundation, so recorded pose traces (see `TraceEntry`) can be
+ replayed without a headset, e.g. with the command line tool.
+ */
+final class PrefetchPlanner {
+
+  // MARK: - Types
+
+  /**
+   The view state of one frame. All positions and directions are in the texture space of
+   the volume, where the volume spans [0, 1]³.
+   */
+  struct Pose: Codable {
+    /// The time of the frame in seconds, on any monotonic clock.
+    var time: Double
+    /// The position of the camera.
+    var position: SIMD3<Float>
+    /// The camera position the shaders use for LOD selection
+    /// (`cameraPosInTextureSpaceVoxelScaled`).
+    var lodPosition: SIMD3<Float>
+    /// The normalized view direction.
+    var forward: SIMD3<Float>
+    /// The lower corner of the clip box.
+    var clipMin: SIMD3<Float>
+    /// The upper corner of the clip box.
+    var clipMax: SIMD3<Float>
+  }
+
+  /**
+   The renderer constants that determine the level of detail, matching the `LOD_FACTOR` and
+   `LEVEL_ZERO_WORLD_SPACE_ERROR` shader macros.
+   */
+  struct LODParameters: Codable {
+    /// The LOD factor derived from the field of view and the screen space error.
+    var lodFactor: Float
+    /// The world space size of a voxel at level 0.
+    var levelZeroWorldSpaceError: Float
+    /// The full opening angle of the view in radians.
+    var fieldOfView: Float = 1.663
+  }
+
+  /**
+   One line of a pose trace. A trace is a JSON Lines file whose first entry holds the LOD
+   parameters; every following entry holds the pose of a frame and the bricks the renderer
+   requested in that frame.
+   */
+  struct TraceEntry: Codable {
+    var parameters: LODParameters?
+    var pose: Pose?
+    var requested: [Int]?
+  }
+
+  /// One level of the brick hierarchy, as in the level table of `VolumeAtlas`.
+  private struct Level {
+    let bricksX: Int
+    let bricksXTimesBricksY: Int
+    let prevBricks: Int
+    let totalBricks: SIMD3<Int32>
+    let fractionalBrickLayout: SIMD3<Float>
+  }
+
+  /// A brick selected by the plan, with its sort keys.
+  private struct Candidate {
+    let index: Int
+    let step: Int
+    let level: Int
+    let distance: Float
+  }
+
+  // MARK: - Properties
+
+  /// The number of seconds the view is extrapolated into the future.
+  let horizon: Double
+
+  /// The number of predicted views the horizon is sampled with, besides the current view.
+  let horizonSteps: Int
+
+  /// The interval between two plans in seconds when poses are recorded continuously.
+  let planInterval: Double
+
+  /// The maximum number of bricks in a plan.
+  let maxPlanSize: Int
+
+  /// The LOD constants of the renderer.
+  let parameters: LODParameters
+
+  /// The poses older than this (in seconds) are not used to estimate the motion.
+  private static let historyWindow = 0.25
+
+  /// The largest rotation extrapolated over the horizon, in radians.
+  private static let maxPredictedRotation: Float = .pi / 2
+
+  /// The views are widened by this factor so bricks near the edge are not missed.
+  private static let fieldOfViewMargin: Float = 1.2
+
+  private let levels: [Level]
+  private let lock = NSLock()
+  private var history: [Pose] = []
+  private var lastPlanTime = -Double.infinity
+  private var planning = false
+  private var isTracing = false
+  private var traceHandle: FileHandle?
+  private let planQueue = DispatchQueue(label: "PrefetchPlannerQueue", qos: .utility)
+  private let handler: (([Int]) -> Void)?
+  private let logger: LoggerBase?
+
+  /**
+   Initializes a planner for a dataset.
+
+   - Parameters:
+   - metadata: The metadata of the dataset.
+   - parameters: The LOD constants of the renderer.
+   - horizon: The number of seconds the view is extrapolated.
+   - horizonSteps: The number of predicted views sampled over the horizon.
+   - planInterval: The minimum time between two plans in seconds.
+   - maxPlanSize: The maximum number of bricks in a plan.
+   - logger: An optional logger.
+   - handler: Called on a background queue with every new plan. Without a handler, plans
+   are only computed by calling `plan(at:)`.
+   */
+  init(metadata: BORGVRMetaData, parameters: LODParameters,
+       horizon: Double = 1.0, horizonSteps: Int = 4, planInterval: Double = 0.1,
+       maxPlanSize: Int = 2048, logger: LoggerBase? = nil,
+       handler: (([Int]) -> Void)? = nil) {
+    let innerSize = Float(metadata.brickSize - 2 * metadata.overlap)
+    self.levels = metadata.levelMetadata.map { level in
+      Level(bricksX: level.totalBricks.x,
+            bricksXTimesBricksY: level.totalBricks.x * level.totalBricks.y,
+            prevBricks: level.prevBricks,
+            totalBricks: SIMD3<Int32>(Int32(level.totalBricks.x),
+                                      Int32(level.totalBricks.y),
+                                      Int32(level.totalBricks.z)),
+            fractionalBrickLayout: SIMD3<Float>(Float(level.size.x),
+                                                Float(level.size.y),
+                                                Float(level.size.z)) / innerSize)
+    }
+    self.parameters = parameters
+    self.horizon = horizon
+    self.horizonSteps = max(0, horizonSteps)
+    self.planInterval = planInterval
+    self.maxPlanSize = maxPlanSize
+    self.logger = logger
+    self.handler = handler
+  }
+
+  deinit {
+    try? traceHandle?.close()
+  }
+
+  // MARK: - Recording
+
+  /**
+   Records the pose of a frame. If a handler is set and the last plan is older than
+   `planInterval`, a new plan is computed in the background.
+
+   - Parameter pose: The current pose.
+   */
+  func record(_ pose: Pose) {
+    let (shouldPlan, tracing): (Bool, Bool) = lock.withLock {
+      history.append(pose)
+      let cutoff = pose.time - PrefetchPlanner.historyWindow
+      if let keep = history.firstIndex(where: { $0.time >= cutoff }), keep > 0 {
+        // Keep one pose before the window so there always are two poses to compare.
+        history.removeFirst(keep - 1)
+      }
+      guard handler != nil, !planning, pose.time - lastPlanTime >= planInterval else {
+        return (false, isTracing)
+      }
+      planning = true
+      lastPlanTime = pose.time
+      return (true, isTracing)
+    }
+
+    if tracing {
+      writeTrace(TraceEntry(pose: pose))
+    }
+
+    guard shouldPlan, let handler else { return }
+    planQueue.async { [weak self] in
+      guard let self else { return }
+      let plan = self.plan(at: pose.time)
+      self.lock.withLock { self.planning = false }
+      handler(plan)
+    }
+  }
+
+  /**
+   Records the bricks the renderer requested in the current frame. They are only used for
+   pose traces.
+
+   - Parameter indices: The requested brick indices.
+   */
+  func recordRequests(_ indices: [Int]) {
+    if lock.withLock({ isTracing }) {
+      writeTrace(TraceEntry(requested: indices))
+    }
+  }
+
+  /**
+   Starts writing a pose trace, replacing an existing file.
+
+   - Parameter url: The location of the trace.
+   - Throws: An error if the file cannot be created.
+   */
+  func startTrace(at url: URL) throws {
+    FileManager.default.createFile(atPath: url.path, contents: nil)
+    let handle = try FileHandle(forWritingTo: url)
+    planQueue.sync {
+      try? traceHandle?.close()
+      traceHandle = handle
+    }
+    writeTrace(TraceEntry(parameters: parameters))
+    lock.withLock { isTracing = true }
+    logger?.dev("Recording pose trace to \(url.path)")
+  }
+
+  /**
+   Stops writing the pose trace.
+   */
+  func stopTrace() {
+    lock.withLock { isTracing = false }
+    planQueue.sync {
+      try? traceHandle?.close()
+      traceHandle = nil
+    }
+  }
+
+  /**
+   Reads a pose trace.
+
+   - Parameter url: The location of the trace.
+   - Returns: The entries of the trace in order.
+   - Throws: An error if the file cannot be read or decoded.
+   */
+  static func readTrace(from url: URL) throws -> [TraceEntry] {
+    let decoder = JSONDecoder()
+    return try String(contentsOf: url, encoding: .utf8)
+      .split(whereSeparator: \.isNewline)
+      .map { try decoder.decode(TraceEntry.self, from: Data($0.utf8)) }
+  }
+
+  private func writeTrace(_ entry: TraceEntry) {
+    planQueue.async { [weak self] in
+      guard let handle = self?.traceHandle,
+            var line = try? JSONEncoder().encode(entry) else { return }
+      line.append(0x0A)
+      handle.write(line)
+    }
+  }
+
+  // MARK: - Planning
+
+  /**
+   Computes the bricks that will be needed within the horizon after `time`, from the poses
+   recorded up to then.
+
+   - Parameter time: The time of the current frame.
+   - Returns: The brick indices in the order they should be downloaded.
+   */
+  func plan(at time: Double) -> [Int] {
+    let poses = lock.withLock { history.filter { $0.time <= time } }
+    guard let current = poses.last else { return [] }
+
+    var best = [Int: Candidate]()
+    for step in 0...horizonSteps {
+      let offset = horizonSteps == 0 ? 0 : horizon * Double(step) / Double(horizonSteps)
+      let view = PrefetchPlanner.predict(poses, at: current.time + offset)
+      collectVisibleBricks(from: view, step: step, into: &best)
+      if best.count >= maxPlanSize { break }
+    }
+
+    return best.values
+      .sorted {
+        if $0.step != $1.step { return $0.step < $1.step }
+        if $0.level != $1.level { return $0.level > $1.level }
+        return $0.distance < $1.distance
+      }
+      .prefix(maxPlanSize)
+      .map { $0.index }
+  }
+
+  /**
+   Extrapolates the camera motion of the given poses to a point in time: the position with
+   constant velocity and the view direction with constant angular velocity. The clip box of
+   the latest pose is kept.
+
+   - Parameters:
+   - poses: The recent poses, oldest first; must not be empty.
+   - time: The time to predict the pose for.
+   - Returns: The predicted pose.
+   */
+  static func predict(_ poses: [Pose], at time: Double) -> Pose {
+    let latest = poses.last!
+    guard let oldest = poses.first, latest.time - oldest.time > 1e-4 else {
+      return latest
+    }
+
+    let dt = Float(latest.time - oldest.time)
+    let h = Float(time - latest.time)
+    var predicted = latest
+    predicted.time = time
+    predicted.position += (latest.position - oldest.position) / dt * h
+    predicted.lodPosition += (latest.lodPosition - oldest.lodPosition) / dt * h
+
+    let from = normalize(oldest.forward)
+    let to = normalize(latest.forward)
+    let axis = cross(from, to)
+    let axisLength = length(axis)
+    if axisLength > 1e-6 {
+      let rate = atan2(axisLength, dot(from, to)) / dt
+      let angle = min(rate * h, maxPredictedRotation)
+      predicted.forward = rotate(to, around: axis / axisLength, by: angle)
+    }
+    return predicted
+  }
+
+  /**
+   Walks the brick hierarchy from the coarsest level down to the level the raycaster would
+   use for each visible brick, and records every visited brick inside the view and the clip
+   box.
+   */
+  private func collectVisibleBricks(from pose: Pose, step: Int, into best: inout [Int: Candidate]) {
+    guard let coarsest = levels.indices.last else { return }
+    let clipMin = pose.clipMin
+    let clipMax = pose.clipMax
+    let forward = PrefetchPlanner.normalize(pose.forward)
+    let halfFov = min(Float.pi / 2,
+                      parameters.fieldOfView / 2 * PrefetchPlanner.fieldOfViewMargin)
+
+    // A brick at the current level, identified by its coordinates.
+    var frontier = [SIMD3<Int32>]()
+    let top = levels[coarsest].totalBricks
+    for z in 0..<top.z { for y in 0..<top.y { for x in 0..<top.x {
+      frontier.append(SIMD3<Int32>(x, y, z))
+    } } }
+
+    for levelIndex in stride(from: coarsest, through: 0, by: -1) {
+      let level = levels[levelIndex]
+      var next = [SIMD3<Int32>]()
+      for coords in frontier {
+        // The part of the brick inside the clip box, as in getBrickCorners.
+        let lower = pointwiseMax(SIMD3<Float>(coords) / level.fractionalBrickLayout, clipMin)
+        let upper = pointwiseMin(SIMD3<Float>(coords &+ 1) / level.fractionalBrickLayout,
+                                 pointwiseMin(clipMax, SIMD3<Float>(repeating: 1)))
+        guard all(lower .< upper) else { continue }
+        guard PrefetchPlanner.isVisible(lower: lower, upper: upper, from: pose.position,
+                                        forward: forward, halfFov: halfFov) else {
+          continue
+        }
+
+        let index = level.prevBricks + Int(coords.x) + Int(coords.y) * level.bricksX +
+                    Int(coords.z) * level.bricksXTimesBricksY
+        let closest = pointwiseMin(pointwiseMax(pose.lodPosition, lower), upper)
+        let distance = PrefetchPlanner.length(closest - pose.lodPosition)
+        if best[index] == nil {
+          best[index] = Candidate(index: index, step: step, level: levelIndex, distance: distance)
+          if best.count >= maxPlanSize { return }
+        }
+
+        // Refine where the raycaster would sample a finer level.
+        guard levelIndex > 0 && computeLOD(distance) < levelIndex else { continue }
+        let child = levels[levelIndex - 1]
+        let childLower = SIMD3<Int32>(lower * child.fractionalBrickLayout, rounding: .down)
+        let childUpper = pointwiseMin(
+          SIMD3<Int32>(upper * child.fractionalBrickLayout, rounding: .up),
+          child.totalBricks)
+        for z in childLower.z..<max(childLower.z, childUpper.z) {
+          for y in childLower.y..<max(childLower.y, childUpper.y) {
+            for x in childLower.x..<max(childLower.x, childUpper.x) {
+              next.append(SIMD3<Int32>(x, y, z))
+            }
+          }
+        }
+      }
+      // Neighbouring parents share children at the brick borders.
+      frontier = Array(Set(next))
+    }
+  }
+
+  /**
+   The level the raycaster samples at the given distance, as `computeLOD` in VolumeAtlas.h.
+   */
+  private func computeLOD(_ distance: Float) -> Int {
+    let lod = log2(parameters.lodFactor * distance / parameters.levelZeroWorldSpaceError)
+    guard lod.isFinite, lod > 0 else { return 0 }
+    return min(levels.count - 1, Int(lod))
+  }
+
+  // MARK: - Geometry
+
+  /// Whether a box intersects the view cone, tested with its bounding sphere.
+  private static func isVisible(lower: SIMD3<Float>, upper: SIMD3<Float>,
+                                from eye: SIMD3<Float>, forward: SIMD3<Float>,
+                                halfFov: Float) -> Bool {
+    let center = (lower + upper) / 2
+    let radius = length(upper - lower) / 2
+    let toCenter = center - eye
+    let distance = length(toCenter)
+    if distance <= radius { return true }
+    // Widen the cone by the angle the sphere subtends.
+    let halfAngle = halfFov + asin(radius / distance)
+    if halfAngle >= .pi { return true }
+    return dot(toCenter, forward) >= distance * cos(halfAngle)
+  }
+
+  private static func dot(_ a: SIMD3<Float>, _ b: SIMD3<Float>) -> Float {
+    (a * b).sum()
+  }
+
+  private static func cross(_ a: SIMD3<Float>, _ b: SIMD3<Float>) -> SIMD3<Float> {
+    SIMD3<Float>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x)
+  }
+
+  private static func length(_ a: SIMD3<Float>) -> Float {
+    dot(a, a).squareRoot()
+  }
+
+  private static func normalize(_ a: SIMD3<Float>) -> SIMD3<Float> {
+    let l = length(a)
+    return l > 0 ? a / l : SIMD3<Float>(0, 0, -1)
+  }
+
+  /// Rotates a vector around a unit axis (Rodrigues' formula).
+  private static func rotate(_ v: SIMD3<Float>, around axis: SIMD3<Float>,
+                             by angle: Float) -> SIMD3<Float> {
+    let c = cos(angle)
+    let s = sin(angle)
+    return v * c + cross(axis, v) * s + axis * (dot(axis, v) * (1 - c))
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
@@ -1,7 +1,6 @@
 import Metal
 import Foundation
 import Compression
-import Network
 
 /**
  A remote data source for BorgVR volume data.
@@ -10,8 +9,16 @@ import Network
  connection. It sends commands and receives binary responses, handling decompression when necessary.
  */
 final class RemoteDataSource: DataSource {
-  /// The underlying NWConnection used for communication with the remote server.
-  private var connection: NWConnection
+  /// The connection used for communication with the remote server. `reconnect` replaces it
+  /// while other threads may send control frames, so it is only accessed through `connection`.
+  private var currentConnection: AsyncConnection
+  /// A lock for `currentConnection`.
+  private let connectionLock = NSLock()
+  /// The current connection.
+  private var connection: AsyncConnection {
+    get { connectionLock.withLock { currentConnection } }
+    set { connectionLock.withLock { currentConnection = newValue } }
+  }
   /// The dataset ID for the remote dataset.
   private let datasetID: String
   /// Indicates whether the remote dataset is open.
@@ -28,24 +35,48 @@ final class RemoteDataSource: DataSource {
   /// The expected full size in bytes of a brick.
   private var fullBrickSize: Int
 
+  /// The negotiated wire protocol version, see `WireProtocol`.
+  private let protocolVersion: Int
+  /// The request ID used for the next version 2 request.
+  private var nextRequestID: UInt32 = 1
+  /// The version 2 requests that have been sent but not answered yet, with their priority.
+  private var outstanding: [UInt32: (priority: Int, indices: [Int])] = [:]
+  /// The outstanding request of every brick in `outstanding`, so `promote` finds a brick's
+  /// request without scanning all of them.
+  private var outstandingBricks: [Int: UInt32] = [:]
+  /// A lock for `outstanding` and `outstandingBricks`, which are also accessed by
+  /// `cancelOutstanding` and `promote`.
+  private let outstandingLock = NSLock()
+
+  /// Round trip time and throughput estimates of this connection.
+  let transferEstimator = TransferEstimator()
+
+  /// Indicates whether requests can be pipelined (wire protocol version 2).
+  var supportsPipelining: Bool {
+    protocolVersion >= WireProtocol.version
+  }
+
   /**
    Initializes a new RemoteDataSource with the given connection and dataset ID.
 
    - Parameters:
-   - connection: The NWConnection to the remote server.
+   - connection: The connection to the remote server.
    - datasetID: The identifier for the dataset to open.
+   - protocolVersion: The negotiated wire protocol version (default is `1`).
    - Throws: An error if sending the "OPEN" command fails or if metadata cannot be parsed.
    */
-  init(connection: NWConnection, datasetID: String, logger: LoggerBase?) throws {
-    self.connection = connection
+  init(connection: AsyncConnection, datasetID: String, protocolVersion: Int = 1,
+       logger: LoggerBase?) throws {
+    self.currentConnection = connection
     self.datasetID = datasetID
     self.isOpen = false
     self.logger = logger
+    self.protocolVersion = protocolVersion
 
-    // Send the OPEN command to the server with the dataset ID.
-    try RemoteDataSource.sendCommand("OPEN \(datasetID)", connection: connection)
-    // Receive the binary response containing the metadata.
-    let responseData = try RemoteDataSource.receiveBinaryData(connection: connection)
+    // Open the dataset and receive its metadata.
+    let responseData = try RemoteDataSource.open(datasetID: datasetID,
+                                                 protocolVersion: protocolVersion,
+                                                 connection: connection)
 
     // Parse the metadata from the received data.
     self.metadata = try BORGVRMetaData(fromData: responseData)
@@ -73,7 +104,25 @@ final class RemoteDataSource: DataSource {
     // Clean up allocated buffers and cancel the connection.
     compressionScratchBuffer?.deallocate()
     compressedDataBuffer?.deallocate()
-    connection.cancel()
+    currentConnection.cancel()
+  }
+
+  /**
+   Opens another connection to the same server and dataset, e.g. to download in parallel.
+
+   - Parameter timeout: The connection timeout in seconds.
+   - Returns: A new RemoteDataSource with its own connection.
+   - Throws: An error if connecting or opening the dataset fails.
+   */
+  func openAdditionalConnection(timeout: Double = 2) throws -> RemoteDataSource {
+    let connection = self.connection
+    let newConnection = try AsyncConnection.blocking {
+      try await connection.reconnected(timeout: timeout)
+    }
+    return try RemoteDataSource(connection: newConnection,
+                                datasetID: datasetID,
+                                protocolVersion: protocolVersion,
+                                logger: logger)
   }
 
   /**
@@ -87,15 +136,257 @@ final class RemoteDataSource: DataSource {
    */
   func getRawBricks(indices: [Int], outputBuffer: UnsafeMutablePointer<UInt8>,
                     outputBufferSize: Int) throws -> [BrickMetadata] {
-    let command = "GETBRICKS " + indices.map { String($0) }.joined(separator: " ")
-    try sendCommand(command)
-    let responseData = try receiveBinaryData()
+    let responseData = try fetchRawBricks(indices: indices)
     if responseData.count > outputBufferSize {
       throw BORGVRDataError.networkError(message: "Received data size does not match expected size.")
     }
     responseData.copyBytes(to: outputBuffer, count: responseData.count)
     return indices.map { metadata.brickMetadata[$0] }
   }
+
+  /**
+   Loads several batches of raw bricks, keeping all requests in flight at the same time.
+
+   With wire protocol version 2, all batches are sent at once and the responses are handled
+   in the order they arrive, so the round trip time is paid once rather than once per batch.
+   Requests that are still queued on the server can be dropped with `cancelOutstanding` or
+   moved ahead with `promote` while this call waits. With version 1, the batches are
+   requested one after another and the priority is ignored.
+
+   - Parameters:
+   - batches: The brick indices of each request. Each batch must not exceed the server's
+   maximum number of bricks per request.
+   - priorities: The priority of each batch, `WireProtocol.demandPriority` or
+   `WireProtocol.prefetchPriority`. If `nil`, all batches are demand requests.
+   - handler: Called once per batch with its indices, the brick metadata, and the
+   concatenated raw brick data. With version 2 it runs on the task that receives the
+   responses while the calling thread waits.
+   - Returns: The batches that were cancelled before the server sent them.
+   - Throws: An error if a request fails or the handler throws.
+   */
+  @discardableResult
+  func getRawBricksPipelined(
+    batches: [[Int]],
+    priorities: [Int]? = nil,
+    handler: (_ indices: [Int], _ brickMeta: [BrickMetadata], _ data: Data) throws -> Void
+  ) throws -> [[Int]] {
+    guard supportsPipelining else {
+      for batch in batches {
+        let data = try fetchRawBricks(indices: batch)
+        try handler(batch, batch.map { metadata.brickMetadata[$0] }, data)
+      }
+      return []
+    }
+
+    var pending: [UInt32: [Int]] = [:]
+    var requests: [UInt32: (priority: Int, indices: [Int])] = [:]
+    var frames = Data()
+    for (i, batch) in batches.enumerated() where !batch.isEmpty {
+      let priority = priorities?[i] ?? WireProtocol.demandPriority
+      let requestID = nextRequestID
+      nextRequestID &+= 1
+      pending[requestID] = batch
+      requests[requestID] = (priority, batch)
+      frames.append(try WireProtocol.frame(.getBricks, requestID: requestID,
+                                           payload: WireProtocol.encodeGetBricks(indices: batch,
+                                                                                 priority: priority)))
+    }
+    outstandingLock.withLock {
+      outstanding = requests
+      outstandingBricks.removeAll(keepingCapacity: true)
+      for (requestID, request) in requests {
+        for index in request.indices {
+          outstandingBricks[index] = requestID
+        }
+      }
+    }
+    defer {
+      outstandingLock.withLock {
+        outstanding.removeAll()
+        outstandingBricks.removeAll(keepingCapacity: true)
+      }
+    }
+    try sendFrames(frames)
+
+    // The whole round is received in one task, rather than paying for a task and a
+    // semaphore per response.
+    let connection = self.connection
+    return try withoutActuallyEscaping(handler) { handler in
+      try AsyncConnection.blocking { [pending] in
+        try await self.receiveResponses(pending: pending, connection: connection, handler: handler)
+      }
+    }
+  }
+
+  /**
+   Receives the responses to pipelined requests until every request has been answered, and
+   records the round in the transfer estimator.
+
+   - Parameters:
+   - pending: The brick indices of the requests that were sent, by request ID.
+   - connection: The connection the requests were sent on.
+   - handler: Called once per answered request, see `getRawBricksPipelined`.
+   - Returns: The batches that were cancelled before the server sent them.
+   - Throws: An error if receiving fails, the server reports an error, or the handler throws.
+   */
+  private func receiveResponses(
+    pending: [UInt32: [Int]],
+    connection: AsyncConnection,
+    handler: (_ indices: [Int], _ brickMeta: [BrickMetadata], _ data: Data) throws -> Void
+  ) async throws -> [[Int]] {
+    var pending = pending
+    let roundStart = Date()
+    var firstResponseDelay: Double?
+    var firstResponseBytes = 0
+    var roundBytes = 0
+
+    var cancelled: [[Int]] = []
+    while !pending.isEmpty {
+      let (header, payload) = try await connection.receiveFrame()
+
+      // Responses to requests that were abandoned after an earlier error are skipped.
+      guard let batch = pending.removeValue(forKey: header.requestID) else { continue }
+      outstandingLock.withLock {
+        _ = outstanding.removeValue(forKey: header.requestID)
+        for index in batch where outstandingBricks[index] == header.requestID {
+          outstandingBricks.removeValue(forKey: index)
+        }
+      }
+
+      switch header.type {
+        case .bricks:
+          let brickMeta = batch.map { metadata.brickMetadata[$0] }
+          let expectedSize = brickMeta.reduce(0) { $0 + $1.size }
+          guard payload.count == expectedSize else {
+            throw BORGVRDataError.networkError(
+              message: "Received \(payload.count) bytes for request \(header.requestID), expected \(expectedSize).")
+          }
+          if firstResponseDelay == nil {
+            firstResponseDelay = Date().timeIntervalSince(roundStart)
+            firstResponseBytes = payload.count
+          }
+          roundBytes += payload.count
+          try handler(batch, brickMeta, payload)
+        case .cancelled:
+          cancelled.append(batch)
+        case .error:
+          throw BORGVRDataError.networkError(message: String(decoding: payload, as: UTF8.self))
+        default:
+          throw WireProtocol.Error.malformedFrame("unexpected message type \(header.type)")
+      }
+    }
+
+    if let firstResponseDelay = firstResponseDelay {
+      transferEstimator.recordRound(duration: Date().timeIntervalSince(roundStart),
+                                    bytes: roundBytes,
+                                    firstResponseDelay: firstResponseDelay,
+                                    firstResponseBytes: firstResponseBytes)
+    }
+    return cancelled
+  }
+
+  /**
+   Asks the server to drop the outstanding requests of the given priority that it has not
+   sent yet. The dropped requests are reported by `getRawBricksPipelined`.
+
+   Can be called from any thread while another thread waits in `getRawBricksPipelined`.
+   Does nothing with wire protocol version 1.
+
+   - Parameters:
+   - priority: The priority of the requests to cancel.
+   - keeping: Bricks that are still needed; requests containing any of them are kept.
+   */
+  func cancelOutstanding(priority: Int, keeping: Set<Int> = []) {
+    guard supportsPipelining else { return }
+    let requestIDs = outstandingLock.withLock {
+      let kept = Set(keeping.compactMap { outstandingBricks[$0] })
+      return outstanding.filter { $0.value.priority == priority && !kept.contains($0.key) }
+        .map { $0.key }
+    }
+    guard !requestIDs.isEmpty else { return }
+    sendControlFrame(.cancel, payload: WireProtocol.encodeCancel(requestIDs: requestIDs.sorted()))
+  }
+
+  /**
+   Moves an outstanding background request that contains the given brick ahead of the other
+   background requests, because the renderer is now waiting for that brick.
+
+   Can be called from any thread. Does nothing if no such request exists or with wire protocol
+   version 1.
+
+   - Parameter index: The index of the brick.
+   - Returns: `true` if an outstanding request contains the brick.
+   */
+  @discardableResult
+  func promote(index: Int) -> Bool {
+    guard supportsPipelining else { return false }
+    var requestID: UInt32?
+    var found = false
+    outstandingLock.withLock {
+      guard let id = outstandingBricks[index], let request = outstanding[id] else { return }
+      found = true
+      if request.priority != WireProtocol.demandPriority {
+        outstanding[id] = (WireProtocol.demandPriority, request.indices)
+        requestID = id
+      }
+    }
+    if let requestID = requestID {
+      sendControlFrame(.reprioritize,
+                       payload: WireProtocol.encodeReprioritize([(requestID, WireProtocol.demandPriority)]))
+    }
+    return found
+  }
+
+  /**
+   Sends a version 2 control frame without waiting for it to be processed. Control frames are
+   hints, so a failure only gets logged; broken connections are detected by the pending request.
+
+   - Parameters:
+   - type: The message type, `cancel` or `reprioritize`.
+   - payload: The encoded payload.
+   */
+  private func sendControlFrame(_ type: WireProtocol.MessageType, payload: Data) {
+    let frame: Data
+    do {
+      frame = try WireProtocol.frame(type, requestID: 0, payload: payload)
+    } catch {
+      logger?.warning("Failed to send \(type) frame: \(error.localizedDescription)")
+      return
+    }
+    connection.sendDetached(frame) { [logger] error in
+      logger?.warning("Failed to send \(type) frame: \(error)")
+    }
+  }
+
+  /**
+   Requests a batch of raw bricks and returns the concatenated brick data.
+
+   - Parameter indices: The indices of the bricks to load.
+   - Returns: The raw data of all bricks in request order.
+   - Throws: An error if the request fails.
+   */
+  private func fetchRawBricks(indices: [Int]) throws -> Data {
+    if supportsPipelining {
+      var result: Data?
+      try getRawBricksPipelined(batches: [indices]) { _, _, data in
+        result = data
+      }
+      guard let result = result else {
+        throw BORGVRDataError.networkError(message: "Request was cancelled")
+      }
+      return result
+    }
+
+    let command = "GETBRICKS " + indices.map { String($0) }.joined(separator: " ")
+    try sendCommand(command)
+    let start = Date()
+    let data = try receiveBinaryData()
+    let duration = Date().timeIntervalSince(start)
+    transferEstimator.recordRound(duration: duration, bytes: data.count,
+                                  firstResponseDelay: duration, firstResponseBytes: data.count)
+    return data
+  }
+
   /**
    Loads the first brick from the remote dataset into the provided output buffer.
    In contrast to getBrick, this call is always synchronous.
@@ -122,8 +413,7 @@ final class RemoteDataSource: DataSource {
   func getBrick(index: Int, outputBuffer: UnsafeMutablePointer<UInt8>) throws {
     let brickMeta = metadata.brickMetadata[index]
 
-    try sendCommand("GETBRICKS \(index)")
-    let responseData = try receiveBinaryData()
+    let responseData = try fetchRawBricks(indices: [index])
 
     if metadata.compression && brickMeta.size < fullBrickSize {
       guard let compBuffer = compressedDataBuffer, let scratchBuffer = compressionScratchBuffer else {
@@ -154,31 +444,12 @@ final class RemoteDataSource: DataSource {
 
    - Parameters:
    - command: The command string to send.
-   - connection: The NWConnection to use.
-   - Throws: A BORGVRDataError.networkError if sending fails.
+   - connection: The connection to use.
+   - Throws: A BORGVRRemoteDataManagerError if sending fails or times out.
    */
-  static private func sendCommand(_ command: String, connection: NWConnection) throws {
-    let semaphore = DispatchSemaphore(value: 0)
-    var sendError: Error?
-
-    let terminatedCommand = command + "\n"
-    guard let commandData = terminatedCommand.data(using: .utf8) else {
-      throw BORGVRRemoteDataManagerError.sendFailed(
-        NSError(domain: "Encoding", code: 1, userInfo: [NSLocalizedDescriptionKey: "Failed to encode command"])
-      )
-    }
-
-    connection.send(content: commandData, completion: .contentProcessed({ error in
-      sendError = error
-      semaphore.signal()
-    }))
-
-    let result = semaphore.wait(timeout: .now() + 5)
-    if result == .timedOut {
-      throw BORGVRRemoteDataManagerError.timeout(seconds: 5)
-    }
-    if let error = sendError {
-      throw BORGVRRemoteDataManagerError.sendFailed(error)
+  static private func sendCommand(_ command: String, connection: AsyncConnection) throws {
+    try AsyncConnection.blocking {
+      try await connection.sendCommand(command)
     }
   }
 
@@ -192,86 +463,110 @@ final class RemoteDataSource: DataSource {
     do {
       try RemoteDataSource.sendCommand(command, connection: connection)
     } catch {
-      if case let .hostPort(host, port) = connection.endpoint {
-        let newConnection = NWConnection(host: host,
-                                            port: port,
-                                            using: .tcp)
-        try BORGVRRemoteDataManager.connect(connection: newConnection,
-                                            timeout: 2, logger: logger)
-        connection = newConnection
-        try sendCommand("OPEN \(datasetID)")
-        _ = try receiveBinaryData()
-      } else {
-        throw error
-      }
+      try reconnect(after: error)
+      try RemoteDataSource.sendCommand(command, connection: connection)
     }
   }
 
   /**
-   Receives binary data from the remote server using the current connection.
+   Sends pre-built version 2 frames using the current connection, reconnecting once on failure.
 
-   - Returns: The received Data.
-   - Throws: A network error if data reception fails.
+   - Parameter frames: One or more complete frames.
+   - Throws: An error if sending fails.
    */
-  private func receiveBinaryData() throws -> Data {
-    return try RemoteDataSource.receiveBinaryData(connection: connection)
+  private func sendFrames(_ frames: Data) throws {
+    do {
+      try RemoteDataSource.send(frames, connection: connection)
+    } catch {
+      try reconnect(after: error)
+      try RemoteDataSource.send(frames, connection: connection)
+    }
   }
 
   /**
-   Receives binary data from the specified connection.
+   Replaces a broken connection with a new one to the same endpoint and reopens the dataset.
 
-   The function first reads a 4-byte size prefix, then receives a payload of that size.
-
-   - Parameter connection: The NWConnection to receive data from.
-   - Returns: The received Data payload.
-   - Throws: A network error if reception times out or fails.
+   - Parameter error: The error that made the old connection unusable.
+   - Throws: An error if the endpoint cannot be reconnected or reconnecting fails.
    */
-  static private func receiveBinaryData(connection: NWConnection) throws -> Data {
-    var receivedData: Data?
-    var sendError: BORGVRDataError?
-
-    // Receive the size prefix (4 bytes for UInt32).
-    let sizeSemaphore = DispatchSemaphore(value: 0)
-    var dataSize: UInt32 = 0
-    connection.receive(minimumIncompleteLength: 4, maximumLength: 4) { sizeData, _, _, error in
-      defer { sizeSemaphore.signal() }
-      guard let sizeData = sizeData, sizeData.count == 4 else {
-        sendError = .networkError(message: "Missing size prefix")
-        return
-      }
-      dataSize = sizeData.withUnsafeBytes { $0.load(as: UInt32.self) }
+  private func reconnect(after error: Error) throws {
+    logger?.warning("Reconnecting after: \(error)")
+    let oldConnection = connection
+    let newConnection = try AsyncConnection.blocking {
+      try await oldConnection.reconnected(timeout: 2)
     }
+    oldConnection.cancel()
+    // Control frames may only go out once the new connection speaks the framed protocol.
+    _ = try RemoteDataSource.open(datasetID: datasetID,
+                                  protocolVersion: protocolVersion,
+                                  connection: newConnection)
+    connection = newConnection
+  }
 
-    if sizeSemaphore.wait(timeout: .now() + 15) == .timedOut {
-      throw BORGVRDataError.networkError(message: "Timeout while waiting for data size")
+  /**
+   Blocking variant of `open(datasetID:protocolVersion:connection:) async`.
+   */
+  static private func open(datasetID: String, protocolVersion: Int,
+                           connection: AsyncConnection) throws -> Data {
+    try AsyncConnection.blocking {
+      try await open(datasetID: datasetID, protocolVersion: protocolVersion,
+                     connection: connection)
     }
+  }
 
-    // Receive the payload.
-    let dataSemaphore = DispatchSemaphore(value: 0)
-    connection.receive(minimumIncompleteLength: Int(dataSize), maximumLength: Int(dataSize)) { data, _, _, error in
-      defer {
-        dataSemaphore.signal()
+  /**
+   Opens a dataset on the given connection and switches the connection to the binary framed
+   protocol if both sides support it.
 
-      }
-      if let data = data {
-        receivedData = data
-      } else if let error = error {
-        sendError = .networkError(message: "Failed to receive data: \(error)")
+   - Parameters:
+   - datasetID: The identifier of the dataset to open.
+   - protocolVersion: The negotiated wire protocol version.
+   - connection: The connection to use.
+   - Returns: The serialized dataset metadata.
+   - Throws: A network error if opening or switching fails.
+   */
+  static func open(datasetID: String, protocolVersion: Int,
+                   connection: AsyncConnection) async throws -> Data {
+    try await connection.sendCommand("OPEN \(datasetID)")
+    let metadata = try await connection.receiveBinaryResponse()
+
+    if protocolVersion >= WireProtocol.version {
+      try await connection.sendCommand(WireProtocol.switchCommand)
+      let acknowledgement = try await connection.receiveBinaryResponse()
+      guard String(decoding: acknowledgement, as: UTF8.self) == WireProtocol.switchAcknowledgement else {
+        throw BORGVRDataError.networkError(message: "Server refused protocol version \(WireProtocol.version)")
       }
     }
+    return metadata
+  }
 
-    if dataSemaphore.wait(timeout: .now() + 50) == .timedOut {
-      throw BORGVRDataError.networkError(message: "Timeout while waiting for data")
-    }
+  /**
+   Sends raw bytes over the provided connection.
 
-    if let error = sendError {
-      throw error
+   - Parameters:
+   - data: The bytes to send.
+   - connection: The connection to use.
+   - Throws: A BORGVRRemoteDataManagerError if sending fails or times out.
+   */
+  static private func send(_ data: Data, connection: AsyncConnection) throws {
+    try AsyncConnection.blocking {
+      try await connection.send(data)
     }
+  }
+
+  /**
+   Receives binary data from the remote server using the current connection.
 
-    guard let result = receivedData else {
-      throw BORGVRDataError.networkError(message: "Data was nil after receive")
+   The response consists of a 4-byte size prefix followed by a payload of that size.
+
+   - Returns: The received Data.
+   - Throws: A network error if data reception fails.
+   */
+  private func receiveBinaryData() throws -> Data {
+    let connection = self.connection
+    return try AsyncConnection.blocking {
+      try await connection.receiveBinaryResponse()
     }
-    return result
   }
 
   /**
@@ -0,0 +1,205 @@
+import Foundation
+
+/**
+ Estimates round trip time and throughput of a connection from completed brick requests, and
+ derives request sizes from them.
+
+ Brick requests are sized in bytes rather than brick counts. Compressed bricks vary widely in
+ size, so a fixed count gives some requests that are tiny and others that block the
+ connection for seconds. A request is sized so that it takes about `latencyBudget` seconds
+ to transfer at the estimated throughput. A round of pipelined requests is sized to keep the
+ link busy for a round trip plus that budget.
+
+ All members are thread-safe.
+ */
+final class TransferEstimator {
+
+  /// A snapshot of the current estimates.
+  struct Metrics {
+    /// The smoothed round trip time in seconds.
+    let smoothedRTT: Double
+    /// The smallest round trip time observed recently, in seconds.
+    let minRTT: Double
+    /// The smoothed throughput in bytes per second.
+    let throughput: Double
+    /// The number of rounds the estimates are based on.
+    let sampleCount: Int
+    /// The total number of payload bytes received.
+    let totalBytes: Int
+  }
+
+  /// The EWMA gain for RTT samples (as in TCP).
+  private static let rttGain = 0.125
+  /// The EWMA gain for throughput samples.
+  private static let throughputGain = 0.25
+  /// The number of RTT samples the minimum is taken over.
+  private static let minRTTWindow = 16
+  /// Transfers shorter than this are too noisy to estimate throughput from.
+  private static let minThroughputInterval = 0.005
+
+  /// The smallest request size the controller chooses, in bytes.
+  let minBatchBytes: Int
+  /// The largest request size the controller chooses, in bytes.
+  let maxBatchBytes: Int
+
+  private let lock = NSLock()
+  private var smoothedRTT: Double
+  private var recentRTTs: [Double] = []
+  private var throughput: Double
+  private var sampleCount = 0
+  private var totalBytes = 0
+
+  /**
+   Initializes an estimator with conservative guesses that are replaced by the first samples.
+
+   - Parameters:
+   - initialRTT: The assumed round trip time in seconds.
+   - initialThroughput: The assumed throughput in bytes per second.
+   - minBatchBytes: The smallest request size in bytes.
+   - maxBatchBytes: The largest request size in bytes.
+   */
+  init(initialRTT: Double = 0.05, initialThroughput: Double = 4_000_000,
+       minBatchBytes: Int = 64 * 1024, maxBatchBytes: Int = 64 * 1024 * 1024) {
+    self.smoothedRTT = initialRTT
+    self.throughput = initialThroughput
+    self.minBatchBytes = minBatchBytes
+    self.maxBatchBytes = max(minBatchBytes, maxBatchBytes)
+  }
+
+  /// The current estimates.
+  var metrics: Metrics {
+    lock.withLock {
+      Metrics(smoothedRTT: smoothedRTT,
+              minRTT: recentRTTs.min() ?? smoothedRTT,
+              throughput: throughput,
+              sampleCount: sampleCount,
+              totalBytes: totalBytes)
+    }
+  }
+
+  /**
+   Records one round of requests, from sending them until the last response was received.
+
+   The round trip time is estimated from the first response, minus the time its payload
+   took at the current throughput estimate. The throughput is estimated from the whole round
+   minus the minimum round trip time.
+
+   - Parameters:
+   - duration: The time from sending the requests until the last response, in seconds.
+   - bytes: The payload bytes of all responses.
+   - firstResponseDelay: The time from sending the requests until the first response was
+   complete, in seconds.
+   - firstResponseBytes: The payload bytes of the first response.
+   */
+  func recordRound(duration: Double, bytes: Int,
+                   firstResponseDelay: Double, firstResponseBytes: Int) {
+    lock.withLock {
+      let rttSample = max(0.1 * firstResponseDelay,
+                          firstResponseDelay - Double(firstResponseBytes) / throughput)
+      if sampleCount == 0 {
+        smoothedRTT = rttSample
+      } else {
+        smoothedRTT += TransferEstimator.rttGain * (rttSample - smoothedRTT)
+      }
+      recentRTTs.append(rttSample)
+      if recentRTTs.count > TransferEstimator.minRTTWindow {
+        recentRTTs.removeFirst()
+      }
+
+      let transferDuration = duration - (recentRTTs.min() ?? rttSample)
+      if transferDuration >= TransferEstimator.minThroughputInterval && bytes > 0 {
+        let sample = Double(bytes) / transferDuration
+        if sampleCount == 0 {
+          throughput = sample
+        } else {
+          throughput += TransferEstimator.throughputGain * (sample - throughput)
+        }
+      }
+      sampleCount += 1
+      totalBytes += bytes
+    }
+  }
+
+  // MARK: - Batch Size Control
+
+  /**
+   The size of a single request that transfers in about `latencyBudget` seconds.
+
+   - Parameter latencyBudget: The time a request may occupy the connection, in seconds.
+   - Returns: The request size in bytes.
+   */
+  func batchBytes(latencyBudget: Double) -> Int {
+    let estimate = lock.withLock { throughput * latencyBudget }
+    return clamp(estimate)
+  }
+
+  /**
+   The number of bytes to request per round so the connection stays busy while the next
+   round is prepared: the bandwidth-delay product plus one latency budget.
+
+   - Parameter latencyBudget: The time a single request may occupy the connection, in seconds.
+   - Returns: The round size in bytes.
+   */
+  func roundBytes(latencyBudget: Double) -> Int {
+    let estimate = lock.withLock {
+      throughput * ((recentRTTs.min() ?? smoothedRTT) + latencyBudget)
+    }
+    return clamp(estimate)
+  }
+
+  /**
+   Splits bricks into requests of at most `targetBytes` and `maxCount` bricks each, keeping
+   their order. A brick larger than `targetBytes` gets a request of its own.
+
+   - Parameters:
+   - indices: The brick indices.
+   - sizes: The size in bytes of each brick, in the same order.
+   - targetBytes: The preferred request size in bytes.
+   - maxCount: The server's limit of bricks per request.
+   - Returns: The requests.
+   */
+  static func split(_ indices: [Int], sizes: [Int], targetBytes: Int, maxCount: Int) -> [[Int]] {
+    var batches: [[Int]] = []
+    var current: [Int] = []
+    var currentBytes = 0
+    for (index, size) in zip(indices, sizes) {
+      if !current.isEmpty && (currentBytes + size > targetBytes || current.count == maxCount) {
+        batches.append(current)
+        current = []
+        currentBytes = 0
+      }
+      current.append(index)
+      currentBytes += size
+    }
+    if !current.isEmpty {
+      batches.append(current)
+    }
+    return batches
+  }
+
+  private func clamp(_ bytes: Double) -> Int {
+    guard bytes.isFinite else { return maxBatchBytes }
+    return min(maxBatchBytes, max(minBatchBytes, Int(bytes)))
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,366 @@
+import Foundation
+
+/**
+ Definitions shared by client and server for the binary framed wire protocol (version 2).
+
+ Version 1 of the protocol consists of newline-terminated text commands and allows only one
+ request in flight per connection. Version 2 replaces that, after an explicit switch, with
+ binary frames that carry a request ID. A client can pipeline many requests, and responses
+ may arrive in any order.
+
+ Negotiation:
+ 1. The server announces the versions it speaks in the `INFO` response (`PROTOCOLS 1,2`).
+    Servers that only speak version 1 omit the key.
+ 2. After `OPEN`, a client that wants version 2 sends the text command `PROTOCOL 2`.
+ 3. The server answers with a version 1 binary response containing `OK` and from then on
+    reads and writes only version 2 frames on that connection.
+
+ Every frame starts with a fixed 12 byte little-endian header:
+
+ | Offset | Size | Field                                  |
+ |--------|------|----------------------------------------|
+ | 0      | 1    | message type (`MessageType`)           |
+ | 1      | 1    | flags (reserved, zero)                 |
+ | 2      | 2    | reserved, zero                         |
+ | 4      | 4    | request ID                             |
+ | 8      | 4    | payload length in bytes                |
+
+ Brick index lists are encoded as a varint count followed by the zigzag varint deltas of the
+ indices, so the runs of neighboring bricks that clients typically request take about one byte
+ per brick.
+
+ Every `getBricks` request carries a priority; lower values are sent first. The server queues
+ responses per connection and only hands a few of them to the network stack at a time, so a
+ client can still `cancel` or `reprioritize` requests whose responses have not been sent yet.
+ */
+enum WireProtocol {
+
+  /// The protocol version implemented by this file.
+  static let version = 2
+
+  /// The text command that switches a version 1 connection to version 2.
+  static let switchCommand = "PROTOCOL \(version)"
+
+  /// The payload of the server's version 1 response that acknowledges the switch.
+  static let switchAcknowledgement = "OK"
+
+  /// The `INFO` key that lists the protocol versions a server speaks.
+  static let infoKey = "PROTOCOLS"
+
+  /// Upper bound for a response payload, to reject corrupt headers before allocating memory.
+  static let maxPayloadLength = 1 << 30
+
+  /// Upper bound for a request payload. Requests only carry index lists, so the server can
+  /// reject much smaller frames than the client before it allocates the payload.
+  static let maxRequestPayloadLength = 1 << 20
+
+  /// The priority of bricks the renderer is waiting for.
+  static let demandPriority = 0
+
+  /// The priority of bricks that are fetched in the background.
+  static let prefetchPriority = 1
+
+  // MARK: - Errors
+
+  enum Error: Swift.Error, LocalizedError {
+    case malformedFrame(String)
+    case unknownMessageType(UInt8)
+    case payloadTooLarge(Int)
+    case indexOutOfRange(Int)
+
+    var errorDescription: String? {
+      switch self {
+        case .malformedFrame(let reason):
+          return "Malformed protocol frame: \(reason)"
+        case .unknownMessageType(let type):
+          return "Unknown protocol message type \(type)."
+        case .payloadTooLarge(let length):
+          return "Protocol frame payload of \(length) bytes exceeds the limit."
+        case .indexOutOfRange(let index):
+          return "Index \(index) in protocol frame is out of range."
+      }
+    }
+  }
+
+  // MARK: - Messages
+
+  /// The message types of version 2. Client requests use the lower half of the value range,
+  /// server responses the upper half.
+  enum MessageType: UInt8 {
+    /// Client → server: payload is an index list and a varint priority, response is `bricks`
+    /// (or `cancelled`) with the same request ID.
+    case getBricks = 0x01
+    /// Client → server: payload is a list of request IDs, an empty list means all requests.
+    /// Requests whose response has not been handed to the network yet are dropped and answered
+    /// with `cancelled`. The header's request ID is unused.
+    case cancel = 0x02
+    /// Client → server: payload is a list of (request ID, priority) pairs. Unknown or already
+    /// sent requests are ignored. The header's request ID is unused.
+    case reprioritize = 0x03
+    /// Server → client: payload is the raw bricks in the order they were requested.
+    case bricks = 0x81
+    /// Server → client: payload is a UTF-8 error message for the request ID.
+    case error = 0x82
+    /// Server → client: the request was cancelled, the payload is empty.
+    case cancelled = 0x83
+
+    /// Indicates whether clients send this message type.
+    var isRequest: Bool { rawValue < 0x80 }
+
+    /// The largest payload a frame of this type may carry.
+    var maxPayloadLength: Int {
+      isRequest ? WireProtocol.maxRequestPayloadLength : WireProtocol.maxPayloadLength
+    }
+  }
+
+  /// A frame header.
+  struct FrameHeader: Equatable {
+    static let size = 12
+
+    let type: MessageType
+    let requestID: UInt32
+    let payloadLength: Int
+
+    /**
+     Serializes the header.
+
+     - Returns: The encoded header.
+     - Throws: `WireProtocol.Error.payloadTooLarge` if the payload exceeds the limit of the
+     message type.
+     */
+    func encode() throws -> Data {
+      guard (0...type.maxPayloadLength).contains(payloadLength) else {
+        throw Error.payloadTooLarge(payloadLength)
+      }
+      var data = Data(capacity: FrameHeader.size)
+      data.append(type.rawValue)
+      data.append(0) // flags
+      data.append(Data(from: UInt16(0).littleEndian))
+      data.append(Data(from: requestID.littleEndian))
+      data.append(Data(from: UInt32(payloadLength).littleEndian))
+      return data
+    }
+
+    /**
+     Parses a header.
+
+     - Parameter data: Exactly `FrameHeader.size` bytes.
+     - Throws: `WireProtocol.Error` if the header is malformed.
+     */
+    init(from data: Data) throws {
+      guard data.count == FrameHeader.size else {
+        throw Error.malformedFrame("header has \(data.count) bytes")
+      }
+      let bytes = [UInt8](data)
+      guard let type = MessageType(rawValue: bytes[0]) else {
+        throw Error.unknownMessageType(bytes[0])
+      }
+      func readUInt32(_ offset: Int) -> UInt32 {
+        (0..<4).reduce(UInt32(0)) { $0 | UInt32(bytes[offset + $1]) << (8 * $1) }
+      }
+      let payloadLength = Int(readUInt32(8))
+      guard payloadLength <= type.maxPayloadLength else {
+        throw Error.payloadTooLarge(payloadLength)
+      }
+      self.type = type
+      self.requestID = readUInt32(4)
+      self.payloadLength = payloadLength
+    }
+
+    init(type: MessageType, requestID: UInt32, payloadLength: Int) {
+      self.type = type
+      self.requestID = requestID
+      self.payloadLength = payloadLength
+    }
+  }
+
+  /// Builds a complete frame from a message type, request ID and payload. Throws
+  /// `WireProtocol.Error.payloadTooLarge` if the payload exceeds the limit of the type.
+  static func frame(_ type: MessageType, requestID: UInt32, payload: Data = Data()) throws -> Data {
+    var data = try FrameHeader(type: type, requestID: requestID,
+                               payloadLength: payload.count).encode()
+    data.append(payload)
+    return data
+  }
+
+  // MARK: - Varints
+
+  /// Appends an unsigned LEB128 varint.
+  static func appendVarint(_ value: UInt64, to data: inout Data) {
+    var value = value
+    while value >= 0x80 {
+      data.append(UInt8(truncatingIfNeeded: value) | 0x80)
+      value >>= 7
+    }
+    data.append(UInt8(value))
+  }
+
+  /// Reads an unsigned LEB128 varint starting at `offset` and advances `offset` past it.
+  static func readVarint(from bytes: [UInt8], offset: inout Int) throws -> UInt64 {
+    var result: UInt64 = 0
+    var shift: UInt64 = 0
+    while offset < bytes.count {
+      let byte = bytes[offset]
+      offset += 1
+      guard shift < 64 else { throw Error.malformedFrame("varint too long") }
+      result |= UInt64(byte & 0x7F) << shift
+      if byte & 0x80 == 0 { return result }
+      shift += 7
+    }
+    throw Error.malformedFrame("truncated varint")
+  }
+
+  // MARK: - Index Lists
+
+  /// Appends brick indices as a count followed by zigzag delta varints.
+  static func appendIndexList(_ indices: [Int], to data: inout Data) {
+    appendVarint(UInt64(indices.count), to: &data)
+    var previous = 0
+    for index in indices {
+      let delta = Int64(index - previous)
+      appendVarint(UInt64(bitPattern: (delta << 1) ^ (delta >> 63)), to: &data)
+      previous = index
+    }
+  }
+
+  /**
+   Reads an index list written by `appendIndexList` and advances `offset` past it.
+
+   - Parameters:
+   - bytes: The payload.
+   - offset: The position of the list, moved past it on return.
+   - maxCount: The maximum number of indices accepted.
+   - validRange: The range every index must lie in.
+   - Returns: The indices.
+   - Throws: `WireProtocol.Error.indexOutOfRange` if an index lies outside `validRange`, or
+   another `WireProtocol.Error` if the list is malformed or too long.
+   */
+  static func readIndexList(from bytes: [UInt8], offset: inout Int, maxCount: Int,
+                            validRange: Range<Int>) throws -> [Int] {
+    let count = try readVarint(from: bytes, offset: &offset)
+    guard count <= UInt64(maxCount) else {
+      throw Error.malformedFrame("list with \(count) entries exceeds \(maxCount)")
+    }
+    var indices: [Int] = []
+    indices.reserveCapacity(Int(count))
+    var previous = 0
+    for _ in 0..<count {
+      let zigzag = try readVarint(from: bytes, offset: &offset)
+      let delta = Int64(bitPattern: zigzag >> 1) ^ -Int64(bitPattern: zigzag & 1)
+      let (index, overflow) = previous.addingReportingOverflow(Int(delta))
+      guard !overflow else { throw Error.malformedFrame("index delta overflows") }
+      guard validRange.contains(index) else { throw Error.indexOutOfRange(index) }
+      previous = index
+      indices.append(index)
+    }
+    return indices
+  }
+
+  // MARK: - Payloads
+
+  /// Encodes the payload of a `getBricks` request.
+  static func encodeGetBricks(indices: [Int], priority: Int) -> Data {
+    var data = Data(capacity: indices.count + 8)
+    appendIndexList(indices, to: &data)
+    appendVarint(UInt64(priority), to: &data)
+    return data
+  }
+
+  /**
+   Decodes the payload of a `getBricks` request.
+
+   - Parameters:
+   - data: The payload.
+   - maxCount: The maximum number of indices accepted.
+   - brickCount: The number of bricks in the dataset; every index must be below it.
+   - Returns: The requested brick indices and the request priority.
+   - Throws: `WireProtocol.Error.indexOutOfRange` for an invalid brick index, or another
+   `WireProtocol.Error` if the payload is malformed or the list is too long.
+   */
+  static func decodeGetBricks(_ data: Data, maxCount: Int,
+                              brickCount: Int) throws -> (indices: [Int], priority: Int) {
+    let bytes = [UInt8](data)
+    var offset = 0
+    let indices = try readIndexList(from: bytes, offset: &offset, maxCount: maxCount,
+                                    validRange: 0..<brickCount)
+    let priority = try readVarint(from: bytes, offset: &offset)
+    guard offset == bytes.count, priority <= UInt64(Int32.max) else {
+      throw Error.malformedFrame("invalid getBricks payload")
+    }
+    return (indices, Int(priority))
+  }
+
+  /// Encodes the payload of a `cancel` request.
+  static func encodeCancel(requestIDs: [UInt32]) -> Data {
+    var data = Data()
+    appendIndexList(requestIDs.map { Int($0) }, to: &data)
+    return data
+  }
+
+  /// Decodes the payload of a `cancel` request. An empty result means all requests.
+  static func decodeCancel(_ data: Data) throws -> [UInt32] {
+    let bytes = [UInt8](data)
+    var offset = 0
+    let ids = try readIndexList(from: bytes, offset: &offset, maxCount: bytes.count,
+                                validRange: 0..<Int(UInt32.max) + 1)
+    guard offset == bytes.count else {
+      throw Error.malformedFrame("invalid cancel payload")
+    }
+    return ids.map { UInt32($0) }
+  }
+
+  /// Encodes the payload of a `reprioritize` request.
+  static func encodeReprioritize(_ priorities: [(requestID: UInt32, priority: Int)]) -> Data {
+    var data = Data()
+    appendVarint(UInt64(priorities.count), to: &data)
+    for entry in priorities {
+      appendVarint(UInt64(entry.requestID), to: &data)
+      appendVarint(UInt64(entry.priority), to: &data)
+    }
+    return data
+  }
+
+  /// Decodes the payload of a `reprioritize` request.
+  static func decodeReprioritize(_ data: Data) throws -> [(requestID: UInt32, priority: Int)] {
+    let bytes = [UInt8](data)
+    var offset = 0
+    let count = try readVarint(from: bytes, offset: &offset)
+    guard count <= UInt64(bytes.count) else {
+      throw Error.malformedFrame("invalid reprioritize payload")
+    }
+    var result: [(requestID: UInt32, priority: Int)] = []
+    for _ in 0..<count {
+      let requestID = try readVarint(from: bytes, offset: &offset)
+      let priority = try readVarint(from: bytes, offset: &offset)
+      guard requestID <= UInt64(UInt32.max), priority <= UInt64(Int32.max) else {
+        throw Error.malformedFrame("invalid reprioritize payload")
+      }
+      result.append((UInt32(requestID), Int(priority)))
+    }
+    guard offset == bytes.count else {
+      throw Error.malformedFrame("trailing bytes after reprioritize payload")
+    }
+    return result
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or
+ substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,394 @@
+import Darwin
+import Foundation
+
+// MARK: - SliceStackAccessor
+
+/**
+ Provides read-only access to a volume that is stored as a stack of raw files, one file per
+ z-slice. The slices are presented as a single virtual volume, so the stack can be handed to
+ `BrickedVolumeReorganizer` directly without first concatenating it into one large raw file.
+
+ Slice files are memory-mapped on demand. At most `maxOpenSlices` mappings are kept open at a
+ time; when the limit is reached, the least recently used mapping is released. Slabs of slices
+ can be prefetched in parallel via `prefetch(zRange:)`, which the reorganizer calls before it
+ processes each row of bricks.
+
+ - Note: All slices must have the same dimensions and voxel format.
+ */
+public class SliceStackAccessor: VolumeDataAccessor {
+
+  // MARK: - Error Enumeration
+
+  /**
+   Errors that can occur while accessing a slice stack.
+   */
+  public enum Error: Swift.Error, LocalizedError {
+    /// No slice files were found or provided.
+    case noSlices
+    /// A slice file is smaller than one slice of the volume.
+    case sliceSizeMismatch(String)
+    /// Attempted to read outside the valid voxel bounds.
+    case outOfBoundsAccess
+    /// Attempted to write to the (always read-only) slice stack.
+    case readOnlyAccessViolation
+    /// The requested reinterpretation type size is incompatible with the data size.
+    case incompatibleTypeSize
+
+    /// A localized description for each error case.
+    public var errorDescription: String? {
+      switch self {
+        case .noSlices:
+          return "No slice files found."
+        case .sliceSizeMismatch(let filename):
+          return "The size of slice file \(filename) does not match the expected slice size."
+        case .outOfBoundsAccess:
+          return "Attempted to access data out of bounds."
+        case .readOnlyAccessViolation:
+          return "Slice stacks can only be opened in read-only mode."
+        case .incompatibleTypeSize:
+          return "The total byte count is not compatible with the requested type size."
+      }
+    }
+  }
+
+  // MARK: - Properties
+
+  /// The slice files in z order.
+  public let filenames: [String]
+
+  /// Byte offset within each slice file where the voxel data begins.
+  private let offset: Int
+
+  /// The number of bytes in one slice of the volume.
+  private let sliceByteSize: Int
+
+  /// The maximum number of slice mappings kept open at the same time.
+  private let maxOpenSlices: Int
+
+  /// The currently open slice mappings, keyed by z-index.
+  private var openSlices: [Int: (file: MemoryMappedFile, lastUse: Int)] = [:]
+
+  /// A monotonically increasing counter used to determine the least recently used slice.
+  private var useCounter: Int = 0
+
+  /// Lock protecting `openSlices` and `useCounter`.
+  private let sliceLock = NSLock()
+
+  // MARK: - Initialization
+
+  /**
+   Initializes a new `SliceStackAccessor` from an explicit list of slice files.
+
+   - Parameters:
+   - filenames: Paths to the slice files, ordered by z.
+   - width: The width of each slice in voxels.
+   - height: The height of each slice in voxels.
+   - bytesPerComponent: Number of bytes per data component.
+   - componentCount: Number of components per voxel.
+   - aspect: Physical aspect ratios of the volume (Vec3<Float>).
+   - offset: Byte offset within each slice file where voxel data starts (default is `0`).
+   - maxOpenSlices: The maximum number of simultaneously mapped slices (default is `256`).
+   - Throws:
+   - `Error.noSlices` if `filenames` is empty.
+   - `Error.sliceSizeMismatch` if a slice file is too small.
+   */
+  public init(filenames: [String],
+              width: Int,
+              height: Int,
+              bytesPerComponent: Int,
+              componentCount: Int,
+              aspect: Vec3<Float>,
+              offset: Int = 0,
+              maxOpenSlices: Int = 256) throws {
+    guard !filenames.isEmpty else { throw Error.noSlices }
+
+    self.filenames = filenames
+    self.offset = offset
+    self.sliceByteSize = width * height * bytesPerComponent * componentCount
+    self.maxOpenSlices = max(1, maxOpenSlices)
+
+    super.init(size: Vec3<Int>(x: width, y: height, z: filenames.count),
+               bytesPerComponent: bytesPerComponent,
+               componentCount: componentCount,
+               aspect: aspect,
+               readOnly: true)
+
+    // Validate the slice sizes up front, so conversion does not fail halfway through.
+    let expectedFileSize = sliceByteSize + offset
+    for filename in filenames {
+      let attributes = try FileManager.default.attributesOfItem(atPath: filename)
+      let fileSize = (attributes[.size] as? NSNumber)?.intValue ?? 0
+      guard fileSize >= expectedFileSize else {
+        throw Error.sliceSizeMismatch(filename)
+      }
+    }
+  }
+
+  /**
+   Initializes a new `SliceStackAccessor` from all regular files in a directory.
+
+   The files are ordered using a natural ("Finder-like") sort of their names, so
+   `slice2.raw` comes before `slice10.raw`.
+
+   - Parameters:
+   - directory: The directory containing the slice files.
+   - fileExtension: If set, only files with this extension are used.
+   - width: The width of each slice in voxels.
+   - height: The height of each slice in voxels.
+   - bytesPerComponent: Number of bytes per data component.
+   - componentCount: Number of components per voxel.
+   - aspect: Physical aspect ratios of the volume (Vec3<Float>).
+   - offset: Byte offset within each slice file where voxel data starts (default is `0`).
+   - maxOpenSlices: The maximum number of simultaneously mapped slices (default is `256`).
+   - Throws: An error if the directory cannot be read or the slices are invalid.
+   */
+  public convenience init(directory: String,
+                          fileExtension: String? = nil,
+                          width: Int,
+                          height: Int,
+                          bytesPerComponent: Int,
+                          componentCount: Int,
+                          aspect: Vec3<Float>,
+                          offset: Int = 0,
+                          maxOpenSlices: Int = 256) throws {
+    let directoryURL = URL(fileURLWithPath: directory, isDirectory: true)
+    let files = try FileManager.default.contentsOfDirectory(
+      at: directoryURL,
+      includingPropertiesForKeys: [.isRegularFileKey],
+      options: [.skipsHiddenFiles]
+    )
+    let filenames = files
+      .filter { (try? $0.resourceValues(forKeys: [.isRegularFileKey]).isRegularFile) == true }
+      .filter { fileExtension == nil || $0.pathExtension.lowercased() == fileExtension!.lowercased() }
+      .map { $0.path }
+      .sorted { $0.localizedStandardCompare($1) == .orderedAscending }
+
+    try self.init(filenames: filenames,
+                  width: width,
+                  height: height,
+                  bytesPerComponent: bytesPerComponent,
+                  componentCount: componentCount,
+                  aspect: aspect,
+                  offset: offset,
+                  maxOpenSlices: maxOpenSlices)
+  }
+
+  /**
+   Initializes a new `SliceStackAccessor` from a printf-style filename pattern.
+
+   For example, the pattern `"scan_%04d.raw"` with `firstIndex` 1 and `sliceCount` 3 maps the
+   files `scan_0001.raw`, `scan_0002.raw`, and `scan_0003.raw`.
+
+   - Parameters:
+   - pattern: A filename pattern containing a single integer format specifier.
+   - firstIndex: The index of the first slice.
+   - sliceCount: The number of slices.
+   - width: The width of each slice in voxels.
+   - height: The height of each slice in voxels.
+   - bytesPerComponent: Number of bytes per data component.
+   - componentCount: Number of components per voxel.
+   - aspect: Physical aspect ratios of the volume (Vec3<Float>).
+   - offset: Byte offset within each slice file where voxel data starts (default is `0`).
+   - maxOpenSlices: The maximum number of simultaneously mapped slices (default is `256`).
+   - Throws: An error if the slices are invalid.
+   */
+  public convenience init(pattern: String,
+                          firstIndex: Int,
+                          sliceCount: Int,
+                          width: Int,
+                          height: Int,
+                          bytesPerComponent: Int,
+                          componentCount: Int,
+                          aspect: Vec3<Float>,
+                          offset: Int = 0,
+                          maxOpenSlices: Int = 256) throws {
+    let filenames = (firstIndex..<firstIndex + sliceCount).map {
+      String(format: pattern, $0)
+    }
+    try self.init(filenames: filenames,
+                  width: width,
+                  height: height,
+                  bytesPerComponent: bytesPerComponent,
+                  componentCount: componentCount,
+                  aspect: aspect,
+                  offset: offset,
+                  maxOpenSlices: maxOpenSlices)
+  }
+
+  // MARK: - Slice Cache
+
+  /**
+   Returns the mapping for slice `z`, opening it if necessary and evicting the least
+   recently used mapping if the cache is full.
+
+   The returned mapping stays valid for as long as the caller holds a reference to it,
+   even if it is evicted from the cache in the meantime.
+
+   - Parameter z: The z-index of the slice.
+   - Returns: The memory-mapped slice file.
+   - Throws: `MemoryMappedFile.Error` if the slice cannot be mapped.
+   */
+  private func slice(_ z: Int) throws -> MemoryMappedFile {
+    sliceLock.lock()
+    useCounter += 1
+    if let entry = openSlices[z] {
+      openSlices[z] = (entry.file, useCounter)
+      sliceLock.unlock()
+      return entry.file
+    }
+    sliceLock.unlock()
+
+    // Map outside the lock so that several slices can be opened in parallel.
+    let file = try MemoryMappedFile(filename: filenames[z], readOnly: true)
+
+    sliceLock.lock()
+    defer { sliceLock.unlock() }
+    if let entry = openSlices[z] {
+      // Another thread mapped the slice while we were busy, use that one.
+      return entry.file
+    }
+    if openSlices.count >= maxOpenSlices,
+       let victim = openSlices.min(by: { $0.value.lastUse < $1.value.lastUse })?.key {
+      openSlices[victim] = nil
+    }
+    openSlices[z] = (file, useCounter)
+    return file
+  }
+
+  /**
+   Maps the slices in the given z-range in parallel and asks the kernel to read them ahead.
+
+   Out-of-range slices are ignored. At most `maxOpenSlices` slices are prefetched.
+
+   - Parameter zRange: The range of slices that is about to be read.
+   */
+  public override func prefetch(zRange: Range<Int>) {
+    let clamped = zRange.clamped(to: 0..<size.z)
+    let slices = Array(clamped.prefix(maxOpenSlices))
+    guard !slices.isEmpty else { return }
+
+    DispatchQueue.concurrentPerform(iterations: slices.count) { i in
+      guard let file = try? slice(slices[i]) else { return }
+      _ = madvise(file.mappedMemory, Int(file.fileSize), MADV_WILLNEED)
+    }
+  }
+
+  // MARK: - Data Access
+
+  /**
+   Reads and reinterprets voxel data at the specified coordinate.
+
+   Reads that run past the end of a slice continue in the next slice, just as they would in
+   a single contiguous raw file.
+
+   - Parameters:
+   - x: X-coordinate of the voxel.
+   - y: Y-coordinate of the voxel.
+   - z: Z-coordinate of the voxel.
+   - count: Number of voxels to read (default is `1`).
+   - Returns: An array of type `T` containing the requested voxel data.
+   - Throws:
+   - `Error.outOfBoundsAccess` if the coordinates are outside the volume.
+   - `Error.incompatibleTypeSize` if the byte count does not align with `T`.
+   */
+  public override func getData<T: FixedWidthInteger>(
+    x: Int, y: Int, z: Int, count: Int = 1
+  ) throws -> [T] {
+    guard (0..<size.x).contains(x),
+          (0..<size.y).contains(y),
+          (0..<size.z).contains(z) else {
+      throw Error.outOfBoundsAccess
+    }
+
+    let totalBytes = count * voxelByteSize
+    guard totalBytes % MemoryLayout<T>.size == 0 else {
+      throw Error.incompatibleTypeSize
+    }
+    guard calculateIndex(x: x, y: y, z: z) + totalBytes <= self.totalBytes else {
+      throw Error.outOfBoundsAccess
+    }
+
+    var sliceIndex = z
+    var byteInSlice = ((y * size.x) + x) * voxelByteSize
+
+    // Fast path: the request lies within a single slice.
+    if byteInSlice + totalBytes <= sliceByteSize {
+      let file = try slice(sliceIndex)
+      let buffer = UnsafeRawBufferPointer(
+        start: file.mappedMemory.advanced(by: offset + byteInSlice),
+        count: totalBytes
+      )
+      return Array(buffer.bindMemory(to: T.self))
+    }
+
+    return try [T](unsafeUninitializedCapacity: totalBytes / MemoryLayout<T>.size) {
+      target, initializedCount in
+      let targetBytes = UnsafeMutableRawPointer(target.baseAddress!)
+      var copied = 0
+      while copied < totalBytes {
+        let file = try slice(sliceIndex)
+        let chunk = min(totalBytes - copied, sliceByteSize - byteInSlice)
+        memcpy(targetBytes.advanced(by: copied),
+               file.mappedMemory.advanced(by: offset + byteInSlice),
+               chunk)
+        copied += chunk
+        sliceIndex += 1
+        byteInSlice = 0
+      }
+      initializedCount = totalBytes / MemoryLayout<T>.size
+    }
+  }
+
+  /**
+   Slice stacks are read-only; this method always throws.
+
+   - Throws: `Error.readOnlyAccessViolation`.
+   */
+  public override func setData<T: FixedWidthInteger>(
+    x: Int, y: Int, z: Int, data: [T], count: Int = 1
+  ) throws {
+    throw Error.readOnlyAccessViolation
+  }
+
+  // MARK: - Cleanup
+
+  /**
+   Releases all open slice mappings.
+   */
+  public func close() {
+    sliceLock.withLock {
+      openSlices.removeAll()
+    }
+  }
+
+  // MARK: - CustomStringConvertible
+
+  /// A string representation including the slice count and volume parameters.
+  public override var description: String {
+    "SliceStackAccessor(slices: \(filenames.count), " +
+    "size: \(size), components: \(componentCount), " +
+    "bytes/component: \(bytesPerComponent), offset: \(offset))"
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-
+ Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
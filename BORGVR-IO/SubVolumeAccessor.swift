@@ -0,0 +1,307 @@
+import Foundation
+
+// MARK: - SubVolumeAccessor
+
+/**
+ Presents a region of interest of another volume, optionally decimated by a power of two,
+ as a read-only volume of its own.
+
+ The accessor is fully virtual: no data is copied up front. Every read is translated into
+ reads of the corresponding rows of the source volume, so converting a small region of a
+ huge volume only touches the slabs of the source that intersect the region. Decimation
+ uses the same box filter as `BrickedVolumeReorganizer`'s subsampling, i.e. output voxel
+ `(x, y, z)` is the average of the source voxels in the `factor³` box starting at
+ `(x, y, z) * factor`, clipped to the region.
+ */
+public class SubVolumeAccessor: VolumeDataAccessor {
+
+  // MARK: - Error Enumeration
+
+  /**
+   Errors that can occur while creating or reading a sub-volume.
+   */
+  public enum Error: Swift.Error, LocalizedError {
+    /// The region of interest is empty or not contained in the source volume.
+    case invalidRegion(min: Vec3<Int>, max: Vec3<Int>)
+    /// The decimation factor is not a positive integer.
+    case invalidDecimationFactor(Int)
+    /// Attempted to read outside the valid voxel bounds.
+    case outOfBoundsAccess
+    /// Attempted to write to the read-only sub-volume.
+    case readOnlyAccessViolation
+    /// The requested reinterpretation type size is incompatible with the data size.
+    case incompatibleTypeSize
+
+    /// A localized description for each error case.
+    public var errorDescription: String? {
+      switch self {
+        case .invalidRegion(let min, let max):
+          return "The region \(min) - \(max) is empty or exceeds the source volume."
+        case .invalidDecimationFactor(let factor):
+          return "Invalid decimation factor \(factor)."
+        case .outOfBoundsAccess:
+          return "Attempted to access data out of bounds."
+        case .readOnlyAccessViolation:
+          return "Sub-volumes can only be accessed in read-only mode."
+        case .incompatibleTypeSize:
+          return "The total byte count is not compatible with the requested type size."
+      }
+    }
+  }
+
+  // MARK: - Properties
+
+  /// The volume the region is taken from.
+  public let source: VolumeDataAccessor
+
+  /// The first voxel of the region in source coordinates (inclusive).
+  public let regionMin: Vec3<Int>
+
+  /// The end of the region in source coordinates (exclusive).
+  public let regionMax: Vec3<Int>
+
+  /// The decimation factor along each axis.
+  public let factor: Int
+
+  // MARK: - Initialization
+
+  /**
+   Initializes a new `SubVolumeAccessor`.
+
+   - Parameters:
+   - source: The volume to read from.
+   - regionMin: The first voxel of the region (inclusive). Defaults to the origin.
+   - regionMax: The end of the region (exclusive). Defaults to the size of `source`.
+   - factor: The decimation factor along each axis (default is `1`, no decimation).
+   - Throws:
+   - `Error.invalidRegion` if the region is empty or exceeds the source.
+   - `Error.invalidDecimationFactor` if `factor` is smaller than one.
+   */
+  public init(source: VolumeDataAccessor,
+              regionMin: Vec3<Int>? = nil,
+              regionMax: Vec3<Int>? = nil,
+              factor: Int = 1) throws {
+    let regionMin = regionMin ?? .zero
+    let regionMax = regionMax ?? source.size
+
+    guard regionMin.x >= 0, regionMin.y >= 0, regionMin.z >= 0,
+          regionMax.x <= source.size.x, regionMax.y <= source.size.y, regionMax.z <= source.size.z,
+          regionMin.x < regionMax.x, regionMin.y < regionMax.y, regionMin.z < regionMax.z else {
+      throw Error.invalidRegion(min: regionMin, max: regionMax)
+    }
+    guard factor >= 1 else {
+      throw Error.invalidDecimationFactor(factor)
+    }
+
+    self.source = source
+    self.regionMin = regionMin
+    self.regionMax = regionMax
+    self.factor = factor
+
+    super.init(
+      size: Vec3<Int>(
+        x: (regionMax.x - regionMin.x + factor - 1) / factor,
+        y: (regionMax.y - regionMin.y + factor - 1) / factor,
+        z: (regionMax.z - regionMin.z + factor - 1) / factor
+      ),
+      bytesPerComponent: source.bytesPerComponent,
+      componentCount: source.componentCount,
+      aspect: source.aspect,
+      readOnly: true
+    )
+  }
+
+  // MARK: - Data Access
+
+  /**
+   Forwards the prefetch hint for the source slabs covered by the given slices.
+
+   - Parameter zRange: The range of slices of this volume that will be accessed next.
+   */
+  public override func prefetch(zRange: Range<Int>) {
+    let lower = regionMin.z + zRange.lowerBound * factor
+    let upper = min(regionMax.z, regionMin.z + zRange.upperBound * factor)
+    guard lower < upper else { return }
+    source.prefetch(zRange: lower..<upper)
+  }
+
+  /**
+   Reads and reinterprets voxel data at the specified coordinate.
+
+   Reads that run past the end of a row continue at the start of the next row, just as they
+   would in a contiguous raw volume.
+
+   - Parameters:
+   - x: X-coordinate of the voxel.
+   - y: Y-coordinate of the voxel.
+   - z: Z-coordinate of the voxel.
+   - count: Number of voxels to read (default is `1`).
+   - Returns: An array of type `T` containing the requested voxel data.
+   - Throws:
+   - `Error.outOfBoundsAccess` if the coordinates are outside the volume.
+   - `Error.incompatibleTypeSize` if the byte count does not align with `T`.
+   - Any error thrown by the source volume.
+   */
+  public override func getData<T: FixedWidthInteger>(
+    x: Int, y: Int, z: Int, count: Int = 1
+  ) throws -> [T] {
+    guard (0..<size.x).contains(x),
+          (0..<size.y).contains(y),
+          (0..<size.z).contains(z) else {
+      throw Error.outOfBoundsAccess
+    }
+
+    let byteCount = count * voxelByteSize
+    guard byteCount % MemoryLayout<T>.size == 0 else {
+      throw Error.incompatibleTypeSize
+    }
+    guard calculateIndex(x: x, y: y, z: z) + byteCount <= totalBytes else {
+      throw Error.outOfBoundsAccess
+    }
+
+    var bytes = [UInt8]()
+    bytes.reserveCapacity(byteCount)
+
+    var (cx, cy, cz) = (x, y, z)
+    var remaining = count
+    while remaining > 0 {
+      let rowCount = min(remaining, size.x - cx)
+      if factor == 1 {
+        let row: [UInt8] = try source.getData(x: regionMin.x + cx,
+                                              y: regionMin.y + cy,
+                                              z: regionMin.z + cz,
+                                              count: rowCount)
+        bytes.append(contentsOf: row)
+      } else {
+        try appendDecimatedRow(x: cx, y: cy, z: cz, count: rowCount, to: &bytes)
+      }
+      remaining -= rowCount
+      cx = 0
+      cy += 1
+      if cy == size.y {
+        cy = 0
+        cz += 1
+      }
+    }
+
+    return bytes.withUnsafeBytes { Array($0.bindMemory(to: T.self)) }
+  }
+
+  /**
+   Computes `count` decimated voxels of one output row and appends their bytes.
+
+   - Parameters:
+   - x: The first output voxel along x.
+   - y: The output row.
+   - z: The output slice.
+   - count: The number of output voxels, all within the row.
+   - bytes: The buffer the voxel bytes are appended to.
+   - Throws: Any error thrown by the source volume.
+   */
+  private func appendDecimatedRow(x: Int, y: Int, z: Int, count: Int,
+                                  to bytes: inout [UInt8]) throws {
+    let components = componentCount
+    let srcX0 = regionMin.x + x * factor
+    let srcX1 = min(regionMax.x, srcX0 + count * factor)
+    let srcY0 = regionMin.y + y * factor
+    let srcY1 = min(regionMax.y, srcY0 + factor)
+    let srcZ0 = regionMin.z + z * factor
+    let srcZ1 = min(regionMax.z, srcZ0 + factor)
+
+    var sums = [UInt64](repeating: 0, count: count * components)
+    var weights = [UInt64](repeating: 0, count: count)
+
+    for srcZ in srcZ0..<srcZ1 {
+      for srcY in srcY0..<srcY1 {
+        let row: [UInt8] = try source.getData(x: srcX0, y: srcY, z: srcZ,
+                                              count: srcX1 - srcX0)
+        for i in 0..<(srcX1 - srcX0) {
+          let target = i / factor
+          weights[target] += 1
+          for c in 0..<components {
+            sums[target * components + c] += readComponent(row, at: i * components + c)
+          }
+        }
+      }
+    }
+
+    for i in 0..<count {
+      for c in 0..<components {
+        appendComponent(sums[i * components + c] / weights[i], to: &bytes)
+      }
+    }
+  }
+
+  /**
+   Reads a little-endian component value from a byte buffer.
+
+   - Parameters:
+   - bytes: The byte buffer.
+   - index: The component index (not the byte index).
+   - Returns: The component value widened to `UInt64`.
+   */
+  @inline(__always)
+  private func readComponent(_ bytes: [UInt8], at index: Int) -> UInt64 {
+    let start = index * bytesPerComponent
+    var value: UInt64 = 0
+    for b in 0..<bytesPerComponent {
+      value |= UInt64(bytes[start + b]) << (8 * b)
+    }
+    return value
+  }
+
+  /**
+   Appends a component value in little-endian byte order.
+
+   - Parameters:
+   - value: The component value.
+   - bytes: The buffer to append to.
+   */
+  @inline(__always)
+  private func appendComponent(_ value: UInt64, to bytes: inout [UInt8]) {
+    for b in 0..<bytesPerComponent {
+      bytes.append(UInt8(truncatingIfNeeded: value >> (8 * b)))
+    }
+  }
+
+  /**
+   Sub-volumes are read-only; this method always throws.
+
+   - Throws: `Error.readOnlyAccessViolation`.
+   */
+  public override func setData<T: FixedWidthInteger>(
+    x: Int, y: Int, z: Int, data: [T], count: Int = 1
+  ) throws {
+    throw Error.readOnlyAccessViolation
+  }
+
+  // MARK: - CustomStringConvertible
+
+  /// A string representation including the region and decimation factor.
+  public override var description: String {
+    "SubVolumeAccessor(region: \(regionMin) - \(regionMax), factor: \(factor), " +
+    "size: \(size), source: \(source))"
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-
+ Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
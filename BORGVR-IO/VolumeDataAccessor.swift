@@ -159,6 +159,16 @@ public class VolumeDataAccessor: VolumeDataAccessing, CustomStringConvertible {
     fatalError("setData(x:y:z:data:count:) must be overridden by subclass")
   }
 
+  /**
+   Hints that the slices in the given z-range are about to be read.
+
+   Accessors backed by slow or fragmented storage can override this to load the data ahead
+   of time. The default implementation does nothing.
+
+   - Parameter zRange: The range of slices that will be accessed next.
+   */
+  public func prefetch(zRange: Range<Int>) {}
+
   // MARK: - CustomStringConvertible
 
   /// A textual description of the volume data accessor.
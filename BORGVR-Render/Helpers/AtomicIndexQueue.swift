@@ -0,0 +1,130 @@
+import Foundation
+import Synchronization
+
+/**
+ A bounded first-in first-out queue of integers that any number of threads may push to
+ and pop from without locking.
+
+ Each slot carries a sequence number that tells producers and consumers whose turn it is,
+ so a push or pop is a compare-exchange on the shared position followed by two stores.
+ The capacity is rounded up to a power of two.
+ */
+final class AtomicIndexQueue {
+  /// The number of slots.
+  let capacity: Int
+  /// `capacity - 1`, to map positions to slots.
+  private let mask: Int
+  /// The sequence number of each slot.
+  private let sequences: UnsafeMutablePointer<Atomic<Int>>
+  /// The value stored in each slot.
+  private let values: UnsafeMutablePointer<Atomic<Int>>
+  /// The position of the next push.
+  private let enqueuePosition = Atomic<Int>(0)
+  /// The position of the next pop.
+  private let dequeuePosition = Atomic<Int>(0)
+
+  /**
+   Initializes an empty queue.
+
+   - Parameter capacity: The minimum number of elements the queue can hold.
+   */
+  init(capacity: Int) {
+    var slots = 2
+    while slots < capacity {
+      slots <<= 1
+    }
+    self.capacity = slots
+    self.mask = slots - 1
+    self.sequences = UnsafeMutablePointer<Atomic<Int>>.allocate(capacity: slots)
+    self.values = UnsafeMutablePointer<Atomic<Int>>.allocate(capacity: slots)
+    for i in 0..<slots {
+      (sequences + i).initialize(to: Atomic(i))
+      (values + i).initialize(to: Atomic(0))
+    }
+  }
+
+  deinit {
+    sequences.deinitialize(count: capacity)
+    sequences.deallocate()
+    values.deinitialize(count: capacity)
+    values.deallocate()
+  }
+
+  /**
+   Appends a value to the queue.
+
+   - Parameter value: The value to append.
+   - Returns: False if the queue is full.
+   */
+  @discardableResult
+  func push(_ value: Int) -> Bool {
+    var position = enqueuePosition.load(ordering: .relaxed)
+    while true {
+      let slot = position & mask
+      let difference = sequences[slot].load(ordering: .acquiring) - position
+      if difference == 0 {
+        let (exchanged, original) = enqueuePosition.compareExchange(
+          expected: position, desired: position + 1, ordering: .relaxed)
+        if exchanged {
+          values[slot].store(value, ordering: .relaxed)
+          sequences[slot].store(position + 1, ordering: .releasing)
+          return true
+        }
+        position = original
+      } else if difference < 0 {
+        return false
+      } else {
+        position = enqueuePosition.load(ordering: .relaxed)
+      }
+    }
+  }
+
+  /**
+   Removes the oldest value from the queue.
+
+   - Returns: The value, or `nil` if the queue is empty.
+   */
+  func pop() -> Int? {
+    var position = dequeuePosition.load(ordering: .relaxed)
+    while true {
+      let slot = position & mask
+      let difference = sequences[slot].load(ordering: .acquiring) - (position + 1)
+      if difference == 0 {
+        let (exchanged, original) = dequeuePosition.compareExchange(
+          expected: position, desired: position + 1, ordering: .relaxed)
+        if exchanged {
+          let value = values[slot].load(ordering: .relaxed)
+          sequences[slot].store(position + capacity, ordering: .releasing)
+          return value
+        }
+        position = original
+      } else if difference < 0 {
+        return nil
+      } else {
+        position = dequeuePosition.load(ordering: .relaxed)
+      }
+    }
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
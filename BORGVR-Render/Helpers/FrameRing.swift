@@ -0,0 +1,109 @@
+import Foundation
+
+/**
+ Tracks the frames in flight for per-frame resources that are used round robin.
+
+ The render thread calls `submit()` once per frame, which returns the frame's number and
+ the slot of the resources it uses, and advances to the next slot. Completion handlers,
+ which may run on any thread, report finished frames with `complete(_:)`. The ring itself
+ does not wait; the caller keeps at most `slotCount` frames in flight, so a slot is only
+ used again once the frame that last used it has completed.
+
+ Frames are numbered from 1. `completedFrame` is the highest number up to which all frames
+ have completed, so a resource the CPU stopped referencing after frame `n` was submitted
+ may be rewritten once `completedFrame >= n`.
+
+ The ring has no Metal dependencies, so the rotation can be simulated on the CPU.
+ */
+final class FrameRing {
+  /// The number of slots, i.e. the maximum number of frames in flight.
+  let slotCount: Int
+  /// The slot of the frame that is being encoded. Render thread only.
+  private(set) var currentSlot = 0
+  /// The number of the last submitted frame, 0 before the first one. Render thread only.
+  private(set) var submittedFrame = 0
+
+  /// Protects `completed` and `completedFrames`, which the completion handlers write.
+  private let lock = NSLock()
+  /// The highest frame number up to which all frames have completed.
+  private var completed = 0
+  /// Frames that completed before an earlier one.
+  private var completedFrames = Set<Int>()
+
+  /**
+   Initializes a ring with no frames in flight.
+
+   - Parameter slotCount: The number of slots; at least 1.
+   */
+  init(slotCount: Int) {
+    self.slotCount = max(1, slotCount)
+  }
+
+  /**
+   Submits the frame that is being encoded and advances to the next slot.
+
+   - Returns: The number of the submitted frame and the slot it used.
+   */
+  func submit() -> (frame: Int, slot: Int) {
+    submittedFrame += 1
+    let slot = currentSlot
+    currentSlot = (currentSlot + 1) % slotCount
+    return (submittedFrame, slot)
+  }
+
+  /**
+   Records that a frame has completed. May be called from any thread and in any order.
+
+   - Parameter frame: The number `submit()` returned for the frame.
+   */
+  func complete(_ frame: Int) {
+    lock.lock()
+    if frame > completed {
+      completedFrames.insert(frame)
+      while completedFrames.remove(completed + 1) != nil {
+        completed += 1
+      }
+    }
+    lock.unlock()
+  }
+
+  /// The highest frame number up to which all frames have completed.
+  var completedFrame: Int {
+    lock.lock()
+    defer { lock.unlock() }
+    return completed
+  }
+
+  /// The number of submitted frames that have not completed.
+  var framesInFlight: Int {
+    submittedFrame - completedFrame
+  }
+
+  /// Whether the frame that last used `currentSlot` has completed, i.e. its resources may
+  /// be written for the frame that is being encoded.
+  var currentSlotIsFree: Bool {
+    submittedFrame - completedFrame < slotCount
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
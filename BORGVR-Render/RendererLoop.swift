@@ -83,6 +83,26 @@ extension Renderer {
       )
     }
 
+    // The pose of the device between the eyes, in the same spaces the shaders use.
+    let toTexture = Transform(translation: SIMD3<Float>(0.5, 0.5, 0.5)).matrix
+    let deviceToTexture = toTexture * simd_inverse(modelMatrix) * originFromDevice
+    lastViewPose = (
+      position: simd_make_float3(deviceToTexture * simd_float4(0, 0, 0, 1)),
+      forward: simd_normalize(simd_make_float3(deviceToTexture * simd_float4(0, 0, -1, 0)))
+    )
+
+    if let prefetchPlanner {
+      let deviceToTextureVoxelScaled = toTexture * simd_inverse(originFromWorldAnchor * sharedAppModel.modelTransform.matrix) * originFromDevice
+      prefetchPlanner.record(PrefetchPlanner.Pose(
+        time: CACurrentMediaTime(),
+        position: lastViewPose.position,
+        lodPosition: simd_make_float3(deviceToTextureVoxelScaled * simd_float4(0, 0, 0, 1)),
+        forward: lastViewPose.forward,
+        clipMin: sharedAppModel.clipMin,
+        clipMax: sharedAppModel.clipMax
+      ))
+    }
+
     (uniformBufferVertex.current.uniforms.0, uniformBufferFragment.current.uniforms.0) = uniforms(forViewIndex: 0)
     if drawable.views.count > 1 {
       (uniformBufferVertex.current.uniforms.1, uniformBufferFragment.current.uniforms.1) = uniforms(forViewIndex: 1)
@@ -147,26 +167,21 @@ extension Renderer {
   }
 
   /**
-   Reads back the GPU hash table and pages in missing bricks.
-
-   - Parameter commandBuffer: The command buffer from the current frame.
+   Pages in the bricks the GPU hash table reported as missing in the frames that completed
+   since the last call. The atlas is also paged while it still has work carried over from
+   previous frames. Does not wait for the GPU, so the misses of a frame are handled one or
+   more frames later.
    */
-  func readBackHashTable(commandBuffer: MTLCommandBuffer) {
-    let missingBricks = hashTable.getValues(from: commandBuffer)
-
-    if !missingBricks.isEmpty {
-      let intArray = missingBricks.map { Int($0) }.sorted(by: >)
-      let metadata = borgData.getMetadata()
-
-      for entry in intArray {
-        for level in (1..<metadata.levelMetadata.count).reversed() {
-          if entry > metadata.levelMetadata[level].prevBricks {
-            break
-          }
-        }
+  func readBackHashTable() {
+    let missingBricks = hashTable.takeEntries()
+
+    if !missingBricks.isEmpty || volumeAtlas.hasPendingWork {
+      let intArray = missingBricks.map { Int($0.brickID) }
+      if !intArray.isEmpty {
+        prefetchPlanner?.recordRequests(intArray)
+        volumeAtlas.newRequest()
       }
-
-      try? volumeAtlas.pageIn(IDs: intArray)
+      try? volumeAtlas.pageIn(IDs: intArray, hits: missingBricks.map { $0.hits })
     }
   }
 
@@ -180,6 +195,7 @@ extension Renderer {
     let last = timer.lastFPS
     let avg = timer.averageFPS
     let smoothed = timer.smoothedFPS
+    let metaBytes = volumeAtlas.takeUploadedMetaBytes()
 
     if autoRotationAngle > 0 {
       if autoRotationAngle == 1 {
@@ -210,15 +226,22 @@ extension Renderer {
       if self.runtimeAppModel.logPerformance {
         struct State {
           static var lastTime = CACurrentMediaTime()
+          static var metaBytes = 0
+          static var frames = 0
         }
 
         let currentTime = CACurrentMediaTime()
         let elapsed = currentTime - State.lastTime
+        State.metaBytes += metaBytes
+        State.frames += 1
 
         if elapsed >= 2.0 {
           self.logger?
-            .info("Last FPS: \(last), Avg FPS: \(avg), Smoothed FPS: \(smoothed)")
+            .info("Last FPS: \(last), Avg FPS: \(avg), Smoothed FPS: \(smoothed), " +
+                  "Metadata upload: \(State.metaBytes / State.frames) bytes/frame")
           State.lastTime = currentTime
+          State.metaBytes = 0
+          State.frames = 0
         }
       }
     }
@@ -251,6 +274,10 @@ extension Renderer {
 
     guard let drawable = frame.queryDrawables().first else { return }
 
+    // Wait until the frame that last used this frame's uniform and hash table buffers
+    // has completed.
+    inFlightSemaphore.wait()
+
     frame.startSubmission()
     self.updateDynamicBufferState()
 
@@ -331,7 +358,8 @@ extension Renderer {
     volumeAtlas.bind(to: renderEncoder,
                      atlasIndex: TextureIndex.volumeAtlas.rawValue,
                      metaIndex: FragmentBufferIndex.brickMeta.rawValue,
-                     levelIndex: FragmentBufferIndex.levelTable.rawValue)
+                     levelIndex: FragmentBufferIndex.levelTable.rawValue,
+                     rangeIndex: FragmentBufferIndex.pageRanges.rawValue)
 
     hashTable.bind(to: renderEncoder, index: FragmentBufferIndex.hashTable.rawValue)
 
@@ -341,12 +369,35 @@ extension Renderer {
     renderEncoder.endEncoding()
 
     drawable.encodePresent(commandBuffer: commandBuffer)
+    hashTable.readBack(after: commandBuffer) { [inFlightSemaphore] in
+      inFlightSemaphore.signal()
+    }
     commandBuffer.commit()
-    readBackHashTable(commandBuffer: commandBuffer)
+    readBackHashTable()
     updatePerformanceCounters()
     frame.endSubmission()
   }
 
+  /**
+   Saves the resident bricks and the last camera pose, so the next session with this
+   dataset can warm-start the atlas. Does nothing if warm starts are disabled.
+   */
+  func saveWarmStart() {
+    guard let warmStartURL else { return }
+    let warmStart = AtlasWarmStart(
+      brickCount: borgData.getMetadata().brickMetadata.count,
+      bricks: volumeAtlas.residentBrickIDs(),
+      position: lastViewPose.position,
+      forward: lastViewPose.forward
+    )
+    do {
+      try warmStart.save(to: warmStartURL)
+      logger?.dev("Saved \(warmStart.bricks.count) resident bricks for the next warm start.")
+    } catch {
+      logger?.warning("Could not save the resident bricks: \(error.localizedDescription)")
+    }
+  }
+
   // MARK: Actual Loop
 
   /**
@@ -355,6 +406,7 @@ extension Renderer {
   func renderLoop() {
     while true {
       if layerRenderer.state == .invalidated {
+        saveWarmStart()
         Task { @MainActor in
           runtimeAppModel.immersiveSpaceState = .closed
         }
@@ -10,6 +10,28 @@ extension Renderer {
 
   // MARK: Pipeline Setup
 
+  /**
+   Computes the constants the shaders use to select the level of detail.
+
+   - Parameter borgVRMetaData: The metadata of the BorgVR dataset.
+   - Returns: The LOD factor, the world space error of level 0 and the field of view.
+   */
+  static func lodParameters(borgVRMetaData: BORGVRMetaData) -> PrefetchPlanner.LODParameters {
+    let screenSpaceError = StoredAppModel.float("screenSpaceError")
+    let width : Float = 1888.0
+    let fieldOfView : Float = 1.663
+
+    let lodFactor = 2.0 * tan(fieldOfView / 2.0) * screenSpaceError / width
+    let levelZeroWorldSpaceError = max(
+      borgVRMetaData.aspectX / Float(borgVRMetaData.width),
+      borgVRMetaData.aspectY / Float(borgVRMetaData.height),
+      borgVRMetaData.aspectZ / Float(borgVRMetaData.depth)
+    )
+    return PrefetchPlanner.LODParameters(lodFactor: lodFactor,
+                                         levelZeroWorldSpaceError: levelZeroWorldSpaceError,
+                                         fieldOfView: fieldOfView)
+  }
+
   /**
    Builds and returns three render pipeline states used for rendering volume data.
 
@@ -41,26 +63,20 @@ extension Renderer {
     }
     let shaderSource = try String(contentsOfFile: shaderPath, encoding: .utf8)
 
-    let screenSpaceError = StoredAppModel.float("screenSpaceError")
     let atlasSizeMB = StoredAppModel.int("atlasSizeMB")
+    let quantizeAtlas = StoredAppModel.bool("quantizeAtlas")
     let maxProbingAttempts = StoredAppModel.int("maxProbingAttempts")
     let requestLowResLOD = StoredAppModel.bool("requestLowResLOD") ? 1 : 0
     let stopOnMiss = StoredAppModel.bool("stopOnMiss") ? 1 : 0
 
-    let width : Float = 1888.0
-
-    let lodFactor = 2.0 * tan(1.663 / 2.0) * screenSpaceError / width
-    let levelZeroWorldSpaceError = max(
-      borgVRMetaData.aspectX / Float(borgVRMetaData.width),
-      borgVRMetaData.aspectY / Float(borgVRMetaData.height),
-      borgVRMetaData.aspectZ / Float(borgVRMetaData.depth)
-    )
+    let lod = lodParameters(borgVRMetaData: borgVRMetaData)
 
     let (atlasWidth, atlasHeight, atlasDepth, _) = VolumeAtlas.computeAtlasSize(
       maxMemory: atlasSizeMB * 1024 * 1024,
       maxBrickCount: borgVRMetaData.brickMetadata.count,
       brickSize: borgVRMetaData.brickSize,
-      bytesPerComponent: borgVRMetaData.bytesPerComponent,
+      bytesPerComponent: VolumeAtlas.atlasBytesPerComponent(for: borgVRMetaData,
+                                                            quantize: quantizeAtlas),
       componentCount: borgVRMetaData.componentCount
     )
 
@@ -82,8 +98,8 @@ extension Renderer {
       "BRICK_SIZE": NSNumber(value: borgVRMetaData.brickSize),
       "BRICK_INNER_SIZE": NSNumber(value: borgVRMetaData.brickSize - borgVRMetaData.overlap * 2),
       "OVERLAP_STEP": NSString(string: "float3(\(overlapStepX),\(overlapStepY),\(overlapStepZ))"),
-      "LEVEL_ZERO_WORLD_SPACE_ERROR" : NSNumber(value: levelZeroWorldSpaceError),
-      "LOD_FACTOR" : NSNumber(value: lodFactor),
+      "LEVEL_ZERO_WORLD_SPACE_ERROR" : NSNumber(value: lod.levelZeroWorldSpaceError),
+      "LOD_FACTOR" : NSNumber(value: lod.lodFactor),
       "POOL_SIZE" : NSString(string: "float3(\(atlasWidth),\(atlasHeight),\(atlasDepth))"),
       "VOLUME_SIZE" : NSString(string: "float3(\(borgVRMetaData.width),\(borgVRMetaData.height),\(borgVRMetaData.depth))"),
       "POOL_CAPACITY" : NSString(string: "uint3(\(atlasWidth / borgVRMetaData.brickSize),\(atlasHeight / borgVRMetaData.brickSize),\(atlasDepth / borgVRMetaData.brickSize))"),
@@ -65,6 +65,8 @@ final actor Renderer {
   var hashTable: GPUHashtable
   /// The number of samples per pixel used during rasterization.
   let rasterSampleCount: Int
+  /// Limits the number of frames the GPU works on to `maxBuffersInFlight`.
+  let inFlightSemaphore: DispatchSemaphore
   /// Current index into the memoryless target textures.
   var currentRenderTargetIndex: Int = 0
   /// An array of memoryless target textures (color and depth) for rendering.
@@ -109,13 +111,22 @@ final actor Renderer {
   /// The current active oversampling factor (nonisolated).
   nonisolated(unsafe) var activeOversampling: Float
 
+  /// Predicts the bricks of upcoming views while a remote dataset is being cached.
+  var prefetchPlanner: PrefetchPlanner?
+  /// Where the resident bricks are saved on close to warm-start the atlas, or `nil` if
+  /// warm starts are disabled.
+  let warmStartURL: URL?
+  /// The camera position and view direction of the last frame in texture space, saved
+  /// with the resident bricks.
+  var lastViewPose = (position: SIMD3<Float>(repeating: 0.5), forward: SIMD3<Float>(0, 0, -1))
+
   // MARK: Init
 
   /**
    Initializes a new Renderer with the given parameters.
 
-   This initializer creates all necessary Metal objects, pages in initial volume bricks,
-   configures uniform buffers, builds render pipelines, and sets up AR and spatial
+   This initializer creates all necessary Metal objects, pages in initial volume bricks
+   or the bricks saved by the last session, configures uniform buffers, builds render pipelines, and sets up AR and spatial
    tracking using ARKit.
 
    - Parameters:
@@ -175,8 +186,16 @@ final actor Renderer {
         borgData: borgData,
         transferFunction: sharedAppModel.transferFunction,
         isoValue: sharedAppModel.isoValue,
+        quantize: StoredAppModel.bool("quantizeAtlas"),
         logger: logger
       )
+      volumeAtlas.pagingBudget = BrickLoader.Budget(
+        maxBricks: StoredAppModel.int("pagingBudgetBricks"),
+        maxBytes: StoredAppModel.int("pagingBudgetMB") * 1024 * 1024,
+        maxDuration: Double(StoredAppModel.int("pagingBudgetMicroseconds")) / 1_000_000
+      )
+      volumeAtlas.evictionPolicy.reservedLevels = StoredAppModel.int("evictionReservedLevels")
+      volumeAtlas.evictionPolicy.reservedPages = StoredAppModel.int("evictionReservedPages")
       logger?.dev("VolumeAtlas created successfully.")
     } catch {
       logger?.error("Failed to create volume atlas: \(error)")
@@ -185,20 +204,50 @@ final actor Renderer {
 
     let metadata = borgData.getMetadata()
 
-    // Page in initial bricks for smoother rendering.
-    let maxInitialBricks = StoredAppModel.int("initialBricks")
-
-    let start = metadata.brickMetadata.count-2
-    let count = min(maxInitialBricks,metadata.brickMetadata.count-1)
-    let initialIDs = (0..<count).map { start - $0 }
+    let warmStartURL: URL?
+    if StoredAppModel.bool("warmStartAtlas") {
+      let documentsDirectory = FileManager.default.urls(for: .documentDirectory,
+                                                        in: .userDomainMask).first!
+      warmStartURL = documentsDirectory.appendingPathComponent("\(metadata.uniqueID)-atlas.json")
+    } else {
+      warmStartURL = nil
+    }
+    self.warmStartURL = warmStartURL
+
+    var warmStart: AtlasWarmStart?
+    if let warmStartURL, FileManager.default.fileExists(atPath: warmStartURL.path) {
+      do {
+        warmStart = try AtlasWarmStart.load(from: warmStartURL,
+                                            brickCount: metadata.brickMetadata.count)
+      } catch {
+        logger?.warning("Ignoring the saved atlas bricks: \(error.localizedDescription)")
+      }
+    }
 
-    do {
-      // note that this does not guarantee that all initialIDs
-      // are paged in, as some may be empty
-      try volumeAtlas.pageIn(IDs: initialIDs)
-      logger?.dev("\(initialIDs.count) initial bricks paged in successfully.")
-    } catch {
-      logger?.warning("Failed to page in all of the initial bricks: \(error)")
+    if let warmStart {
+      // Fill the atlas with the bricks of the last session, so the first frames start
+      // out sharp instead of waiting for the hash table to report them.
+      let requests = warmStart.requests(for: metadata)
+      let restored = volumeAtlas.warmStart(IDs: requests.IDs, hits: requests.hits,
+                                           timeLimit: 2.0)
+      lastViewPose = (warmStart.position, warmStart.forward)
+      logger?.dev("Warm start paged in \(restored) of \(requests.IDs.count) saved bricks.")
+    } else {
+      // Page in initial bricks for smoother rendering.
+      let maxInitialBricks = StoredAppModel.int("initialBricks")
+
+      let start = metadata.brickMetadata.count-2
+      let count = min(maxInitialBricks,metadata.brickMetadata.count-1)
+      let initialIDs = (0..<count).map { start - $0 }
+
+      do {
+        // note that this only requests the initialIDs, they are loaded in the
+        // background and paged in over the first frames, except for empty ones
+        try volumeAtlas.pageIn(IDs: initialIDs)
+        logger?.dev("\(initialIDs.count) initial bricks requested.")
+      } catch {
+        logger?.warning("Failed to page in all of the initial bricks: \(error)")
+      }
     }
 
     let minHashTableSize = StoredAppModel.int("minHashTableSize")
@@ -207,7 +256,12 @@ final actor Renderer {
 
     logger?.dev("Size of Bricks represented by the Hash Table is \(minHashTableSize) MB. That means a minimum of \(minTableElementCount) table elements.")
 
-    self.hashTable = GPUHashtable(minTableElementCount: minTableElementCount, device: device, logger: logger)
+    self.hashTable = GPUHashtable(minTableElementCount: minTableElementCount,
+                                  bufferCount: runtimeAppModel.maxBuffersInFlight,
+                                  device: device, logger: logger)
+    // The atlas refills a page only once the frames that may sample its old brick completed.
+    volumeAtlas.frames = hashTable.frames
+    self.inFlightSemaphore = DispatchSemaphore(value: runtimeAppModel.maxBuffersInFlight)
 
     let maxExtend = Float(max(metadata.width, metadata.height, metadata.depth))
     let scale = SIMD3<Float>(metadata.aspectX * Float(metadata.width) / maxExtend,
@@ -285,6 +339,27 @@ final actor Renderer {
 
     sharedAppModel.transferFunction.initMetal(device: device)
 
+    if let remoteData = borgData as? BORGVRRemoteData, remoteData.acceptsPrefetchPlan {
+      let planner = PrefetchPlanner(
+        metadata: metadata,
+        parameters: Renderer.lodParameters(borgVRMetaData: metadata),
+        logger: logger
+      ) { [weak remoteData] plan in
+        remoteData?.setPrefetchPlan(plan)
+      }
+      if StoredAppModel.bool("recordPoseTrace") {
+        let documentsDirectory = FileManager.default.urls(for: .documentDirectory,
+                                                          in: .userDomainMask).first!
+        let traceURL = documentsDirectory.appendingPathComponent("\(metadata.uniqueID)-poses.jsonl")
+        do {
+          try planner.startTrace(at: traceURL)
+        } catch {
+          logger?.warning("Could not record the pose trace: \(error.localizedDescription)")
+        }
+      }
+      self.prefetchPlanner = planner
+    }
+
     logger?.dev("Renderer initialized")
   }
 
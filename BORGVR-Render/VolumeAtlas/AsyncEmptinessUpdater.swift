@@ -37,6 +37,17 @@ final class SyncSemaphore {
  a transfer function or an isovalue, and updates associated metadata.
  */
 class AsyncEmptinessUpdater {
+  /**
+   A change of a single metadata entry, exchanged between the atlas and the updater
+   instead of the full metadata array.
+   */
+  struct MetadataChange {
+    /// The brick index.
+    let index: Int
+    /// The new metadata value of the brick.
+    let value: UInt32
+  }
+
   // MARK: - Asynchronous Emptiness Variables
 
   /// The background task performing emptiness updates.
@@ -55,8 +66,8 @@ class AsyncEmptinessUpdater {
   private var shouldRestart: Bool = false
   /// Lock for tracking changes in emptiness.
   private let hasChangedLock = NSLock()
-  /// Flag indicating whether the emptiness data has changed.
-  private var hasChanged: Bool = false
+  /// The bricks whose metadata the updater changed since the atlas last fetched them.
+  private var changedIndices = IndexSet()
   /// Lock for synchronizing transfer function updates.
   private let transferFunctionLock = NSLock()
   /// The transfer function used to determine brick emptiness.
@@ -67,10 +78,8 @@ class AsyncEmptinessUpdater {
   private var borgData: BORGVRDatasetProtocol
   /// An array storing metadata flags for each brick.
   private var metaStorage: [UInt32] = []
-  /// A mapping from brick indices to page indices.
-  private var brickToPage: [Int: Int] = [:]
-  /// Metadata for each page.
-  private var pageMetadata: [PageMetadata] = []
+  /// The brick/page mapping of the atlas; read only, the atlas updates it in place.
+  private let brickPages: BrickPageTable
   /// A table mapping each brick to its child bricks.
   private var childTable: [[Int]] = []
   /// The current render mode.
@@ -85,14 +94,17 @@ class AsyncEmptinessUpdater {
 
    - Parameters:
    - borgData: The dataset protocol instance.
+   - brickPages: The brick/page mapping maintained by the atlas.
    - transferFunction: The initial transfer function.
    - isoValue: The normalized isovalue (as a Float) to be converted to an integer.
    */
   init(borgData: BORGVRDatasetProtocol,
+       brickPages: BrickPageTable,
        transferFunction: TransferFunction1D,
        isoValue: Float,
        logger: LoggerBase?) {
     self.borgData = borgData
+    self.brickPages = brickPages
     self.logger = logger
     self.isoValue = intIsoValue(normIsoValue: isoValue)
     self.transferFunction = TransferFunction1D(copyFrom: transferFunction)
@@ -241,40 +253,33 @@ class AsyncEmptinessUpdater {
 
         // Only update metaStorage if emptiness has changed.
         if lastEmptiness != currentEmptiness {
-          var currentEmptinessHasChanged = false
-
           self.storageLock.withLock {
             for index in 0..<currentEmptiness.count {
               if self.shouldRestart { break }
 
               if currentEmptiness[index] {
-                // If a brick that was paged in is now empty.
-                if self.metaStorage[index] >= BI_FLAG_COUNT,
-                   let foundIndex = self.brickToPage[index] {
-                  self.pageMetadata[foundIndex].flagEmpty()
-                }
+                // A brick that was paged in keeps its page until the atlas reuses it.
                 // Update metaStorage based on whether the brick is child-empty.
                 if self.isChildEmpty(index) {
                   if self.metaStorage[index] != BI_CHILD_EMPTY {
                     self.metaStorage[index] = BI_CHILD_EMPTY
-                    currentEmptinessHasChanged = true
+                    self.changedIndices.insert(index)
                   }
                 } else {
                   if self.metaStorage[index] != BI_EMPTY {
                     self.metaStorage[index] = BI_EMPTY
-                    currentEmptinessHasChanged = true
+                    self.changedIndices.insert(index)
                   }
                 }
               } else {
                 // If a brick was empty but is now visible.
                 if self.metaStorage[index] == BI_EMPTY || self.metaStorage[index] == BI_CHILD_EMPTY {
-                  if let foundIndex = self.brickToPage[index],
-                     self.pageMetadata[foundIndex].reactivate(ifItContains: index) {
-                    self.metaStorage[index] = UInt32(self.pageMetadata[foundIndex].pageID) + BI_FLAG_COUNT
+                  if let page = self.brickPages.page(of: index) {
+                    self.metaStorage[index] = UInt32(page) + BI_FLAG_COUNT
                   } else {
                     self.metaStorage[index] = BI_MISSING
                   }
-                  currentEmptinessHasChanged = true
+                  self.changedIndices.insert(index)
                 }
               }
             }
@@ -284,7 +289,6 @@ class AsyncEmptinessUpdater {
 
           self.hasChangedLock.withLock {
             self.lastEmptiness = currentEmptiness
-            self.hasChanged = currentEmptinessHasChanged
           }
         }
       }
@@ -314,13 +318,15 @@ class AsyncEmptinessUpdater {
                    useTF: transferFunction)
     }
 
-    // Update metaStorage based on computed emptiness.
+    // Update metaStorage based on computed emptiness; the atlas starts with all bricks
+    // missing, so only the empty ones need to be published.
     for (index, isEmpty) in emptiness.enumerated() {
       metaStorage[index] = isEmpty ? (self.isChildEmpty(index) ? BI_CHILD_EMPTY : BI_EMPTY)
       : BI_MISSING
+      if isEmpty {
+        changedIndices.insert(index)
+      }
     }
-
-    hasChanged = true
   }
 
   /**
@@ -401,20 +407,19 @@ class AsyncEmptinessUpdater {
   }
 
   /**
-   Updates the metadata storage, brick-to-page mapping, and page metadata, then signals a restart.
+   Applies the metadata changes made by the atlas, then signals a restart. The atlas'
+   values replace any pending change of the updater for the same bricks. The
+   brick-to-page mapping is shared with the atlas and needs no update.
 
-   - Parameters:
-   - metaStorage: The new metadata storage array.
-   - brickToPage: A mapping from brick indices to page indices.
-   - pageMetadata: An array of page metadata.
+   - Parameter changes: The changed entries, in the order they were made.
    */
-  func updateMetadata(metaStorage: [UInt32],
-                      brickToPage: [Int: Int],
-                      pageMetadata: [PageMetadata]) {
+  func updateMetadata(changes: [MetadataChange]) {
+    guard !changes.isEmpty else { return }
     storageLock.withLock {
-      self.metaStorage = metaStorage
-      self.pageMetadata = pageMetadata
-      self.brickToPage = brickToPage
+      for change in changes {
+        metaStorage[change.index] = change.value
+        changedIndices.remove(change.index)
+      }
       lastEmptiness = []
       restartLock.withLock {
         self.shouldRestart = true
@@ -424,18 +429,20 @@ class AsyncEmptinessUpdater {
   }
 
   /**
-   Returns the current metadata if any changes have been detected.
+   Returns the metadata entries the updater changed since the last call.
 
-   - Returns: An optional array of UInt32 representing the metadata; nil if no change.
+   The call does not wait while an update pass holds the storage; the changes are
+   returned on a later call instead.
+
+   - Returns: The changed entries; nil if there is no change or the storage is busy.
    */
-  func inCoreDataHasChanged() -> [UInt32]? {
-    return hasChangedLock.withLock {
-      guard hasChanged else { return nil }
-      return storageLock.withLock {
-        hasChanged = false
-        return metaStorage
-      }
-    }
+  func inCoreDataHasChanged() -> [MetadataChange]? {
+    guard storageLock.try() else { return nil }
+    defer { storageLock.unlock() }
+    guard !changedIndices.isEmpty else { return nil }
+    let changes = changedIndices.map { MetadataChange(index: $0, value: metaStorage[$0]) }
+    changedIndices.removeAll()
+    return changes
   }
 }
 
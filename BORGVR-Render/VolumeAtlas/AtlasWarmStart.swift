@@ -0,0 +1,183 @@
+import Foundation
+
+/**
+ An error type for reading a warm start file.
+ */
+enum AtlasWarmStartError: Error, LocalizedError {
+  /// Indicates that the file was written by an incompatible version.
+  case unsupportedVersion(Int)
+  /// Indicates that the file belongs to a dataset with a different brick count.
+  case brickCountMismatch(Int, Int)
+
+  /// A localized description of the error.
+  var errorDescription: String? {
+    switch self {
+      case .unsupportedVersion(let version):
+        return "Unsupported warm start file version \(version)"
+      case .brickCountMismatch(let stored, let expected):
+        return "The warm start file lists \(stored) bricks, but the dataset has \(expected)"
+    }
+  }
+}
+
+/**
+ The resident bricks of a volume atlas and the last camera pose, saved when a dataset is
+ closed so the atlas can be filled with the same bricks before the first frame when it is
+ opened again, instead of waiting for the GPU hash table to report them.
+
+ The type only depends on Foundation and the dataset metadata, so files can be written,
+ read and turned into requests without Metal.
+ */
+struct AtlasWarmStart: Codable {
+  /// The current file version.
+  static let currentVersion = 1
+
+  /// The version the file was written with.
+  var version = AtlasWarmStart.currentVersion
+  /// The number of bricks in the dataset, to reject files of a different dataset.
+  var brickCount: Int
+  /// The resident bricks, from the most to the least recently used one.
+  var bricks: [Int]
+  /// The camera position in the texture space of the volume, where it spans [0, 1]³.
+  var position: SIMD3<Float>
+  /// The normalized view direction in texture space.
+  var forward: SIMD3<Float>
+
+  /**
+   Initializes a warm start record.
+
+   - Parameters:
+   - brickCount: The number of bricks in the dataset.
+   - bricks: The resident bricks, most recently used first.
+   - position: The camera position in texture space.
+   - forward: The view direction in texture space.
+   */
+  init(brickCount: Int, bricks: [Int], position: SIMD3<Float>, forward: SIMD3<Float>) {
+    self.brickCount = brickCount
+    self.bricks = bricks
+    self.position = position
+    self.forward = forward
+  }
+
+  // MARK: - Files
+
+  /**
+   Writes the record to a file, replacing it atomically.
+
+   - Parameter url: The file URL.
+   - Throws: An error if encoding or writing fails.
+   */
+  func save(to url: URL) throws {
+    let data = try JSONEncoder().encode(self)
+    try data.write(to: url, options: .atomic)
+  }
+
+  /**
+   Reads a record and checks that it belongs to the dataset.
+
+   - Parameters:
+   - url: The file URL.
+   - brickCount: The number of bricks in the dataset.
+   - Returns: The record.
+   - Throws: An error if the file cannot be read or decoded, or an AtlasWarmStartError if
+   it does not match the dataset.
+   */
+  static func load(from url: URL, brickCount: Int) throws -> AtlasWarmStart {
+    let data = try Data(contentsOf: url)
+    let record = try JSONDecoder().decode(AtlasWarmStart.self, from: data)
+    guard record.version == currentVersion else {
+      throw AtlasWarmStartError.unsupportedVersion(record.version)
+    }
+    guard record.brickCount == brickCount else {
+      throw AtlasWarmStartError.brickCountMismatch(record.brickCount, brickCount)
+    }
+    return record
+  }
+
+  // MARK: - Restoring
+
+  /**
+   Turns the saved bricks into requests for `VolumeAtlas.pageIn`.
+
+   The atlas handles coarse levels first and then more hits, so the hits rank the bricks of
+   a level by the saved view: bricks in front of the camera before those behind it, then
+   nearer before farther, then more recently used first. Invalid or duplicate brick IDs are
+   dropped.
+
+   - Parameter metadata: The metadata of the dataset.
+   - Returns: The brick IDs and their hit counts.
+   */
+  func requests(for metadata: BORGVRMetaData) -> (IDs: [Int], hits: [UInt32]) {
+    var seen = Set<Int>()
+    let valid = bricks.filter { $0 >= 0 && $0 < brickCount && seen.insert($0).inserted }
+
+    let innerSize = Float(metadata.brickSize - 2 * metadata.overlap)
+    let keys = valid.enumerated().map { (recency, brickID) in
+      let center = AtlasWarmStart.center(of: brickID, levels: metadata.levelMetadata,
+                                         innerSize: innerSize)
+      let toCenter = center - position
+      return (brickID: brickID,
+              behind: (toCenter * forward).sum() < 0,
+              distance: (toCenter * toCenter).sum(),
+              recency: recency)
+    }
+
+    let ranked = keys.sorted {
+      if $0.behind != $1.behind { return !$0.behind }
+      if $0.distance != $1.distance { return $0.distance < $1.distance }
+      return $0.recency < $1.recency
+    }
+    return (ranked.map { $0.brickID },
+            ranked.indices.map { UInt32(ranked.count - $0) })
+  }
+
+  /**
+   Computes the center of a brick in texture space, as the bricks are laid out in the level
+   table of `VolumeAtlas`.
+
+   - Parameters:
+   - brickID: The brick index.
+   - levels: The level metadata of the dataset.
+   - innerSize: The brick size without the overlap.
+   - Returns: The center of the part of the brick inside the volume.
+   */
+  private static func center(of brickID: Int, levels: [LevelMetadata],
+                             innerSize: Float) -> SIMD3<Float> {
+    guard let level = levels.last(where: { $0.prevBricks <= brickID }) else {
+      return SIMD3<Float>(repeating: 0.5)
+    }
+    let local = brickID - level.prevBricks
+    let bricksX = level.totalBricks.x
+    let bricksXTimesBricksY = level.totalBricks.x * level.totalBricks.y
+    let coords = SIMD3<Float>(Float(local % bricksX),
+                              Float((local % bricksXTimesBricksY) / bricksX),
+                              Float(local / bricksXTimesBricksY))
+    let layout = SIMD3<Float>(Float(level.size.x), Float(level.size.y),
+                              Float(level.size.z)) / innerSize
+    let lower = coords / layout
+    let upper = pointwiseMin((coords + 1) / layout, SIMD3<Float>(repeating: 1))
+    return (lower + upper) / 2
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,276 @@
+import Foundation
+import Synchronization
+
+/**
+ Loads bricks on a pool of worker threads so the render thread only copies finished bricks
+ into the atlas.
+
+ The pipeline has three stages:
+ 1. `request(_:)` puts a missing brick into a lock-free request queue. Bricks that are
+    already queued, loading or staged are ignored.
+ 2. The workers take a free staging buffer from a fixed ring, read and decompress the brick
+    into it, optionally quantize it to 8 bits, and queue the buffer as ready.
+ 3. `commitReady(budget:_:)` hands ready bricks to the caller until the brick, byte or time
+    budget of the frame is used up, then returns the buffers to the ring.
+
+ Apart from the dataset, the loader has no dependencies, so it can be driven without Metal
+ by passing a mock dataset and a commit closure that records the bricks.
+
+ `request` and `commitReady` must be called from a single thread, the render thread.
+ */
+final class BrickLoader {
+
+  /// The limits for committing bricks in a single `commitReady` call. At least one brick
+  /// is always committed, so a tight budget cannot stall loading.
+  struct Budget {
+    /// The maximum number of bricks to commit.
+    var maxBricks: Int
+    /// The maximum number of brick bytes to commit.
+    var maxBytes: Int
+    /// The maximum time to spend committing, in seconds.
+    var maxDuration: Double
+  }
+
+  /// The number of bytes of a decompressed brick.
+  let brickByteCount: Int
+  /// The number of bytes of a brick handed to `commitReady`'s closure.
+  let committedByteCount: Int
+  /// Whether the workers quantize the bricks with `BrickQuantizer`.
+  let quantize: Bool
+  /// The number of staging buffers.
+  let slotCount: Int
+
+  private let borgData: BORGVRDatasetProtocol
+  /// An optional logger for debug and error messages.
+  private let logger: LoggerBase?
+
+  /// Brick IDs waiting for a worker.
+  private let requests: AtomicIndexQueue
+  /// Staging slots that can be loaded into.
+  private let freeSlots: AtomicIndexQueue
+  /// Staging slots that hold a finished load.
+  private let readySlots: AtomicIndexQueue
+  /// The staging buffers, `slotCount` bricks back to back.
+  private let staging: UnsafeMutablePointer<UInt8>
+  /// The brick ID loaded into each slot, or `-(ID + 1)` if loading failed. Written by a
+  /// worker before the slot is queued as ready, so the queue orders the accesses.
+  private let slotBricks: UnsafeMutablePointer<Int>
+  /// The value scale and bias of the brick in each slot, written together with `slotBricks`.
+  private let slotRanges: UnsafeMutablePointer<SIMD2<Float>>
+
+  /// Counts the queued requests, so idle workers sleep.
+  private let requestSemaphore = DispatchSemaphore(value: 0)
+  /// Counts the free staging slots, so workers wait for the render thread to commit.
+  private let slotSemaphore: DispatchSemaphore
+  /// Counts the ready slots that `commitReady` has not taken yet, so `waitForReady` can
+  /// sleep until a load finishes.
+  private let readySemaphore = DispatchSemaphore(value: 0)
+  private let workerQueue = DispatchQueue(label: "BrickLoaderQueue", qos: .userInitiated,
+                                          attributes: .concurrent)
+  private let workerCount: Int
+  private let stopping = Atomic<Bool>(false)
+
+  /// The bricks that are queued, loading or staged. Render thread only.
+  private var pending = Set<Int>()
+  /// The ready slots that `commitReady`'s closure declined, which `readySemaphore` no
+  /// longer counts. Render thread only.
+  private var keptSlots = Set<Int>()
+
+  /**
+   Initializes the loader and starts its workers.
+
+   - Parameters:
+   - borgData: The dataset to load from.
+   - workerCount: The number of worker threads; use 1 if the dataset does not support
+   concurrent loads.
+   - quantize: Whether to quantize the bricks, which must have one 16-bit component, to
+   8 bits.
+   - slotCount: The number of staging buffers.
+   - queueCapacity: The maximum number of queued requests.
+   - logger: An optional logger for debug and error messages.
+   */
+  init(borgData: BORGVRDatasetProtocol, workerCount: Int, quantize: Bool = false,
+       slotCount: Int = 64, queueCapacity: Int = 4096, logger: LoggerBase? = nil) {
+    let metadata = borgData.getMetadata()
+    self.brickByteCount = metadata.brickSize * metadata.brickSize * metadata.brickSize *
+    metadata.componentCount * metadata.bytesPerComponent
+    self.quantize = quantize
+    self.committedByteCount = quantize ? brickByteCount / metadata.bytesPerComponent : brickByteCount
+    self.borgData = borgData
+    self.logger = logger
+    self.workerCount = max(1, workerCount)
+    self.slotCount = max(1, slotCount)
+    self.requests = AtomicIndexQueue(capacity: queueCapacity)
+    self.freeSlots = AtomicIndexQueue(capacity: self.slotCount)
+    self.readySlots = AtomicIndexQueue(capacity: self.slotCount)
+    self.staging = UnsafeMutablePointer<UInt8>.allocate(capacity: self.slotCount * brickByteCount)
+    self.slotBricks = UnsafeMutablePointer<Int>.allocate(capacity: self.slotCount)
+    self.slotBricks.initialize(repeating: -1, count: self.slotCount)
+    self.slotRanges = UnsafeMutablePointer<SIMD2<Float>>.allocate(capacity: self.slotCount)
+    self.slotRanges.initialize(repeating: SIMD2<Float>(1, 0), count: self.slotCount)
+    self.slotSemaphore = DispatchSemaphore(value: self.slotCount)
+    for slot in 0..<self.slotCount {
+      freeSlots.push(slot)
+    }
+
+    for _ in 0..<self.workerCount {
+      workerQueue.async { [self] in
+        runWorker()
+      }
+    }
+    logger?.dev("BrickLoader started \(self.workerCount) workers with \(self.slotCount) " +
+                "staging buffers")
+  }
+
+  deinit {
+    staging.deallocate()
+    slotBricks.deallocate()
+    slotRanges.deallocate()
+  }
+
+  /**
+   Stops the workers after their current load. The loader is released once they have exited.
+   */
+  func stop() {
+    stopping.store(true, ordering: .relaxed)
+    for _ in 0..<workerCount {
+      requestSemaphore.signal()
+      slotSemaphore.signal()
+    }
+  }
+
+  /// The number of bricks that are queued, loading or staged.
+  var pendingCount: Int { pending.count }
+
+  /**
+   Waits until a worker has finished a load that `commitReady` has not taken yet.
+
+   Bricks that `commitReady`'s closure declined do not count, so the call sleeps while only
+   those are staged. It may return true shortly before the brick can be taken; callers
+   commit and, if nothing arrived, wait again.
+
+   - Parameter timeout: The maximum time to wait, in seconds.
+   - Returns: False if no load finished within the timeout.
+   */
+  func waitForReady(timeout: Double) -> Bool {
+    guard readySemaphore.wait(timeout: .now() + max(0, timeout)) == .success else {
+      return false
+    }
+    // Only look; the count is taken when `commitReady` takes the slot.
+    readySemaphore.signal()
+    return true
+  }
+
+  /**
+   Requests a brick to be loaded, unless it already is pending.
+
+   - Parameter brickID: The brick index.
+   - Returns: False if the request queue is full; the brick should be requested again later.
+   */
+  @discardableResult
+  func request(_ brickID: Int) -> Bool {
+    guard !pending.contains(brickID) else { return true }
+    guard requests.push(brickID) else { return false }
+    pending.insert(brickID)
+    requestSemaphore.signal()
+    return true
+  }
+
+  /**
+   Hands loaded bricks to `commit` until the budget is used up or no brick is ready.
+
+   Bricks that could not be loaded, e.g. because a remote dataset has not received them
+   yet, are dropped and may be requested again.
+
+   - Parameters:
+   - budget: The brick, byte and time limits for this call.
+   - commit: Called with the brick ID, its data, which is only valid during the call, and
+   the scale and bias that reconstruct its normalized values, (1, 0) unless quantized.
+   Returns false to stop committing; the brick then stays staged for the next call.
+   - Returns: The number of bricks handed to `commit`.
+   */
+  @discardableResult
+  func commitReady(budget: Budget,
+                   _ commit: (Int, UnsafeMutablePointer<UInt8>, SIMD2<Float>) -> Bool) -> Int {
+    let timer = HighResolutionTimer()
+    timer.start()
+    var committed = 0
+
+    while committed == 0 ||
+            (committed < budget.maxBricks && committed * committedByteCount < budget.maxBytes &&
+             timer.sample() < budget.maxDuration) {
+      guard let slot = readySlots.pop() else { break }
+      if keptSlots.remove(slot) == nil {
+        // The worker signals before it queues the slot, so the count is there.
+        _ = readySemaphore.wait(timeout: .now())
+      }
+      let result = slotBricks[slot]
+      if result >= 0 {
+        committed += 1
+        guard commit(result, staging + slot * brickByteCount, slotRanges[slot]) else {
+          keptSlots.insert(slot)
+          readySlots.push(slot)
+          break
+        }
+        pending.remove(result)
+      } else {
+        pending.remove(-result - 1)
+      }
+      freeSlots.push(slot)
+      slotSemaphore.signal()
+    }
+    return committed
+  }
+
+  // MARK: - Workers
+
+  private func runWorker() {
+    while true {
+      requestSemaphore.wait()
+      slotSemaphore.wait()
+      if stopping.load(ordering: .relaxed) { return }
+
+      // Each semaphore count stands for one queued element.
+      guard let brickID = requests.pop(), let slot = freeSlots.pop() else {
+        logger?.error("BrickLoader queues are out of sync with their semaphores")
+        return
+      }
+
+      do {
+        let buffer = staging + slot * brickByteCount
+        try borgData.getBrick(index: brickID, outputBuffer: buffer)
+        if quantize {
+          slotRanges[slot] = BrickQuantizer.quantize(buffer, voxelCount: committedByteCount)
+        }
+        slotBricks[slot] = brickID
+      } catch {
+        slotBricks[slot] = -(brickID + 1)
+      }
+      // Signal first, so `commitReady` never takes a slot whose count is still missing.
+      readySemaphore.signal()
+      readySlots.push(slot)
+    }
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
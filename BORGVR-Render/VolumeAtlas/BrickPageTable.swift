@@ -0,0 +1,122 @@
+import Foundation
+import Synchronization
+
+/**
+ The mapping between bricks and atlas pages, shared by the volume atlas and the emptiness
+ updater.
+
+ Both directions are stored in dense arrays of atomic 32-bit entries, so a lookup is a
+ single load and the updater reads the same table the atlas writes, instead of receiving a
+ copy of it on every page-in. Only the atlas writes the table.
+
+ A brick's entry is not cleared when its page is reused for another brick, so a lookup has
+ to be confirmed with `page(of:)`, which checks the reverse direction.
+ */
+final class BrickPageTable {
+  /// The number of bricks in the dataset.
+  let brickCount: Int
+  /// The number of pages in the atlas.
+  let pageCount: Int
+
+  /// The page each brick was last paged into, or -1.
+  private let brickToPage: UnsafeMutablePointer<Atomic<Int32>>
+  /// The brick each page holds, or -1.
+  private let pageToBrick: UnsafeMutablePointer<Atomic<Int32>>
+
+  /**
+   Initializes an empty table.
+
+   - Parameters:
+   - brickCount: The number of bricks in the dataset.
+   - pageCount: The number of pages in the atlas.
+   */
+  init(brickCount: Int, pageCount: Int) {
+    self.brickCount = brickCount
+    self.pageCount = pageCount
+    self.brickToPage = UnsafeMutablePointer<Atomic<Int32>>.allocate(capacity: max(1, brickCount))
+    self.pageToBrick = UnsafeMutablePointer<Atomic<Int32>>.allocate(capacity: max(1, pageCount))
+    for i in 0..<brickCount {
+      (brickToPage + i).initialize(to: Atomic(-1))
+    }
+    for i in 0..<pageCount {
+      (pageToBrick + i).initialize(to: Atomic(-1))
+    }
+  }
+
+  deinit {
+    brickToPage.deinitialize(count: brickCount)
+    brickToPage.deallocate()
+    pageToBrick.deinitialize(count: pageCount)
+    pageToBrick.deallocate()
+  }
+
+  /**
+   Returns the page that currently holds a brick.
+
+   - Parameter brick: The brick index.
+   - Returns: The page index, or `nil` if the brick is not in the atlas.
+   */
+  func page(of brick: Int) -> Int? {
+    let page = brickToPage[brick].load(ordering: .acquiring)
+    guard page >= 0, pageToBrick[Int(page)].load(ordering: .acquiring) == Int32(brick) else {
+      return nil
+    }
+    return Int(page)
+  }
+
+  /**
+   Returns the brick a page holds.
+
+   - Parameter page: The page index.
+   - Returns: The brick index, or `nil` if the page is free.
+   */
+  func brick(in page: Int) -> Int? {
+    let brick = pageToBrick[page].load(ordering: .acquiring)
+    return brick >= 0 ? Int(brick) : nil
+  }
+
+  /**
+   Records that a page now holds a brick.
+
+   - Parameters:
+   - brick: The brick index.
+   - page: The page index.
+   */
+  func assign(brick: Int, to page: Int) {
+    pageToBrick[page].store(Int32(brick), ordering: .releasing)
+    brickToPage[brick].store(Int32(page), ordering: .releasing)
+  }
+
+  /**
+   Frees all pages except the first `keepingPages`.
+
+   - Parameter keepingPages: The number of pinned pages at the start that keep their brick.
+   */
+  func removeAll(keepingPages: Int = 0) {
+    for page in keepingPages..<pageCount {
+      pageToBrick[page].store(-1, ordering: .releasing)
+    }
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,92 @@
+import Foundation
+
+/**
+ Re-quantizes 16-bit bricks to 8 bits using the value range of each brick, so the atlas
+ holds twice as many bricks.
+
+ A brick's voxels are mapped linearly from `[min, max]` to `[0, 255]`. The shaders undo the
+ mapping with `value * scale + bias` on the normalized texture value, which commutes with
+ trilinear filtering, so the reconstruction error is at most half a step of
+ `(max - min) / 255`.
+ */
+enum BrickQuantizer {
+  /// The vector of 16-bit voxels processed per SIMD operation.
+  private typealias Lane16 = SIMD16<UInt16>
+
+  /**
+   Quantizes a single-component 16-bit brick in place. The 8-bit result occupies the first
+   `voxelCount` bytes of the buffer.
+
+   - Parameters:
+   - data: The brick, `voxelCount` native-endian UInt16 values.
+   - voxelCount: The number of voxels in the brick.
+   - Returns: The scale and bias that map the normalized 8-bit values back to normalized
+   16-bit values.
+   */
+  static func quantize(_ data: UnsafeMutablePointer<UInt8>, voxelCount: Int) -> SIMD2<Float> {
+    guard voxelCount > 0 else { return SIMD2<Float>(1, 0) }
+
+    let source = UnsafeRawPointer(data)
+    let destination = UnsafeMutableRawPointer(data)
+    let laneCount = Lane16.scalarCount
+    let vectorCount = voxelCount / laneCount
+    let stride = MemoryLayout<UInt16>.stride
+
+    // Find the value range.
+    var lowest = Lane16(repeating: .max)
+    var highest = Lane16(repeating: .min)
+    for vector in 0..<vectorCount {
+      let values = source.loadUnaligned(fromByteOffset: vector * laneCount * stride, as: Lane16.self)
+      lowest = pointwiseMin(lowest, values)
+      highest = pointwiseMax(highest, values)
+    }
+    var minValue = lowest.min()
+    var maxValue = highest.max()
+    for voxel in (vectorCount * laneCount)..<voxelCount {
+      let value = source.loadUnaligned(fromByteOffset: voxel * stride, as: UInt16.self)
+      minValue = min(minValue, value)
+      maxValue = max(maxValue, value)
+    }
+
+    // Map the range to 0...255. Every vector is loaded before its bytes are stored, and the
+    // output never overtakes the input, so the conversion can run in place.
+    let range = Float(maxValue) - Float(minValue)
+    let factor: Float = range > 0 ? 255 / range : 0
+    let offset = Float(minValue)
+    for vector in 0..<vectorCount {
+      let values = source.loadUnaligned(fromByteOffset: vector * laneCount * stride, as: Lane16.self)
+      let scaled = (SIMD16<Float>(values) - offset) * factor
+      let quantized = SIMD16<UInt8>(truncatingIfNeeded:
+                                      SIMD16<Int32>(scaled, rounding: .toNearestOrAwayFromZero))
+      destination.storeBytes(of: quantized, toByteOffset: vector * laneCount, as: SIMD16<UInt8>.self)
+    }
+    for voxel in (vectorCount * laneCount)..<voxelCount {
+      let value = source.loadUnaligned(fromByteOffset: voxel * stride, as: UInt16.self)
+      data[voxel] = UInt8(((Float(value) - offset) * factor).rounded())
+    }
+
+    return SIMD2<Float>(range / Float(UInt16.max), offset / Float(UInt16.max))
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,120 @@
+import Foundation
+
+/**
+ An intrusive least-recently-used list over the pages of the volume atlas.
+
+ The list links the pages through two index arrays, so choosing a victim and marking a page
+ as used are both O(1) and no per-frame sorting or allocation is needed. The first
+ `pinnedPages` pages are never part of the list and therefore never evicted.
+ */
+struct PageReplacementList {
+  /// The number of pages at the start of the atlas that are never evicted.
+  let pinnedPages: Int
+
+  /// The previous (less recently used) page of each page, or -1.
+  private var previous: [Int32]
+  /// The next (more recently used) page of each page, or -1.
+  private var next: [Int32]
+  /// The least recently used page, or -1 if the list is empty.
+  private var head: Int32 = -1
+  /// The most recently used page, or -1 if the list is empty.
+  private var tail: Int32 = -1
+
+  /**
+   Initializes the list with all unpinned pages, in page order.
+
+   - Parameters:
+   - pageCount: The number of pages in the atlas.
+   - pinnedPages: The number of pages at the start that are never evicted.
+   */
+  init(pageCount: Int, pinnedPages: Int = 1) {
+    self.pinnedPages = min(pinnedPages, pageCount)
+    self.previous = [Int32](repeating: -1, count: pageCount)
+    self.next = [Int32](repeating: -1, count: pageCount)
+    reset()
+  }
+
+  /// The number of pages that can be evicted.
+  var count: Int { previous.count - pinnedPages }
+
+  /// The page to evict next, or `nil` if all pages are pinned.
+  var leastRecentlyUsed: Int? {
+    head >= 0 ? Int(head) : nil
+  }
+
+  /**
+   Returns the page that was used right after another one, to walk the list from the
+   least recently used page.
+
+   - Parameter page: A page in the list.
+   - Returns: The next more recently used page, or `nil` if `page` is the most recent one.
+   */
+  func moreRecentlyUsed(than page: Int) -> Int? {
+    let following = next[page]
+    return following >= 0 ? Int(following) : nil
+  }
+
+  /**
+   Restores the initial order, e.g. after all pages were freed.
+   */
+  mutating func reset() {
+    head = -1
+    tail = -1
+    for page in pinnedPages..<previous.count {
+      previous[page] = -1
+      next[page] = -1
+      append(Int32(page))
+    }
+  }
+
+  /**
+   Marks a page as used, so it is evicted after all other pages.
+
+   - Parameter page: The page index; pinned pages are ignored.
+   */
+  mutating func touch(_ page: Int) {
+    guard page >= pinnedPages, Int32(page) != tail else { return }
+    unlink(Int32(page))
+    append(Int32(page))
+  }
+
+  // MARK: - Linking
+
+  private mutating func unlink(_ page: Int32) {
+    let p = previous[Int(page)]
+    let n = next[Int(page)]
+    if p >= 0 { next[Int(p)] = n } else { head = n }
+    if n >= 0 { previous[Int(n)] = p } else { tail = p }
+    previous[Int(page)] = -1
+    next[Int(page)] = -1
+  }
+
+  private mutating func append(_ page: Int32) {
+    previous[Int(page)] = tail
+    next[Int(page)] = -1
+    if tail >= 0 { next[Int(tail)] = page } else { head = page }
+    tail = page
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,189 @@
+import Foundation
+
+/**
+ The layout of the brick metadata buffer as a two-level page directory, so the GPU table
+ only grows with the parts of the dataset whose metadata is not uniform.
+
+ The bricks are split into leaves of `BRICK_LEAF_SIZE` consecutive brick indices. The buffer
+ starts with one directory entry per leaf, followed by a pool of leaves:
+ - An entry below `BI_FLAG_COUNT` is the flag shared by all bricks of the leaf, so leaves
+   that are entirely missing, empty or child-empty take no space in the pool.
+ - Otherwise the entry is `BI_FLAG_COUNT` plus the buffer offset of the leaf, which holds
+   the metadata of its bricks like the dense table.
+
+ The directory does not know about Metal; it writes into any buffer of `elementCount`
+ entries. When the pool is full, the owner of the buffer grows it with `grow(leafCapacity:)`
+ and copies the old contents, as all offsets stay valid. `lookup(_:in:)` is the CPU
+ reference of `getBrickInfo` in VolumeAtlas.h.
+
+ The buffer is written in place while frames that read an older directory entry may still
+ be in flight, so a released leaf is not reused right away. It is retired with the number
+ of the last frame that may read it and returns to the pool once
+ `releaseRetiredLeaves(completedFrame:)` reports that frame as completed.
+ */
+struct SparseBrickDirectory {
+  /// The number of bricks per leaf.
+  static let leafSize = Int(BRICK_LEAF_SIZE)
+
+  /// The number of bricks in the dataset.
+  let brickCount: Int
+  /// The number of leaves, which is also the number of directory entries.
+  let leafCount: Int
+  /// The number of leaves the pool can hold.
+  private(set) var leafCapacity: Int
+  /// A copy of the directory entries in the buffer.
+  private var directory: [UInt32]
+  /// The pool indices of the unused leaves, taken from the end.
+  private var freeLeaves: [Int]
+  /// Released leaves with the last frame that may still read them, oldest first.
+  private var retiredLeaves: [(poolIndex: Int, frame: Int)] = []
+
+  /**
+   Initializes a directory in which every brick is missing.
+
+   - Parameters:
+   - brickCount: The number of bricks in the dataset.
+   - leafCapacity: The initial number of leaves in the pool.
+   */
+  init(brickCount: Int, leafCapacity: Int) {
+    self.brickCount = brickCount
+    self.leafCount = (brickCount + SparseBrickDirectory.leafSize - 1) / SparseBrickDirectory.leafSize
+    self.leafCapacity = min(max(1, leafCapacity), leafCount)
+    self.directory = [UInt32](repeating: UInt32(BrickIDFlags.BI_MISSING.rawValue),
+                              count: leafCount)
+    self.freeLeaves = Array((0..<self.leafCapacity).reversed())
+  }
+
+  /// The number of UInt32 entries the buffer must hold.
+  var elementCount: Int {
+    leafCount + leafCapacity * SparseBrickDirectory.leafSize
+  }
+
+  /// The number of leaves in use.
+  var usedLeafCount: Int {
+    leafCapacity - freeLeaves.count - retiredLeaves.count
+  }
+
+  /// The number of released leaves that wait for their frame to complete.
+  var retiredLeafCount: Int {
+    retiredLeaves.count
+  }
+
+  /// The directory entries for the start of the buffer; the pool needs no initialization.
+  var initialDirectory: [UInt32] {
+    directory
+  }
+
+  /**
+   Adds leaves to the pool. The buffer must be grown to the new `elementCount`, keeping
+   its contents.
+
+   - Parameter leafCapacity: The new number of leaves, clamped to `leafCount`.
+   */
+  mutating func grow(leafCapacity: Int) {
+    let newCapacity = min(leafCapacity, leafCount)
+    guard newCapacity > self.leafCapacity else { return }
+    freeLeaves.insert(contentsOf: (self.leafCapacity..<newCapacity).reversed(), at: 0)
+    self.leafCapacity = newCapacity
+  }
+
+  /**
+   Returns the retired leaves whose frame has completed to the pool.
+
+   - Parameter completedFrame: The frame up to which all frames have completed.
+   */
+  mutating func releaseRetiredLeaves(completedFrame: Int) {
+    let released = retiredLeaves.prefix(while: { $0.frame <= completedFrame })
+    guard !released.isEmpty else { return }
+    freeLeaves.append(contentsOf: released.map { $0.poolIndex })
+    retiredLeaves.removeFirst(released.count)
+  }
+
+  /**
+   Writes the metadata of one leaf into the buffer. A uniform flag is stored in the
+   directory and retires the leaf's pool entry; any other content is copied into a leaf,
+   which is written before the directory entry that points to it.
+
+   - Parameters:
+   - leaf: The leaf index.
+   - entries: The metadata of the leaf's bricks; shorter than `leafSize` for the last leaf.
+   - buffer: The buffer of `elementCount` entries.
+   - frame: The last frame that may have read the current directory entry; a released leaf
+   is reused once this frame has completed. Must not decrease between calls.
+   - Returns: The number of bytes written, or `nil` if the pool has no free leaf.
+   */
+  mutating func update(leaf: Int, entries: UnsafeBufferPointer<UInt32>,
+                       buffer: UnsafeMutablePointer<UInt32>, frame: Int = 0) -> Int? {
+    let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+    let stride = MemoryLayout<UInt32>.stride
+    var entry = directory[leaf]
+
+    if let first = entries.first, first < flagCount, !entries.contains(where: { $0 != first }) {
+      if entry >= flagCount {
+        retiredLeaves.append((poolIndex(of: entry), frame))
+      }
+      directory[leaf] = first
+      buffer[leaf] = first
+      return stride
+    }
+
+    if entry < flagCount {
+      guard let poolIndex = freeLeaves.popLast() else { return nil }
+      entry = UInt32(leafCount + poolIndex * SparseBrickDirectory.leafSize) + flagCount
+    }
+    if let source = entries.baseAddress {
+      (buffer + Int(entry - flagCount)).update(from: source, count: entries.count)
+    }
+    directory[leaf] = entry
+    buffer[leaf] = entry
+    return (entries.count + 1) * stride
+  }
+
+  /**
+   Returns the pool index of the leaf a directory entry points to.
+
+   - Parameter entry: A directory entry of at least `BI_FLAG_COUNT`.
+   - Returns: The pool index.
+   */
+  private func poolIndex(of entry: UInt32) -> Int {
+    let offset = Int(entry - UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue))
+    return (offset - leafCount) / SparseBrickDirectory.leafSize
+  }
+
+  /**
+   Looks up the metadata of a brick the same way the shaders do.
+
+   - Parameters:
+   - brickIndex: The brick index.
+   - buffer: The buffer written by `update(leaf:entries:buffer:)`.
+   - Returns: The brick's metadata: a flag, or its page plus `BI_FLAG_COUNT`.
+   */
+  static func lookup(_ brickIndex: Int, in buffer: UnsafePointer<UInt32>) -> UInt32 {
+    let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+    let entry = buffer[brickIndex / leafSize]
+    if entry < flagCount { return entry }
+    return buffer[Int(entry - flagCount) + brickIndex % leafSize]
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use, copy,
+ modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and
+ to permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
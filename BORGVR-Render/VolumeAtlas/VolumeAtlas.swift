@@ -23,79 +23,6 @@ enum PageError: Error {
   }
 }
 
-/**
- A structure containing metadata for a page in the texture atlas.
-
- Each PageMetadata records the page ID, the associated brick ID, the arrival time
- (as an index), and a backup of the previous arrival index.
- */
-struct PageMetadata {
-  let pageID: Int
-  var brickID: Int
-  var arrivalIndex: Int
-  var previousIndex: Int
-
-  /**
-   Initializes a new PageMetadata instance.
-
-   - Parameters:
-   - pageID: The identifier for the page.
-   - brickID: The brick identifier.
-   - arrivalIndex: The arrival index timestamp.
-   */
-  init(pageID: Int, brickID: Int, arrivalIndex: Int) {
-    self.pageID = pageID
-    self.brickID = brickID
-    self.arrivalIndex = arrivalIndex
-    self.previousIndex = arrivalIndex
-  }
-
-  /**
-   Checks if the page contains a visible brick.
-
-   - Returns: True if the arrival index is greater than zero; otherwise, false.
-   */
-  func containsVisibleBrick() -> Bool {
-    return arrivalIndex > 0
-  }
-
-  /**
-   Flags the page as empty.
-
-   This method saves the current arrivalIndex to previousIndex and sets the arrivalIndex to zero.
-   */
-  mutating func flagEmpty() {
-    self.previousIndex = arrivalIndex
-    arrivalIndex = 0
-  }
-
-  /**
-   Reactivates the page if it contains the specified brick.
-
-   - Parameter brickID: The brick ID to check.
-   - Returns: True if the page is reactivated; otherwise, false.
-   */
-  mutating func reactivate(ifItContains brickID: Int) -> Bool {
-    if self.brickID != brickID {
-      return false
-    }
-    self.arrivalIndex = previousIndex
-    return true
-  }
-
-  /**
-   Sets new values for the brick ID and arrival index.
-
-   - Parameters:
-   - brickID: The new brick identifier.
-   - arrivalIndex: The new arrival index.
-   */
-  mutating func set(brickID: Int, arrivalIndex: Int) {
-    self.brickID = brickID
-    self.arrivalIndex = arrivalIndex
-  }
-}
-
 /**
  An error type for volume atlas operations.
  */
@@ -118,16 +45,75 @@ enum VolumeAtlasError: Error {
 
  It creates and manages GPU textures, metadata buffers, and level-of-detail tables. It also
  interacts with an asynchronous emptiness updater to update the visibility state of bricks.
+
+ The atlas texture and the metadata buffer are shared with the GPU and written in place,
+ so a frame in flight sees the changes of later `pageIn` calls. Unmapping a brick is
+ harmless, the frame falls back to a coarser one, but a page is only filled with a new
+ brick once all frames that may still sample its old brick have completed, see `frames`.
  */
 class VolumeAtlas {
+
+  /// How `pageIn` chooses the pages to evict.
+  struct EvictionPolicy {
+    /// The number of least recently used pages compared for each eviction; the one whose
+    /// brick is cheapest to lose is evicted. 1 gives plain LRU.
+    var window: Int
+    /// The number of coarsest levels whose bricks are protected by `reservedPages`.
+    var reservedLevels: Int
+    /// The number of pages with bricks of the `reservedLevels` coarsest levels that only
+    /// bricks of those levels may evict. Capped at half of the atlas.
+    var reservedPages: Int
+  }
+
   private var device: MTLDevice
   /// The 3D texture atlas storing voxel data.
   var atlasTexture: MTLTexture!
   private var levelTable: MTLBuffer!
+  /// The value scale and bias of each page, (1, 0) unless the atlas is quantized.
+  private var pageRanges: MTLBuffer!
+  /// Whether 16-bit bricks are stored as 8 bits, see `BrickQuantizer`.
+  let isQuantized: Bool
+  /// The brick metadata as a two-level directory laid out by `brickDirectory`.
   private var metaBuffer: MTLBuffer!
+  private var brickDirectory = SparseBrickDirectory(brickCount: 0, leafCapacity: 0)
   private var metaStorage: [UInt32] = []
-  private var pageMetadata: [PageMetadata] = []
-  private var brickToPage: [Int: Int] = [:]
+  /// One bit per directory leaf of `metaChunkSize` metaStorage entries that differs from
+  /// metaBuffer.
+  private var dirtyMetaChunks: [UInt64] = []
+  /// The metaStorage changes made by paging, forwarded to the emptiness updater.
+  private var pagedChanges: [AsyncEmptinessUpdater.MetadataChange] = []
+  /// The number of bytes copied into metaBuffer since the last `takeUploadedMetaBytes` call.
+  private var uploadedMetaBytes = 0
+  /// The number of pages in the atlas, including the pinned page 0.
+  private var pageCount = 0
+  /// The eviction order of the pages; page 0 holds the coarsest brick and is pinned.
+  private var pageReplacement = PageReplacementList(pageCount: 0)
+  /// The frames submitted and completed by the renderer. Without it, e.g. before the first
+  /// frame, pages are refilled right away.
+  var frames: FrameRing?
+  /// The last frame that may sample the previous brick of each page; the page is not
+  /// refilled before this frame has completed.
+  private var pageFences: [Int] = []
+  /// Pages whose brick `pageIn` unmapped and that wait for their fence to be refilled.
+  private var retiredPages = Set<Int>()
+  /// The brick/page mapping, shared with the emptiness updater.
+  private let brickPages: BrickPageTable
+  /// The victim selection of `pageIn`.
+  var evictionPolicy = EvictionPolicy(window: 8, reservedLevels: 2, reservedPages: 256) {
+    didSet {
+      reservedPageCount = (1..<max(1, pageCount)).reduce(0) { count, page in
+        guard let brick = brickPages.brick(in: page) else { return count }
+        return isReserved(brick) ? count + 1 : count
+      }
+    }
+  }
+  /// The cost of evicting a brick of each level: one for the brick itself plus the
+  /// average number of finer bricks that fall back to it.
+  private var levelCosts: [Float] = []
+  /// The index of the first brick of each level.
+  private var levelStarts: [Int] = []
+  /// The number of unpinned pages holding a brick of the reserved levels.
+  private var reservedPageCount = 0
   private var transferFunction: TransferFunction1D
   private var purgeDataOnNextPage = false
   private var elementsInBuffer = 0
@@ -135,18 +121,32 @@ class VolumeAtlas {
   /// An optional logger for debug and error messages.
   private let logger: LoggerBase?
 
-  private var pageFrame = 1 // Must start at 1, as 0 signals "empty"
+  /// The number of metaStorage entries uploaded together when one of them changed, one
+  /// directory leaf.
+  private static let metaChunkSize = SparseBrickDirectory.leafSize
+  /// The number of directory leaves allocated up front; the pool doubles when it is full.
+  private static let initialLeafCapacity = 64
   private var brickStorage = (0, 0, 0)
 
   private var borgData: BORGVRDatasetProtocol
   private var borgBuffer: UnsafeMutablePointer<UInt8>
 
   private var asyncEmptinessUpdater: AsyncEmptinessUpdater
+  /// Loads requested bricks on worker threads for `pageIn` to commit.
+  private let brickLoader: BrickLoader
+  /// The limits for a single `pageIn` call; the time covers the whole call.
+  var pagingBudget = BrickLoader.Budget(maxBricks: 64, maxBytes: 16 * 1024 * 1024,
+                                        maxDuration: 0.004)
+  /// Requests that were not admitted to the loader, retried in the next `pageIn` call.
+  private var deferredRequests: [(brickID: Int, hits: UInt32)] = []
+  /// The maximum number of deferred requests; the least important ones are dropped.
+  private static let maxDeferredRequests = 4096
 
   // Cached values.
   private lazy var bytesPerPixel: Int = {
     let metadata = self.borgData.getMetadata()
-    return metadata.bytesPerComponent * metadata.componentCount
+    return VolumeAtlas.atlasBytesPerComponent(for: metadata, quantize: isQuantized) *
+    metadata.componentCount
   }()
   private lazy var bytesPerRow: Int = {
     let metadata = self.borgData.getMetadata()
@@ -166,10 +166,12 @@ class VolumeAtlas {
    - borgData: The dataset providing brick data.
    - transferFunction: The transfer function used for emptiness testing.
    - isoValue: The normalized isovalue.
+   - quantize: Whether to store 16-bit single-component bricks as 8 bits; ignored for
+   other data.
    - Throws: VolumeAtlasError if texture creation fails.
    */
   init(device: MTLDevice, maxMemory: Int, borgData: BORGVRDatasetProtocol,
-       transferFunction: TransferFunction1D, isoValue: Float,
+       transferFunction: TransferFunction1D, isoValue: Float, quantize: Bool = false,
        logger: LoggerBase? = nil) throws {
 
     self.device = device
@@ -177,26 +179,44 @@ class VolumeAtlas {
     self.borgBuffer = borgData.allocateBrickBuffer()
     self.logger = logger
     self.transferFunction = transferFunction
-    self.asyncEmptinessUpdater = AsyncEmptinessUpdater(
+
+    let metadata = borgData.getMetadata()
+    let atlasBytesPerComponent = VolumeAtlas.atlasBytesPerComponent(for: metadata,
+                                                                     quantize: quantize)
+    let isQuantized = atlasBytesPerComponent != metadata.bytesPerComponent
+    self.isQuantized = isQuantized
+
+    let maxWorkers = min(4, max(1, ProcessInfo.processInfo.activeProcessorCount - 2))
+    self.brickLoader = BrickLoader(
       borgData: borgData,
-      transferFunction: transferFunction,
-      isoValue: isoValue,
+      workerCount: borgData.supportsConcurrentGetBrick ? maxWorkers : 1,
+      quantize: isQuantized,
       logger: logger
     )
 
-    let metadata = self.borgData.getMetadata()
     let (width, height, depth, inCoreBrickCount) = VolumeAtlas.computeAtlasSize(
       maxMemory: maxMemory,
       maxBrickCount: metadata.brickMetadata.count,
       brickSize: metadata.brickSize,
-      bytesPerComponent: metadata.bytesPerComponent,
+      bytesPerComponent: atlasBytesPerComponent,
       componentCount: metadata.componentCount
     )
 
+    let brickPages = BrickPageTable(brickCount: metadata.brickMetadata.count,
+                                    pageCount: inCoreBrickCount)
+    self.brickPages = brickPages
+    self.asyncEmptinessUpdater = AsyncEmptinessUpdater(
+      borgData: borgData,
+      brickPages: brickPages,
+      transferFunction: transferFunction,
+      isoValue: isoValue,
+      logger: logger
+    )
+
     let brickSize = metadata.brickSize
     self.brickStorage = (width / brickSize, height / brickSize, depth / brickSize)
     let pixelFormat = VolumeAtlas.getPixelFormat(
-      bytesPerComponent: metadata.bytesPerComponent,
+      bytesPerComponent: atlasBytesPerComponent,
       componentCount: metadata.componentCount
     )
 
@@ -222,18 +242,37 @@ class VolumeAtlas {
       count: brickCount
     )
 
-    let alignedMetaStorageCount = (MemoryLayout<UInt32>.stride * brickCount + 255) & -256
+    // Only the directory is allocated densely; leaves are added as bricks are paged in or
+    // flagged, so the buffer does not grow with the dataset.
+    brickDirectory = SparseBrickDirectory(brickCount: brickCount,
+                                          leafCapacity: VolumeAtlas.initialLeafCapacity)
+    let alignedMetaStorageCount = (MemoryLayout<UInt32>.stride * brickDirectory.elementCount + 255) & -256
     self.metaBuffer = device.makeBuffer(length: alignedMetaStorageCount,
                                         options: .storageModeShared)
     self.metaBuffer.contents().copyMemory(
-      from: metaStorage,
-      byteCount: MemoryLayout<UInt32>.stride * brickCount
+      from: brickDirectory.initialDirectory,
+      byteCount: MemoryLayout<UInt32>.stride * brickDirectory.leafCount
     )
+    let metaChunkCount = (brickCount + VolumeAtlas.metaChunkSize - 1) / VolumeAtlas.metaChunkSize
+    dirtyMetaChunks = [UInt64](repeating: 0, count: (metaChunkCount + 63) / 64)
+
+    pageCount = inCoreBrickCount
+    pageReplacement = PageReplacementList(pageCount: inCoreBrickCount, pinnedPages: 1)
+    pageFences = [Int](repeating: 0, count: inCoreBrickCount)
 
-    pageMetadata = (0..<inCoreBrickCount).map { index in
-      return PageMetadata(pageID: index, brickID: -1, arrivalIndex: 0)
+    let levelBrickCounts = metadata.levelMetadata.map {
+      Float($0.totalBricks.x * $0.totalBricks.y * $0.totalBricks.z)
+    }
+    levelStarts = metadata.levelMetadata.map { $0.prevBricks }
+    levelCosts = levelBrickCounts.indices.map { level in
+      1 + levelBrickCounts[..<level].reduce(0) { $0 + $1 / levelBrickCounts[level] }
     }
 
+    let identityRanges = [SIMD2<Float>](repeating: SIMD2<Float>(1, 0), count: inCoreBrickCount)
+    self.pageRanges = device.makeBuffer(bytes: identityRanges,
+                                        length: MemoryLayout<SIMD2<Float>>.stride * inCoreBrickCount,
+                                        options: .storageModeShared)
+
     // Create LOD Offset Table.
     let levelMetadata = metadata.levelMetadata
     let levelStorage = (0..<levelMetadata.count).map { index in
@@ -276,12 +315,16 @@ class VolumeAtlas {
 
     // Ensure the lowest-res single brick is paged in at position 0, so it always is guaranteed to be resident
     try borgData.getFirstBrick(outputBuffer: borgBuffer)
+    if isQuantized {
+      setPageRange(0, BrickQuantizer.quantize(borgBuffer, voxelCount: brickLoader.committedByteCount))
+    }
     replaceAtlasBrick(x: 0, y: 0, z: 0, data: borgBuffer)
     let lastBrickIndex = brickCount - 1
-    metaStorage[lastBrickIndex] = UInt32(0 + BrickIDFlags.BI_FLAG_COUNT.rawValue)
-    brickToPage[lastBrickIndex] = 0
-    pageMetadata[0].set(brickID: lastBrickIndex, arrivalIndex: Int.max - 1)
+    setMetaStorage(lastBrickIndex, UInt32(0 + BrickIDFlags.BI_FLAG_COUNT.rawValue))
+    brickPages.assign(brick: lastBrickIndex, to: 0)
 
+    asyncEmptinessUpdater.updateMetadata(changes: pagedChanges)
+    pagedChanges.removeAll(keepingCapacity: true)
     updateMetaBuffer()
 
     logger?.dev("VolumeAtlas initialized")
@@ -289,19 +332,120 @@ class VolumeAtlas {
 
   deinit {
     asyncEmptinessUpdater.terminateBackgroundTask()
+    brickLoader.stop()
     borgBuffer.deallocate()
     logger?.dev("VolumeAtlas deinitialized")
   }
 
   /**
-   Updates the CPU-side metadata buffer from metaStorage.
+   Sets a metaStorage entry and records the change for the emptiness updater.
+
+   - Parameters:
+   - index: The brick index.
+   - value: The new metadata value.
+   */
+  private func setMetaStorage(_ index: Int, _ value: UInt32) {
+    metaStorage[index] = value
+    markMetaDirty(index)
+    pagedChanges.append(AsyncEmptinessUpdater.MetadataChange(index: index, value: value))
+  }
+
+  /**
+   Flags the chunk containing a metaStorage entry for the next upload.
+
+   - Parameter index: The brick index.
+   */
+  private func markMetaDirty(_ index: Int) {
+    let chunk = index / VolumeAtlas.metaChunkSize
+    dirtyMetaChunks[chunk >> 6] |= UInt64(1) << UInt64(chunk & 63)
+  }
+
+  /**
+   Writes the dirty chunks of metaStorage into the metadata directory, growing the leaf
+   pool when it is full. A chunk that cannot be written stays dirty. Leaves released by
+   earlier calls are reused once the frames that may read them have completed.
    */
   private func updateMetaBuffer() {
-    _ = metaStorage.withUnsafeBytes { srcPointer in
-      memcpy(metaBuffer.contents(),
-             srcPointer.baseAddress,
-             metaStorage.count * MemoryLayout<UInt32>.stride)
+    let chunkSize = VolumeAtlas.metaChunkSize
+    let frame = lastSubmittedFrame
+    brickDirectory.releaseRetiredLeaves(completedFrame: frames?.completedFrame ?? Int.max)
+    metaStorage.withUnsafeBufferPointer { source in
+      for word in 0..<dirtyMetaChunks.count where dirtyMetaChunks[word] != 0 {
+        var bits = dirtyMetaChunks[word]
+        while bits != 0 {
+          let bit = bits.trailingZeroBitCount
+          let chunk = word * 64 + bit
+          let start = chunk * chunkSize
+          let entries = UnsafeBufferPointer(rebasing: source[start..<min(start + chunkSize, source.count)])
+
+          var written = brickDirectory.update(leaf: chunk, entries: entries,
+                                              buffer: metaDirectory, frame: frame)
+          if written == nil && growMetaBuffer() {
+            written = brickDirectory.update(leaf: chunk, entries: entries,
+                                            buffer: metaDirectory, frame: frame)
+          }
+          guard let written else { return }
+
+          uploadedMetaBytes += written
+          bits &= bits - 1
+          dirtyMetaChunks[word] &= ~(UInt64(1) << UInt64(bit))
+        }
+      }
+    }
+  }
+
+  /// The metadata buffer's contents.
+  private var metaDirectory: UnsafeMutablePointer<UInt32> {
+    metaBuffer.contents().bindMemory(to: UInt32.self, capacity: brickDirectory.elementCount)
+  }
+
+  /**
+   Doubles the leaf pool of the metadata directory. The old buffer is kept alive by the
+   frames still using it, so its contents are copied into a new one.
+
+   - Returns: False if the new buffer could not be allocated.
+   */
+  private func growMetaBuffer() -> Bool {
+    let stride = MemoryLayout<UInt32>.stride
+    var directory = brickDirectory
+    directory.grow(leafCapacity: 2 * directory.leafCapacity)
+    guard directory.leafCapacity > brickDirectory.leafCapacity,
+          let buffer = device.makeBuffer(length: (stride * directory.elementCount + 255) & -256,
+                                         options: .storageModeShared) else {
+      logger?.error("Failed to grow the brick metadata directory beyond " +
+                    "\(brickDirectory.leafCapacity) leaves")
+      return false
     }
+    buffer.contents().copyMemory(from: metaBuffer.contents(),
+                                 byteCount: stride * brickDirectory.elementCount)
+    metaBuffer = buffer
+    brickDirectory = directory
+    logger?.dev("Brick metadata directory grown to \(directory.leafCapacity) of " +
+                "\(directory.leafCount) leaves")
+    return true
+  }
+
+  /**
+   Sets the value scale and bias of a page.
+
+   - Parameters:
+   - page: The page index.
+   - range: The scale and bias of the brick in the page.
+   */
+  private func setPageRange(_ page: Int, _ range: SIMD2<Float>) {
+    pageRanges.contents().storeBytes(of: range,
+                                     toByteOffset: page * MemoryLayout<SIMD2<Float>>.stride,
+                                     as: SIMD2<Float>.self)
+  }
+
+  /**
+   Returns the number of bytes copied into the metadata buffer since the last call.
+
+   - Returns: The number of bytes.
+   */
+  func takeUploadedMetaBytes() -> Int {
+    defer { uploadedMetaBytes = 0 }
+    return uploadedMetaBytes
   }
 
   /**
@@ -336,16 +480,43 @@ class VolumeAtlas {
    - atlasIndex: The texture index for the atlas.
    - metaIndex: The buffer index for the metadata.
    - levelIndex: The buffer index for the LOD offset table.
+   - rangeIndex: The buffer index for the value scale and bias of each page.
    */
   func bind(to encoder: MTLRenderCommandEncoder,
-            atlasIndex: Int, metaIndex: Int, levelIndex: Int) {
-    if let newMetaStorage = asyncEmptinessUpdater.inCoreDataHasChanged() {
-      metaStorage = newMetaStorage
+            atlasIndex: Int, metaIndex: Int, levelIndex: Int, rangeIndex: Int) {
+    if let changes = asyncEmptinessUpdater.inCoreDataHasChanged() {
+      let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+      for change in changes {
+        // Earlier frames may still sample the page of a brick that was flagged empty.
+        let previous = metaStorage[change.index]
+        if previous >= flagCount && previous != change.value {
+          pageFences[Int(previous - flagCount)] = lastSubmittedFrame
+        }
+        metaStorage[change.index] = change.value
+        markMetaDirty(change.index)
+      }
       updateMetaBuffer()
     }
     encoder.setFragmentTexture(atlasTexture, index: atlasIndex)
     encoder.setFragmentBuffer(metaBuffer, offset: 0, index: metaIndex)
     encoder.setFragmentBuffer(levelTable, offset: 0, index: levelIndex)
+    encoder.setFragmentBuffer(pageRanges, offset: 0, index: rangeIndex)
+  }
+
+  /**
+   Returns the number of bytes per component the atlas stores for a dataset. Quantization
+   only applies to single-component 16-bit data.
+
+   - Parameters:
+   - metadata: The dataset's metadata.
+   - quantize: Whether quantization was requested.
+   - Returns: 1 if the bricks are quantized, otherwise the dataset's bytes per component.
+   */
+  static func atlasBytesPerComponent(for metadata: BORGVRMetaData, quantize: Bool) -> Int {
+    if quantize && metadata.bytesPerComponent == 2 && metadata.componentCount == 1 {
+      return 1
+    }
+    return metadata.bytesPerComponent
   }
 
   /**
@@ -409,25 +580,123 @@ class VolumeAtlas {
     asyncEmptinessUpdater.updateIsoValue(isoValue: isoValue)
   }
 
+  /**
+   Tells the dataset that the misses of a new frame follow, so a remote dataset can serve
+   them first and drop requests that are no longer needed. Call it once per frame that
+   reports misses, before `pageIn`; calls that only continue pending work must not
+   invalidate the outstanding requests.
+   */
+  func newRequest() {
+    borgData.newRequest()
+  }
+
+  /// The number of the last frame the renderer submitted, which may sample the current
+  /// metadata; 0 without `frames`.
+  private var lastSubmittedFrame: Int {
+    frames?.submittedFrame ?? 0
+  }
+
+  /// Whether deferred requests or loaded bricks wait for a `pageIn` call.
+  var hasPendingWork: Bool {
+    !deferredRequests.isEmpty || brickLoader.pendingCount > 0
+  }
+
+  /**
+   Returns the bricks held by the atlas, e.g. to save them for `warmStart`.
+
+   Pages whose brick has since been flagged empty are left out, as is the pinned page.
+
+   - Returns: The brick IDs, from the most to the least recently used page.
+   */
+  func residentBrickIDs() -> [Int] {
+    let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+    var bricks: [Int] = []
+    var page = pageReplacement.leastRecentlyUsed
+    while let current = page {
+      if let brick = brickPages.brick(in: current),
+         metaStorage[brick] == UInt32(current) + flagCount {
+        bricks.append(brick)
+      }
+      page = pageReplacement.moreRecentlyUsed(than: current)
+    }
+    return bricks.reversed()
+  }
+
+  /**
+   Pages in a saved working set before the first frame.
+
+   Calls `pageIn` with a budget of a full staging ring per call and no byte limit, and
+   between calls sleeps until the loader has finished a brick, until all bricks are paged
+   in or `timeLimit` is used up. Requests that are left over stay deferred and are handled
+   by the following `pageIn` calls within the regular `pagingBudget`.
+
+   - Parameters:
+   - IDs: The brick IDs to page in.
+   - hits: The priority of each brick within its level, see `pageIn`.
+   - timeLimit: The maximum time to wait, in seconds.
+   - Returns: The number of the requested bricks that are in the atlas afterwards.
+   */
+  @discardableResult
+  func warmStart(IDs: [Int], hits: [UInt32], timeLimit: Double) -> Int {
+    let timer = HighResolutionTimer()
+    timer.start()
+
+    let frameBudget = pagingBudget
+    pagingBudget = BrickLoader.Budget(maxBricks: brickLoader.slotCount, maxBytes: Int.max,
+                                      maxDuration: min(timeLimit, 0.05))
+    defer { pagingBudget = frameBudget }
+
+    do {
+      try pageIn(IDs: IDs, hits: hits)
+      while hasPendingWork {
+        let remaining = timeLimit - timer.sample()
+        guard remaining > 0 else { break }
+        // Deferred requests are admitted as soon as the loader has room.
+        if brickLoader.pendingCount > 0 && !brickLoader.waitForReady(timeout: remaining) {
+          break
+        }
+        try pageIn(IDs: [])
+      }
+    } catch {
+      logger?.warning("Warm start stopped early: \(error)")
+    }
+
+    let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+    return IDs.filter { $0 >= 0 && $0 < metaStorage.count && metaStorage[$0] >= flagCount }.count
+  }
+
   /**
    Returns the total capacity (number of pages) in the atlas.
 
    - Returns: The number of pages.
    */
   func getCapacity() -> Int {
-    return pageMetadata.count
+    return pageCount
   }
 
   /**
    Pages in bricks specified by their IDs into the atlas.
 
-   For each brick, if it is not already paged in and is not empty,
-   the brick data is loaded, metadata updated, and the atlas texture is replaced.
+   The requests are handled in order of visual importance: coarse levels first, then
+   bricks with more hits, i.e. covering more of the screen. Each brick that is not already
+   paged in and is not empty is requested from the brick loader, which reads it on a worker
+   thread. Once the loader holds enough work for the budget, or the time budget is used up,
+   the remaining requests are deferred to the next call. Bricks the loader has finished,
+   from this or earlier calls, are then copied into the atlas texture until `pagingBudget`
+   is used up. New bricks replace the least recently used pages; pages that are filled or
+   reactivated move to the back of the eviction order. A page whose brick the frames in
+   flight may still sample is retired instead: its brick is unmapped, and the page is
+   refilled by a later call once those frames have completed.
 
-   - Parameter IDs: An array of brick IDs to page in.
+   - Parameters:
+   - IDs: An array of brick IDs to page in.
+   - hits: The number of times each brick was requested, e.g. by the GPU hash table;
+   empty to weigh all bricks the same.
    - Throws: A PageError if the working set exceeds capacity.
    */
-  func pageIn(IDs: [Int]) throws {
+  func pageIn(IDs: [Int], hits: [UInt32] = []) throws {
+    let timer = HighResolutionTimer()
+    timer.start()
     var incompleteIndex = 0
     let BI_MISSING = UInt32(BrickIDFlags.BI_MISSING.rawValue)
     let BI_EMPTY = UInt32(BrickIDFlags.BI_EMPTY.rawValue)
@@ -441,38 +710,36 @@ class VolumeAtlas {
       logger?.dev("Purging atlas data. Elements PREVIOUSLY in buffer: \(elementsInBuffer) size of the working set: \(Float(workIngSetSize)/Float(1024*1024)) MB")
       for index in 0..<metaStorage.count-1 {
         if metaStorage[index] >= BI_FLAG_COUNT {
-          metaStorage[index] = BI_MISSING
+          setMetaStorage(index, BI_MISSING)
         }
       }
       purgeDataOnNextPage = false
       elementsInBuffer = 0
-      let lastBrickIndex = metadata.brickMetadata.count - 1
-      brickToPage.removeAll()
-      brickToPage[lastBrickIndex] = 0
-
-      for index in 1..<pageMetadata.count {
-        pageMetadata[index] = PageMetadata(pageID: index, brickID: -1, arrivalIndex: 0)
+      reservedPageCount = 0
+      brickPages.removeAll(keepingPages: 1)
+      pageReplacement.reset()
+      for page in 1..<pageCount {
+        pageFences[page] = lastSubmittedFrame
       }
+      retiredPages.removeAll()
     }
 
-
-    let sortedIndices = pageMetadata
-      .enumerated()
-      .sorted {
-        if $0.element.arrivalIndex == $1.element.arrivalIndex {
-          return $0.element.previousIndex < $1.element.previousIndex
-        }
-        return $0.element.arrivalIndex < $1.element.arrivalIndex
-      }
-      .map { $0.offset }
-
     let metaData = borgData.getMetadata().brickMetadata
 
-    borgData.newRequest()
+    let requests = importanceOrder(IDs: IDs, hits: hits)
+    let admissionLimit = max(2 * pagingBudget.maxBricks, brickLoader.slotCount)
+    deferredRequests.removeAll(keepingCapacity: true)
 
-    var insertionIndex = 0
-    for newBrickID in IDs {
-      if newBrickID >= metaStorage.count {
+    for (requestIndex, request) in requests.enumerated() {
+      let newBrickID = request.brickID
+      if brickLoader.pendingCount >= admissionLimit || timer.sample() >= pagingBudget.maxDuration {
+        deferredRequests.append(
+          contentsOf: requests[requestIndex...].prefix(
+            VolumeAtlas.maxDeferredRequests - deferredRequests.count))
+        break
+      }
+
+      if newBrickID < 0 || newBrickID >= metaStorage.count {
         logger?.dev("Received invalid brick ID \(newBrickID)")
         continue
       }
@@ -483,63 +750,199 @@ class VolumeAtlas {
       
       if asyncEmptinessUpdater.brickIsEmpty(brickMetadata: metaData[newBrickID],
                                             useTF: transferFunction) {
-        metaStorage[newBrickID] = BI_EMPTY
+        setMetaStorage(newBrickID, BI_EMPTY)
         continue
       }
 
-      if let prevPage = brickToPage[newBrickID] {
-        if self.pageMetadata[prevPage].reactivate(ifItContains: newBrickID) {
-          metaStorage[newBrickID] = UInt32(prevPage) + BI_FLAG_COUNT
-          elementsInBuffer += 1
-          continue
-        } else {
-          brickToPage[newBrickID] = nil
-        }
-      }
-
-      do {
-        try borgData.getBrick(index: newBrickID, outputBuffer: borgBuffer)
-      } catch BORGVRDataError.brickNotYetAvailable {
-        // the brick source is in async mode and the brick is not ready yet
-        continue
-      } catch {
+      // The brick may still be in its old page, e.g. after it was empty for a while.
+      // A retired page keeps its data until it is refilled.
+      if let prevPage = brickPages.page(of: newBrickID) {
+        setMetaStorage(newBrickID, UInt32(prevPage) + BI_FLAG_COUNT)
+        pageReplacement.touch(prevPage)
+        retiredPages.remove(prevPage)
         continue
       }
 
-      let insertionPos = sortedIndices[insertionIndex]
-      insertionIndex += 1
-
-      // pageMetadata.count-2 makes sure we never touch the one brick in the
-      // lowest resolution that we paged-in at the start
-      guard insertionIndex <= pageMetadata.count - 2 else {
-        incompleteIndex = insertionIndex
-        break
+      // A full request queue takes the brick again in the next call.
+      if !brickLoader.request(newBrickID),
+         deferredRequests.count < VolumeAtlas.maxDeferredRequests {
+        deferredRequests.append(request)
       }
+    }
+
+    var commitBudget = pagingBudget
+    commitBudget.maxDuration = max(0, pagingBudget.maxDuration - timer.sample())
 
-      if pageMetadata[insertionPos].containsVisibleBrick() {
-        metaStorage[pageMetadata[insertionPos].brickID] = BI_MISSING
+    var insertionIndex = 0
+    let completedFrame = frames?.completedFrame ?? Int.max
+    brickLoader.commitReady(budget: commitBudget) { newBrickID, data, range in
+      // The brick may have been flagged empty or been reactivated since it was requested.
+      guard metaStorage[newBrickID] == BI_MISSING else { return true }
+
+      var pageIndex: Int
+      repeat {
+        // Every page filled in this call moves to the back of the list, so stop
+        // before evicting one of them. Page 0 is pinned and never a victim.
+        guard insertionIndex < pageReplacement.count,
+              let victim = victimPage(for: newBrickID,
+                                      candidates: pageReplacement.count - insertionIndex,
+                                      completedFrame: completedFrame) else {
+          // Retired pages become free once their frames complete.
+          if retiredPages.isEmpty {
+            incompleteIndex = insertionIndex + 1
+          }
+          return false
+        }
+        pageIndex = victim
+
+        // The frames in flight may still sample the brick, so unmap it now and refill the
+        // page once they have completed. The loaded brick stays staged until then; the
+        // staging ring bounds the number of retired pages.
+        if let evictedBrickID = brickPages.brick(in: victim),
+           metaStorage[evictedBrickID] == UInt32(victim) + BI_FLAG_COUNT {
+          guard retiredPages.count < brickLoader.slotCount else { return false }
+          setMetaStorage(evictedBrickID, BI_MISSING)
+          pageFences[victim] = lastSubmittedFrame
+          retiredPages.insert(victim)
+        }
+      } while pageFences[pageIndex] > completedFrame
+      insertionIndex += 1
+      pageReplacement.touch(pageIndex)
+      retiredPages.remove(pageIndex)
+
+      if let evictedBrickID = brickPages.brick(in: pageIndex) {
+        // The evicted brick no longer points here. The updater still gets the atlas'
+        // value, so it drops a pending reactivation of the brick into this page.
+        setMetaStorage(evictedBrickID, metaStorage[evictedBrickID])
+        if isReserved(evictedBrickID) {
+          reservedPageCount -= 1
+        }
       } else {
         elementsInBuffer+=1
       }
-      let pageIndex = pageMetadata[insertionPos].pageID
-      pageMetadata[insertionPos].set(brickID: newBrickID, arrivalIndex: pageFrame)
-      brickToPage[newBrickID] = pageIndex
-      metaStorage[newBrickID] = UInt32(pageIndex) + BI_FLAG_COUNT
+      if isReserved(newBrickID) {
+        reservedPageCount += 1
+      }
+      brickPages.assign(brick: newBrickID, to: pageIndex)
+      setMetaStorage(newBrickID, UInt32(pageIndex) + BI_FLAG_COUNT)
 
       let (x, y, z) = IDToCoords(pageIndex: pageIndex)
-      replaceAtlasBrick(x: x, y: y, z: z, data: borgBuffer)
+      replaceAtlasBrick(x: x, y: y, z: z, data: data)
+      if isQuantized {
+        setPageRange(pageIndex, range)
+      }
+      return true
     }
 
-    asyncEmptinessUpdater.updateMetadata(metaStorage: metaStorage,
-                                         brickToPage: brickToPage,
-                                         pageMetadata: pageMetadata)
+    asyncEmptinessUpdater.updateMetadata(changes: pagedChanges)
+    pagedChanges.removeAll(keepingCapacity: true)
     updateMetaBuffer()
-    pageFrame += 1
 
     if incompleteIndex != 0 {
-      throw PageError.workingSetTooLarge(incompleteIndex, pageMetadata.count)
+      throw PageError.workingSetTooLarge(incompleteIndex, pageCount)
+    }
+
+  }
+
+  /**
+   Merges the requests with the ones deferred by the previous call and sorts them by
+   visual importance.
+
+   Bricks are stored from the finest to the coarsest level, so a higher brick index never
+   belongs to a finer level. The sort puts coarser levels first, then more hits, then
+   higher indices.
+
+   - Parameters:
+   - IDs: The requested brick IDs.
+   - hits: The hit count of each requested brick, or empty.
+   - Returns: The requests in the order they should be handled.
+   */
+  private func importanceOrder(IDs: [Int], hits: [UInt32]) -> [(brickID: Int, hits: UInt32)] {
+    var requests = IDs.enumerated().map { (index, brickID) in
+      (brickID: brickID, hits: index < hits.count ? hits[index] : 1)
     }
+    let requested = Set(IDs)
+    requests += deferredRequests.filter { !requested.contains($0.brickID) }
 
+    return requests
+      .map { (request: $0, level: level(of: $0.brickID)) }
+      .sorted {
+        if $0.level != $1.level { return $0.level > $1.level }
+        if $0.request.hits != $1.request.hits { return $0.request.hits > $1.request.hits }
+        return $0.request.brickID > $1.request.brickID
+      }
+      .map { $0.request }
+  }
+
+  /**
+   Returns the level of a brick.
+
+   - Parameter brickID: The brick index.
+   - Returns: The level, 0 being the finest.
+   */
+  private func level(of brickID: Int) -> Int {
+    var level = 0
+    while level + 1 < levelStarts.count && brickID >= levelStarts[level + 1] {
+      level += 1
+    }
+    return level
+  }
+
+  /**
+   Returns whether a brick belongs to the levels protected by the eviction policy.
+
+   - Parameter brickID: The brick index.
+   - Returns: True for bricks of the `reservedLevels` coarsest levels.
+   */
+  private func isReserved(_ brickID: Int) -> Bool {
+    level(of: brickID) >= levelCosts.count - evictionPolicy.reservedLevels
+  }
+
+  /**
+   Chooses the page to evict for a brick.
+
+   Walks the list from the least recently used page and picks the cheapest of the first
+   `window` candidates, the least recently used one on ties. A page is free to take if its
+   brick is no longer mapped to it, e.g. because the brick was flagged empty. Otherwise the
+   cost is the brick's level cost, so fine bricks go before the coarse ones they fall back
+   to. While the reserved levels hold no more than their quota of pages, those pages are
+   skipped unless the new brick belongs to a reserved level as well. Pages whose fence has
+   not completed are skipped, too; they are neither free nor compared.
+
+   - Parameters:
+   - brickID: The brick that needs a page.
+   - candidates: The number of pages from the front of the list that may be evicted.
+   - completedFrame: The frame up to which all frames have completed.
+   - Returns: The page, or `nil` if none of the candidates may be evicted.
+   */
+  private func victimPage(for brickID: Int, candidates: Int, completedFrame: Int) -> Int? {
+    let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+    let quota = min(evictionPolicy.reservedPages, pageReplacement.count / 2)
+    let protectReserved = reservedPageCount <= quota && !isReserved(brickID)
+
+    var victim: Int?
+    var victimCost = Float.infinity
+    var compared = 0
+    var page = pageReplacement.leastRecentlyUsed
+    for _ in 0..<candidates {
+      guard let current = page, compared < max(1, evictionPolicy.window) else { break }
+      page = pageReplacement.moreRecentlyUsed(than: current)
+      if pageFences[current] > completedFrame { continue }
+
+      guard let brick = brickPages.brick(in: current),
+            metaStorage[brick] == UInt32(current) + flagCount else {
+        return current
+      }
+      if protectReserved && isReserved(brick) { continue }
+
+      compared += 1
+      let cost = levelCosts[level(of: brick)]
+      if cost < victimCost {
+        victim = current
+        victimCost = cost
+      }
+    }
+    return victim
   }
 
   /**
@@ -0,0 +1,1130 @@
+import Foundation
+
+// MARK: - Page Replacement
+
+/// Times the atlas eviction order against the per-frame sort it replaced.
+let pageReplacementBenchmark = SelfCheck(
+  name: "page-replacement",
+  arguments: "[pages] [frames]",
+  summary: "Replays a camera orbit through a brick grid as pageIn does, once with " +
+           "PageReplacementList and once sorting the pages by arrival every frame",
+  run: runPageReplacementBenchmark
+)
+
+/**
+ Replays `frames` frames (default 2000) of a camera that orbits a 64³ brick grid and sees the
+ bricks within a radius of 12 bricks around its focus. As in `VolumeAtlas.pageIn`, only
+ bricks that are not resident are requested, at most 64 per frame, and each one takes the
+ least recently filled of `pages` pages (default 4096, page 0 pinned). The same trace runs
+ with `PageReplacementList` and with the previous scheme, which stored an arrival index per
+ page and sorted all pages by it on every call.
+
+ - Parameter arguments: Optionally the number of pages and frames.
+ - Returns: True if both variants agree on the page of every resident brick and the list
+ never evicts a page that was filled in the same frame.
+ - Throws: `SelfCheckError.invalidArguments` if an argument is not a positive integer.
+ */
+func runPageReplacementBenchmark(_ arguments: [String]) throws -> Bool {
+  guard arguments.count <= 2 else { throw SelfCheckError.invalidArguments("page-replacement") }
+  let pageCount = try positiveArgument(arguments, 0, default: 4096, check: "page-replacement")
+  let frames = try positiveArgument(arguments, 1, default: 2000, check: "page-replacement")
+  guard pageCount >= 2 else { throw SelfCheckError.invalidArguments("page-replacement") }
+  let gridSize = 64
+  let radius = 12
+  let maxBricksPerFrame = 64
+
+  // The bricks around the focus of each frame, nearest first.
+  let offsets = (-radius...radius).flatMap { z in
+    (-radius...radius).flatMap { y in (-radius...radius).map { x in SIMD3<Int>(x, y, z) } }
+  }.filter { $0.x * $0.x + $0.y * $0.y + $0.z * $0.z <= radius * radius }
+    .sorted { ($0 &* $0).wrappedSum() < ($1 &* $1).wrappedSum() }
+  func visibleBricks(frame: Int) -> [Int] {
+    let angle = Double(frame) / 400 * 2 * Double.pi
+    let orbit = Double(gridSize / 2 - radius - 1)
+    let focus = SIMD3<Int>(gridSize / 2 + Int(orbit * cos(angle)),
+                           gridSize / 2 + Int(orbit * sin(angle)),
+                           gridSize / 2 + Int(Double(radius) * sin(3 * angle)))
+    return offsets.map { $0 &+ focus }.map { ($0.z * gridSize + $0.y) * gridSize + $0.x }
+  }
+  let trace = (0..<frames).map(visibleBricks)
+
+  // PageReplacementList
+  var list = PageReplacementList(pageCount: pageCount, pinnedPages: 1)
+  var listPages = [Int](repeating: -1, count: gridSize * gridSize * gridSize)
+  var listBricks = [Int](repeating: -1, count: pageCount)
+  var filledInFrame = [Int](repeating: -1, count: pageCount)
+  var misses = 0
+  var valid = true
+  let timer = HighResolutionTimer()
+  timer.start()
+  for (frame, visible) in trace.enumerated() {
+    var filled = 0
+    for brick in visible where listPages[brick] < 0 {
+      misses += 1
+      guard filled < maxBricksPerFrame, filled < list.count,
+            let page = list.leastRecentlyUsed else { continue }
+      if filledInFrame[page] == frame { valid = false }
+      filledInFrame[page] = frame
+      filled += 1
+      list.touch(page)
+      if listBricks[page] >= 0 { listPages[listBricks[page]] = -1 }
+      listBricks[page] = brick
+      listPages[brick] = page
+    }
+  }
+  let listSeconds = timer.stop()
+
+  // The previous per-page arrival indices, sorted on every call.
+  var arrival = [Int](repeating: 0, count: pageCount)
+  arrival[0] = Int.max - 1
+  var nextArrival = 1
+  var sortedPages = [Int](repeating: -1, count: gridSize * gridSize * gridSize)
+  var sortedBricks = [Int](repeating: -1, count: pageCount)
+  timer.start()
+  for visible in trace {
+    let order = (0..<pageCount).sorted {
+      (arrival[$0], $0) < (arrival[$1], $1)
+    }
+    var filled = 0
+    for brick in visible where sortedPages[brick] < 0 {
+      guard filled < maxBricksPerFrame, filled < pageCount - 1 else { continue }
+      let page = order[filled]
+      filled += 1
+      arrival[page] = nextArrival
+      nextArrival += 1
+      if sortedBricks[page] >= 0 { sortedPages[sortedBricks[page]] = -1 }
+      sortedBricks[page] = brick
+      sortedPages[brick] = page
+    }
+  }
+  let sortSeconds = timer.stop()
+
+  let requests = trace.reduce(0) { $0 + $1.count }
+  logger.info("\(frames) frames, \(requests) visible bricks, \(misses) misses " +
+              "(\(String(format: "%.1f", 100 * Double(misses) / Double(requests)))%)")
+  logger.info("PageReplacementList: \(String(format: "%.2f", listSeconds / Double(frames) * 1e6)) µs per frame")
+  logger.info("Sorted arrival order: \(String(format: "%.2f", sortSeconds / Double(frames) * 1e6)) µs per frame")
+
+  if !valid {
+    logger.error("The list evicted a page that was filled in the same frame")
+  }
+  if listPages != sortedPages {
+    logger.error("The two variants hold different bricks in different pages")
+    valid = false
+  }
+  return valid
+}
+
+// MARK: - Eviction Replay
+
+/// Replays a pose trace against the eviction policies of the atlas.
+let evictionReplayBenchmark = SelfCheck(
+  name: "eviction-replay",
+  arguments: "[<input_filename> <trace_filename>] [pages] [bricks_per_frame]",
+  summary: "Replays a pose trace, or a synthetic flight through a 1024³ volume, through the " +
+           "atlas eviction with plain LRU and the level-weighted policies, and reports the " +
+           "miss rate and the fallback depth distribution",
+  run: runEvictionReplayBenchmark
+)
+
+/**
+ Replays the views of a pose trace recorded by the VisionApp, as used by mode P, or without
+ file arguments a synthetic flight that orbits and dollies through a 1024³ volume. The bricks
+ each view needs are those `PrefetchPlanner` visits for it without extrapolation, i.e. the
+ bricks the raycaster walks from the coarsest level down to its level of detail.
+
+ Every frame is replayed against an atlas of `pages` pages (default 2048, page 0 pinned with
+ the coarsest brick) for each eviction policy: plain LRU, the level-weighted window of
+ `VolumeAtlas.victimPage` and the weighted window with pages reserved for the two coarsest
+ levels. A needed brick that is not resident falls back to its nearest resident ancestor;
+ the number of levels in between is its fallback depth. Then, as in `VolumeAtlas.pageIn`,
+ up to `bricks_per_frame` (default 64) missing bricks are paged in, coarse levels first.
+
+ - Parameter arguments: Optionally the dataset and trace, then the number of pages and the
+ number of bricks paged in per frame.
+ - Returns: True if every needed brick could fall back to a resident ancestor.
+ - Throws: `SelfCheckError.invalidArguments` for malformed arguments, or the error of
+ reading the dataset or trace.
+ */
+func runEvictionReplayBenchmark(_ arguments: [String]) throws -> Bool {
+  let hasFiles = arguments.count >= 2 && Int(arguments[0]) == nil
+  let numbers = Array(arguments.dropFirst(hasFiles ? 2 : 0))
+  guard numbers.count <= 2 else { throw SelfCheckError.invalidArguments("eviction-replay") }
+  let pageCount = try positiveArgument(numbers, 0, default: 2048, check: "eviction-replay")
+  let bricksPerFrame = try positiveArgument(numbers, 1, default: 64, check: "eviction-replay")
+  guard pageCount >= 2 else { throw SelfCheckError.invalidArguments("eviction-replay") }
+
+  // The views to replay.
+  let metadata: BORGVRMetaData
+  let parameters: PrefetchPlanner.LODParameters
+  var poses: [PrefetchPlanner.Pose] = []
+  if hasFiles {
+    metadata = try BORGVRMetaData(filename: arguments[0])
+    let entries = try PrefetchPlanner.readTrace(from: URL(fileURLWithPath: arguments[1]))
+    guard let traceParameters = entries.first?.parameters else {
+      logger.error("eviction-replay: the trace does not start with the LOD parameters")
+      return false
+    }
+    parameters = traceParameters
+    poses = entries.compactMap { $0.pose }
+  } else {
+    metadata = syntheticMetadata(size: 1024, brickSize: 32, bytesPerComponent: 1)
+    parameters = PrefetchPlanner.LODParameters(lodFactor: 0.01,
+                                               levelZeroWorldSpaceError: 1.0 / 1024)
+    let center = SIMD3<Float>(repeating: 0.5)
+    for frame in 0..<1200 {
+      let time = Double(frame) / 60
+      let angle = Float(time) / 10 * 2 * Float.pi
+      let radius = 0.45 + 0.35 * sin(3 * angle)
+      let position = center + radius * SIMD3<Float>(cos(angle), sin(angle), 0.3 * sin(2 * angle))
+      let toCenter = center - position
+      poses.append(PrefetchPlanner.Pose(
+        time: time, position: position, lodPosition: position,
+        forward: toCenter / max(1e-6, (toCenter * toCenter).sum().squareRoot()),
+        clipMin: SIMD3<Float>(repeating: 0), clipMax: SIMD3<Float>(repeating: 1)))
+    }
+  }
+  guard !poses.isEmpty else {
+    logger.error("eviction-replay: the trace contains no poses")
+    return false
+  }
+
+  let planner = PrefetchPlanner(metadata: metadata, parameters: parameters, horizon: 0,
+                                horizonSteps: 0, maxPlanSize: Int.max)
+  let views: [[Int]] = poses.map { pose in
+    planner.record(pose)
+    return planner.plan(at: pose.time)
+  }
+
+  // The level and parent of each brick, and the eviction cost of each level as in
+  // VolumeAtlas.
+  let levels = metadata.levelMetadata
+  let levelBrickCounts = levels.map { $0.totalBricks.x * $0.totalBricks.y * $0.totalBricks.z }
+  let brickCount = levelBrickCounts.reduce(0, +)
+  let innerSize = Float(metadata.brickSize - 2 * metadata.overlap)
+  func layout(_ level: Int) -> SIMD3<Float> {
+    SIMD3<Float>(Float(levels[level].size.x), Float(levels[level].size.y),
+                 Float(levels[level].size.z)) / innerSize
+  }
+  var brickLevels = [Int](repeating: 0, count: brickCount)
+  var parents = [Int](repeating: -1, count: brickCount)
+  for (level, info) in levels.enumerated() {
+    let bricksX = info.totalBricks.x
+    let bricksXY = info.totalBricks.x * info.totalBricks.y
+    for local in 0..<(bricksXY * info.totalBricks.z) {
+      let brick = info.prevBricks + local
+      brickLevels[brick] = level
+      guard level + 1 < levels.count else { continue }
+      let coords = SIMD3<Float>(Float(local % bricksX),
+                                Float((local / bricksX) % info.totalBricks.y),
+                                Float(local / bricksXY))
+      let parentInfo = levels[level + 1]
+      let parent = SIMD3<Int>((coords + 0.5) / layout(level) * layout(level + 1),
+                              rounding: .down)
+      let clamped = pointwiseMin(parent, SIMD3<Int>(parentInfo.totalBricks.x - 1,
+                                                    parentInfo.totalBricks.y - 1,
+                                                    parentInfo.totalBricks.z - 1))
+      parents[brick] = parentInfo.prevBricks + clamped.x + clamped.y * parentInfo.totalBricks.x +
+                       clamped.z * parentInfo.totalBricks.x * parentInfo.totalBricks.y
+    }
+  }
+  let levelCosts = levelBrickCounts.indices.map { level in
+    1 + levelBrickCounts[..<level].reduce(Float(0)) {
+      $0 + Float($1) / Float(levelBrickCounts[level])
+    }
+  }
+
+  let maxDepth = 4
+  var passed = true
+  func replay(_ name: String, window: Int, reservedLevels: Int, reservedPages: Int) {
+    var list = PageReplacementList(pageCount: pageCount, pinnedPages: 1)
+    var pageBricks = [Int](repeating: -1, count: pageCount)
+    var brickPages = [Int](repeating: -1, count: brickCount)
+    pageBricks[0] = brickCount - 1
+    brickPages[brickCount - 1] = 0
+    var reservedPageCount = 0
+    func isReserved(_ brick: Int) -> Bool {
+      brickLevels[brick] >= levels.count - reservedLevels
+    }
+
+    /// `VolumeAtlas.victimPage` on the simulated atlas.
+    func victimPage(for brick: Int, candidates: Int) -> Int? {
+      let quota = min(reservedPages, list.count / 2)
+      let protectReserved = reservedPageCount <= quota && !isReserved(brick)
+      var victim: Int?
+      var victimCost = Float.infinity
+      var compared = 0
+      var page = list.leastRecentlyUsed
+      for _ in 0..<candidates {
+        guard let current = page, compared < max(1, window) else { break }
+        page = list.moreRecentlyUsed(than: current)
+        let resident = pageBricks[current]
+        guard resident >= 0 else { return current }
+        if protectReserved && isReserved(resident) { continue }
+        compared += 1
+        let cost = levelCosts[brickLevels[resident]]
+        if cost < victimCost {
+          victim = current
+          victimCost = cost
+        }
+      }
+      return victim
+    }
+
+    var depths = [Int](repeating: 0, count: maxDepth + 1)
+    var needed = 0
+    var unresolved = 0
+    var depthSum = 0
+    for view in views {
+      var missing: [Int] = []
+      for brick in view {
+        var depth = 0
+        var current = brick
+        while current >= 0 && brickPages[current] < 0 {
+          current = parents[current]
+          depth += 1
+        }
+        if current < 0 { unresolved += 1 }
+        if depth > 0 { missing.append(brick) }
+        depths[min(depth, maxDepth)] += 1
+        depthSum += depth
+        needed += 1
+      }
+
+      missing.sort {
+        brickLevels[$0] != brickLevels[$1] ? brickLevels[$0] > brickLevels[$1] : $0 > $1
+      }
+      var filled = 0
+      for brick in missing.prefix(bricksPerFrame) {
+        guard filled < list.count,
+              let page = victimPage(for: brick, candidates: list.count - filled) else { break }
+        filled += 1
+        list.touch(page)
+        if pageBricks[page] >= 0 {
+          brickPages[pageBricks[page]] = -1
+          if isReserved(pageBricks[page]) { reservedPageCount -= 1 }
+        }
+        if isReserved(brick) { reservedPageCount += 1 }
+        pageBricks[page] = brick
+        brickPages[brick] = page
+      }
+    }
+
+    let share = { (count: Int) in
+      String(format: "%.1f%%", 100 * Double(count) / Double(max(1, needed)))
+    }
+    let histogram = depths.indices.map { depth in
+      "\(depth)\(depth == maxDepth ? "+" : ""): \(share(depths[depth]))"
+    }.joined(separator: ", ")
+    logger.info("\(name): miss rate \(share(needed - depths[0])), mean fallback depth " +
+                "\(String(format: "%.3f", Double(depthSum) / Double(max(1, needed)))), " +
+                "depths \(histogram)")
+    if unresolved > 0 {
+      logger.error("eviction-replay: \(unresolved) bricks had no resident ancestor with \(name)")
+      passed = false
+    }
+  }
+
+  let totalNeeded = views.reduce(0) { $0 + $1.count }
+  logger.info("\(views.count) views, \(totalNeeded) needed bricks " +
+              "(\(totalNeeded / views.count) per view), " +
+              "\(pageCount) pages, \(bricksPerFrame) bricks per frame")
+  replay("LRU", window: 1, reservedLevels: 0, reservedPages: 0)
+  replay("Weighted window 8", window: 8, reservedLevels: 0, reservedPages: 0)
+  replay("Weighted window 8, 256 pages for 2 levels", window: 8, reservedLevels: 2,
+         reservedPages: 256)
+  return passed
+}
+
+// MARK: - Brick Loader
+
+/// Drives the brick loader with a mock dataset.
+let brickLoaderCheck = SelfCheck(
+  name: "brick-loader",
+  arguments: "",
+  summary: "Checks request deduplication, staging slot reuse, commit budgets, failed loads, " +
+           "a full request queue and waiting for loads of BrickLoader against a mock dataset",
+  run: runBrickLoaderCheck
+)
+
+/**
+ Creates the metadata of a dataset that exists only in memory, with one uncompressed brick
+ record per brick of the hierarchy.
+
+ - Parameters:
+ - size: The edge length of the cubic volume.
+ - brickSize: The brick size, without overlap.
+ - bytesPerComponent: The number of bytes per voxel.
+ - Returns: The metadata.
+ */
+func syntheticMetadata(size: Int, brickSize: Int, bytesPerComponent: Int) -> BORGVRMetaData {
+  let metadata = BORGVRMetaData(width: size, height: size, depth: size, componentCount: 1,
+                                bytePerComponent: bytesPerComponent,
+                                aspectX: 1, aspectY: 1, aspectZ: 1,
+                                brickSize: brickSize, overlap: 0,
+                                minValue: 0, maxValue: (1 << (8 * bytesPerComponent)) - 1,
+                                compression: false,
+                                datasetDescription: "synthetic", metaDescription: "")
+  let brickBytes = brickSize * brickSize * brickSize * bytesPerComponent
+  let brickCount = metadata.levelMetadata.reduce(0) {
+    $0 + $1.totalBricks.x * $1.totalBricks.y * $1.totalBricks.z
+  }
+  for index in 0..<brickCount {
+    metadata.append(offset: index * brickBytes, size: brickBytes,
+                    minValue: 0, maxValue: metadata.maxValue)
+  }
+  return metadata
+}
+
+/**
+ A dataset whose bricks are filled with the low byte of their index. Loads of the bricks in
+ `failing` throw, and while `gate` is set, every load waits for it.
+ */
+private final class MockBrickDataset: BORGVRDatasetProtocol {
+  let metadata: BORGVRMetaData
+  private let lock = NSLock()
+  private var _failing = Set<Int>()
+  private var _loads = 0
+  private var _gate: DispatchSemaphore?
+
+  init(metadata: BORGVRMetaData) {
+    self.metadata = metadata
+  }
+
+  /// The bricks whose loads fail.
+  var failing: Set<Int> {
+    get { lock.withLock { _failing } }
+    set { lock.withLock { _failing = newValue } }
+  }
+  /// The number of `getBrick` calls so far.
+  var loads: Int { lock.withLock { _loads } }
+  /// A semaphore every load waits for, or `nil`.
+  var gate: DispatchSemaphore? {
+    get { lock.withLock { _gate } }
+    set { lock.withLock { _gate = newValue } }
+  }
+
+  var supportsConcurrentGetBrick: Bool { true }
+
+  func newRequest() {}
+
+  func getMetadata() -> BORGVRMetaData { metadata }
+
+  func getBrick(index: Int, outputBuffer: UnsafeMutablePointer<UInt8>) throws {
+    let (fails, gate) = lock.withLock {
+      _loads += 1
+      return (_failing.contains(index), _gate)
+    }
+    if let gate {
+      gate.wait()
+      gate.signal()
+    }
+    if fails {
+      throw BORGVRDataError.brickNotYetAvailable(index: index)
+    }
+    outputBuffer.update(repeating: UInt8(truncatingIfNeeded: index),
+                        count: metadata.getBrickMetadata(index: index).size)
+  }
+
+  func getFirstBrick(outputBuffer: UnsafeMutablePointer<UInt8>) throws {
+    try getBrick(index: metadata.brickMetadata.count - 1, outputBuffer: outputBuffer)
+  }
+
+  func allocateBrickBuffer() -> UnsafeMutablePointer<UInt8> {
+    UnsafeMutablePointer<UInt8>.allocate(capacity: metadata.brickSize * metadata.brickSize *
+                                         metadata.brickSize * metadata.bytesPerComponent)
+  }
+}
+
+/**
+ Runs the brick loader scenarios against `MockBrickDataset`:
+
+ - Deduplication: requesting a pending brick again neither queues nor loads it twice.
+ - Slot reuse: 200 bricks pass through four staging slots with the right contents.
+ - Budgets: the brick and byte limits and a closure that returns false stop committing, but
+   at least one brick is always committed. The brick the closure declined stays staged.
+ - Failed loads: a brick whose load throws is never committed, is no longer pending, and can
+   be requested again.
+ - Full queue: `request` returns false once the request queue is full, and the rejected
+   brick is not pending.
+ - Waiting: `waitForReady` times out while a load is held back or only a declined brick is
+   staged, and returns once a load finishes without taking the brick.
+
+ - Parameter arguments: None.
+ - Returns: True if all scenarios behave as expected.
+ - Throws: `SelfCheckError.invalidArguments` if arguments are given.
+ */
+func runBrickLoaderCheck(_ arguments: [String]) throws -> Bool {
+  guard arguments.isEmpty else { throw SelfCheckError.invalidArguments("brick-loader") }
+  let metadata = syntheticMetadata(size: 128, brickSize: 8, bytesPerComponent: 1)
+  let unlimited = BrickLoader.Budget(maxBricks: Int.max, maxBytes: Int.max, maxDuration: 1)
+  var passed = true
+  func expect(_ condition: Bool, _ message: String) {
+    if !condition {
+      logger.error("brick-loader: \(message)")
+      passed = false
+    }
+  }
+
+  /// Commits until `count` bricks arrived or two seconds passed, checking their contents.
+  func drain(_ loader: BrickLoader, count: Int) -> [Int] {
+    var committed: [Int] = []
+    let deadline = Date().addingTimeInterval(2)
+    while committed.count < count && Date() < deadline {
+      loader.commitReady(budget: unlimited) { brickID, data, _ in
+        let expected = UInt8(truncatingIfNeeded: brickID)
+        expect(data[0] == expected && data[loader.committedByteCount - 1] == expected,
+               "brick \(brickID) was committed with the data of another brick")
+        committed.append(brickID)
+        return true
+      }
+      if committed.count < count {
+        _ = loader.waitForReady(timeout: deadline.timeIntervalSinceNow)
+      }
+    }
+    return committed
+  }
+
+  // Deduplication
+  do {
+    let dataset = MockBrickDataset(metadata: metadata)
+    let gate = DispatchSemaphore(value: 0)
+    dataset.gate = gate
+    let loader = BrickLoader(borgData: dataset, workerCount: 2, slotCount: 4)
+    defer { loader.stop() }
+    for _ in 0..<3 {
+      expect(loader.request(5) && loader.request(6), "requests were rejected")
+    }
+    expect(loader.pendingCount == 2, "\(loader.pendingCount) bricks pending, expected 2")
+    gate.signal()
+    let committed = drain(loader, count: 2)
+    expect(committed.sorted() == [5, 6], "committed \(committed), expected [5, 6]")
+    expect(dataset.loads == 2, "\(dataset.loads) loads for two distinct bricks")
+    expect(loader.pendingCount == 0, "bricks still pending after commit")
+  }
+
+  // Slot reuse
+  do {
+    let dataset = MockBrickDataset(metadata: metadata)
+    let loader = BrickLoader(borgData: dataset, workerCount: 3, slotCount: 4, queueCapacity: 256)
+    defer { loader.stop() }
+    for brickID in 0..<200 {
+      expect(loader.request(brickID), "request \(brickID) was rejected")
+    }
+    let committed = drain(loader, count: 200)
+    expect(committed.sorted() == Array(0..<200),
+           "\(committed.count) of 200 bricks committed through four slots")
+  }
+
+  // Budgets
+  do {
+    let dataset = MockBrickDataset(metadata: metadata)
+    let loader = BrickLoader(borgData: dataset, workerCount: 2, slotCount: 8)
+    defer { loader.stop() }
+    for brickID in 0..<8 {
+      loader.request(brickID)
+    }
+    // Wait until all eight slots are ready; the workers stop when no slot is free.
+    let deadline = Date().addingTimeInterval(2)
+    while dataset.loads < 8 && Date() < deadline {
+      Thread.sleep(forTimeInterval: 0.001)
+    }
+    Thread.sleep(forTimeInterval: 0.01)
+
+    var budget = unlimited
+    budget.maxBricks = 3
+    expect(loader.commitReady(budget: budget) { _, _, _ in true } == 3,
+           "the brick budget did not stop after three bricks")
+    budget = unlimited
+    budget.maxBytes = 1
+    expect(loader.commitReady(budget: budget) { _, _, _ in true } == 1,
+           "a byte budget below one brick did not commit exactly one brick")
+    expect(loader.commitReady(budget: unlimited) { _, _, _ in false } == 1,
+           "committing went on after the closure returned false")
+    expect(loader.pendingCount == 4, "\(loader.pendingCount) bricks pending, expected 4")
+    expect(drain(loader, count: 4).count == 4, "the remaining bricks or the kept one were lost")
+  }
+
+  // Failed loads
+  do {
+    let dataset = MockBrickDataset(metadata: metadata)
+    dataset.failing = [7]
+    let loader = BrickLoader(borgData: dataset, workerCount: 2, slotCount: 4)
+    defer { loader.stop() }
+    loader.request(7)
+    loader.request(8)
+    let committed = drain(loader, count: 1)
+    expect(committed == [8], "committed \(committed) while brick 7 failed to load")
+    let deadline = Date().addingTimeInterval(2)
+    while loader.pendingCount > 0 && Date() < deadline {
+      loader.commitReady(budget: unlimited) { _, _, _ in true }
+      Thread.sleep(forTimeInterval: 0.001)
+    }
+    expect(loader.pendingCount == 0, "the failed brick is still pending")
+    dataset.failing = []
+    loader.request(7)
+    expect(drain(loader, count: 1) == [7], "the failed brick could not be requested again")
+  }
+
+  // Full queue
+  do {
+    let dataset = MockBrickDataset(metadata: metadata)
+    let gate = DispatchSemaphore(value: 0)
+    dataset.gate = gate
+    let loader = BrickLoader(borgData: dataset, workerCount: 1, slotCount: 1, queueCapacity: 4)
+    defer { loader.stop() }
+    var accepted: [Int] = []
+    var rejected: Int?
+    for brickID in 0..<64 {
+      if loader.request(brickID) {
+        accepted.append(brickID)
+      } else {
+        rejected = brickID
+        break
+      }
+    }
+    expect(rejected != nil, "64 requests fit into a queue of capacity 4")
+    expect(loader.pendingCount == accepted.count, "a rejected brick is pending")
+    gate.signal()
+    expect(drain(loader, count: accepted.count).count == accepted.count,
+           "the accepted bricks were not loaded")
+    if let rejected {
+      expect(loader.request(rejected) && drain(loader, count: 1) == [rejected],
+             "the rejected brick could not be requested again")
+    }
+  }
+
+  // Waiting
+  do {
+    let dataset = MockBrickDataset(metadata: metadata)
+    let gate = DispatchSemaphore(value: 0)
+    dataset.gate = gate
+    let loader = BrickLoader(borgData: dataset, workerCount: 1, slotCount: 2)
+    defer { loader.stop() }
+    expect(!loader.waitForReady(timeout: 0.01), "waiting returned with nothing loading")
+    loader.request(3)
+    expect(!loader.waitForReady(timeout: 0.01), "waiting returned before the load finished")
+    gate.signal()
+    expect(loader.waitForReady(timeout: 2), "waiting timed out after the load finished")
+    expect(loader.waitForReady(timeout: 0), "waiting took the finished brick")
+    expect(loader.commitReady(budget: unlimited) { _, _, _ in false } == 1,
+           "the finished brick was not handed to the closure")
+    expect(!loader.waitForReady(timeout: 0.01), "waiting returned for a declined brick")
+    loader.request(4)
+    expect(loader.waitForReady(timeout: 2), "waiting timed out behind a declined brick")
+    expect(drain(loader, count: 2).sorted() == [3, 4], "the waited for bricks were lost")
+    expect(!loader.waitForReady(timeout: 0.01), "waiting returned after everything was taken")
+  }
+
+  return passed
+}
+
+// MARK: - Frame Ring
+
+/// Simulates the frames in flight and the page fences of the atlas on the CPU.
+let frameRingCheck = SelfCheck(
+  name: "frame-ring",
+  arguments: "[frames] [slots]",
+  summary: "Drives FrameRing with a simulated GPU and checks the buffer rotation and that " +
+           "no atlas page is refilled while a frame in flight samples it",
+  run: runFrameRingCheck
+)
+
+/**
+ Runs `frames` frames (default 20000) with up to `slots` frames in flight (default 2)
+ through `FrameRing`, as `GPUHashtable` and the renderer do. A simulated GPU completes the
+ oldest frames in flight after a random number of frames, and the render thread waits for
+ one to complete when all slots are in use.
+
+ Each frame samples the bricks mapped to the pages of a small atlas when it is submitted.
+ After the submission, random bricks are paged in as `VolumeAtlas.pageIn` does: pages are
+ taken in least recently used order, pages whose fence has not completed are skipped, and a
+ page whose brick is mapped is retired first, with the last submitted frame as its fence.
+ The same trace then runs without fences, which has to overwrite pages that frames in
+ flight sample, so the check is known to catch that.
+
+ `FrameRing.complete` is also fed out of order, from a single thread and from many.
+
+ - Parameter arguments: Optionally the number of frames and slots.
+ - Returns: True if no slot is reused while its frame is in flight, `completedFrame` always
+ is the highest frame up to which all frames completed, and no page is refilled while a
+ frame in flight samples its previous brick, except in the run without fences.
+ - Throws: `SelfCheckError.invalidArguments` if an argument is not a positive integer.
+ */
+func runFrameRingCheck(_ arguments: [String]) throws -> Bool {
+  guard arguments.count <= 2 else { throw SelfCheckError.invalidArguments("frame-ring") }
+  let frameCount = try positiveArgument(arguments, 0, default: 20000, check: "frame-ring")
+  let slots = try positiveArgument(arguments, 1, default: 2, check: "frame-ring")
+  var passed = true
+  func expect(_ condition: Bool, _ message: String) {
+    if !condition {
+      logger.error("frame-ring: \(message)")
+      passed = false
+    }
+  }
+
+  /// Runs the simulation and returns the number of pages that were refilled while a frame
+  /// in flight sampled their previous brick.
+  func simulate(fenced: Bool) -> Int {
+    let pageCount = 64
+    let brickCount = 256
+    let bricksPerFrame = 4
+    let maxRetiredPages = 8
+    let ring = FrameRing(slotCount: slots)
+    var pageReplacement = PageReplacementList(pageCount: pageCount, pinnedPages: 1)
+    // The brick whose data each page holds, and the page each brick is mapped to.
+    var pageBricks = [Int](repeating: -1, count: pageCount)
+    var brickPages = [Int](repeating: -1, count: brickCount)
+    var pageFences = [Int](repeating: 0, count: pageCount)
+    var retiredPages = Set<Int>()
+    // The frames in flight, oldest first, with the brick of each page they sample.
+    var inFlight: [(frame: Int, samples: [Int: Int])] = []
+    var slotFrames = [Int](repeating: 0, count: slots)
+    var completedFrame = 0
+    var slotErrors = 0
+    var completionErrors = 0
+    var hazards = 0
+
+    for _ in 0..<frameCount {
+      // The GPU finishes the oldest frames; the render thread waits while all slots are used.
+      while let oldest = inFlight.first,
+            inFlight.count >= slots || Int.random(in: 0..<3) == 0 {
+        inFlight.removeFirst()
+        ring.complete(oldest.frame)
+        completedFrame = oldest.frame
+        if ring.completedFrame != completedFrame { completionErrors += 1 }
+      }
+      let slotFree = slotFrames[ring.currentSlot] <= completedFrame
+      if !slotFree || !ring.currentSlotIsFree { slotErrors += 1 }
+
+      let mapped = (0..<brickCount).filter { brickPages[$0] >= 0 }
+      let samples = Dictionary(uniqueKeysWithValues: mapped.map { (brickPages[$0], $0) })
+      let (frame, slot) = ring.submit()
+      if slot != (frame - 1) % slots { slotErrors += 1 }
+      slotFrames[slot] = frame
+      inFlight.append((frame, samples))
+
+      let fence = fenced ? ring.completedFrame : Int.max
+      for _ in 0..<bricksPerFrame {
+        let brick = Int.random(in: 0..<brickCount)
+        guard brickPages[brick] < 0 else { continue }
+        // A retired page keeps its data until it is refilled.
+        if let page = pageBricks.firstIndex(of: brick) {
+          brickPages[brick] = page
+          pageReplacement.touch(page)
+          retiredPages.remove(page)
+          continue
+        }
+
+        var victim: Int?
+        var page = pageReplacement.leastRecentlyUsed
+        while let current = page, victim == nil {
+          page = pageReplacement.moreRecentlyUsed(than: current)
+          if pageFences[current] > fence { continue }
+          let previous = pageBricks[current]
+          if previous >= 0 && brickPages[previous] == current {
+            guard retiredPages.count < maxRetiredPages else { break }
+            brickPages[previous] = -1
+            pageFences[current] = ring.submittedFrame
+            retiredPages.insert(current)
+            if pageFences[current] > fence { continue }
+          }
+          victim = current
+        }
+        guard let victim else { break }
+
+        if inFlight.contains(where: { ($0.samples[victim] ?? brick) != brick }) {
+          hazards += 1
+        }
+        pageBricks[victim] = brick
+        brickPages[brick] = victim
+        pageReplacement.touch(victim)
+        retiredPages.remove(victim)
+      }
+    }
+
+    for remaining in inFlight.reversed() {
+      ring.complete(remaining.frame)
+    }
+    expect(slotErrors == 0, "\(slotErrors) frames used a slot whose last frame was in flight")
+    expect(completionErrors == 0, "completedFrame was wrong \(completionErrors) times")
+    expect(ring.completedFrame == frameCount && ring.framesInFlight == 0,
+           "\(ring.framesInFlight) frames still in flight at the end")
+    return hazards
+  }
+
+  let fencedHazards = simulate(fenced: true)
+  let unfencedHazards = simulate(fenced: false)
+  logger.info("\(frameCount) frames, \(slots) slots: \(fencedHazards) pages refilled under a " +
+              "frame in flight with fences, \(unfencedHazards) without")
+  expect(fencedHazards == 0, "pages were refilled while a frame in flight sampled them")
+  expect(unfencedHazards > 0, "the run without fences never overwrote a sampled page")
+
+  // Completion handlers may report frames out of order.
+  do {
+    let ring = FrameRing(slotCount: 4)
+    for _ in 0..<4 {
+      _ = ring.submit()
+    }
+    ring.complete(3)
+    ring.complete(1)
+    ring.complete(4)
+    expect(ring.completedFrame == 1, "completedFrame skipped the pending frame 2")
+    ring.complete(2)
+    expect(ring.completedFrame == 4, "completedFrame is \(ring.completedFrame), expected 4")
+  }
+  do {
+    let ring = FrameRing(slotCount: 1)
+    let count = 10000
+    for _ in 0..<count {
+      _ = ring.submit()
+    }
+    DispatchQueue.concurrentPerform(iterations: count) { index in
+      ring.complete(count - index)
+    }
+    expect(ring.completedFrame == count,
+           "completedFrame is \(ring.completedFrame) after concurrent completions")
+  }
+
+  return passed
+}
+
+// MARK: - Sparse Brick Directory
+
+/// Compares the sparse brick metadata directory against a dense table.
+let sparseDirectoryCheck = SelfCheck(
+  name: "sparse-directory",
+  arguments: "[frames]",
+  summary: "Applies random metadata updates to SparseBrickDirectory and a dense table and " +
+           "compares every lookup, and checks that freed leaves wait for their frames",
+  run: runSparseDirectoryCheck
+)
+
+/**
+ Runs `frames` frames (default 400) of random metadata updates on 48 leaves of bricks, once
+ as the atlas does, with released leaves retired until their frame completes, and once
+ reusing them right away. Each frame changes a few leaves: single bricks are mapped to
+ pages or flagged, or a whole leaf becomes uniform, which releases its pool entry. The
+ dirty leaves are written with `update(leaf:entries:buffer:frame:)` into a buffer that grows
+ like the metadata buffer, starting from four leaves. As in the renderer, the updates follow
+ the submission of a frame, with up to two frames in flight; each keeps the directory
+ entries it was submitted with.
+
+ - Parameter arguments: Optionally the number of frames.
+ - Returns: True if `lookup(_:in:)` matches the dense table for every brick after every
+ frame, the used leaves match the non-uniform ones, and no leaf is rewritten for another
+ one while a frame in flight still points to it, except when leaves are reused right away.
+ - Throws: `SelfCheckError.invalidArguments` if the argument is not a positive integer.
+ */
+func runSparseDirectoryCheck(_ arguments: [String]) throws -> Bool {
+  guard arguments.count <= 1 else { throw SelfCheckError.invalidArguments("sparse-directory") }
+  let frameCount = try positiveArgument(arguments, 0, default: 400, check: "sparse-directory")
+  var passed = true
+  func expect(_ condition: Bool, _ message: String) {
+    if !condition {
+      logger.error("sparse-directory: \(message)")
+      passed = false
+    }
+  }
+
+  let leafSize = SparseBrickDirectory.leafSize
+  // The last leaf is partial, as in most datasets.
+  let brickCount = 47 * leafSize + leafSize / 3
+  let flagCount = UInt32(BrickIDFlags.BI_FLAG_COUNT.rawValue)
+  let maxInFlight = 2
+
+  /// Runs the updates and returns the number of leaves rewritten while a frame in flight
+  /// pointed to them for another leaf.
+  func simulate(quarantine: Bool) -> Int {
+    var directory = SparseBrickDirectory(brickCount: brickCount, leafCapacity: 4)
+    var buffer = [UInt32](repeating: 0, count: directory.elementCount)
+    for (leaf, entry) in directory.initialDirectory.enumerated() {
+      buffer[leaf] = entry
+    }
+    var dense = [UInt32](repeating: UInt32(BrickIDFlags.BI_MISSING.rawValue), count: brickCount)
+    var inFlight: [(frame: Int, entries: [UInt32])] = []
+    var submittedFrame = 0
+    var completedFrame = 0
+    var hazards = 0
+    var mismatches = 0
+
+    for _ in 0..<frameCount {
+      // As in the renderer, a frame is submitted before the atlas updates the metadata, so
+      // the updates run with up to `maxInFlight` frames in flight.
+      while inFlight.count >= maxInFlight || (!inFlight.isEmpty && Bool.random()) {
+        completedFrame = inFlight.removeFirst().frame
+      }
+      submittedFrame += 1
+      inFlight.append((submittedFrame, Array(buffer[0..<directory.leafCount])))
+      directory.releaseRetiredLeaves(completedFrame: quarantine ? completedFrame : Int.max)
+
+      var dirty = Set<Int>()
+      for _ in 0..<Int.random(in: 1...4) {
+        let leaf = Int.random(in: 0..<directory.leafCount)
+        let bricks = (leaf * leafSize)..<min((leaf + 1) * leafSize, brickCount)
+        if Bool.random() {
+          let flag = UInt32.random(in: 0..<flagCount)
+          for brick in bricks {
+            dense[brick] = flag
+          }
+        } else {
+          for _ in 0..<Int.random(in: 1...16) {
+            let brick = Int.random(in: bricks)
+            dense[brick] = Bool.random() ? UInt32.random(in: 0..<flagCount)
+                                         : flagCount + UInt32.random(in: 0..<4096)
+          }
+        }
+        dirty.insert(leaf)
+      }
+
+      for leaf in dirty.sorted() {
+        let start = leaf * leafSize
+        let end = min(start + leafSize, brickCount)
+        let frame = quarantine ? submittedFrame : 0
+        var written = dense[start..<end].withUnsafeBufferPointer {
+          directory.update(leaf: leaf, entries: $0, buffer: &buffer, frame: frame)
+        }
+        if written == nil {
+          directory.grow(leafCapacity: 2 * directory.leafCapacity)
+          buffer += [UInt32](repeating: 0, count: directory.elementCount - buffer.count)
+          written = dense[start..<end].withUnsafeBufferPointer {
+            directory.update(leaf: leaf, entries: $0, buffer: &buffer, frame: frame)
+          }
+        }
+        expect(written != nil, "leaf \(leaf) could not be written after growing the pool")
+
+        let entry = buffer[leaf]
+        if entry >= flagCount &&
+            inFlight.contains(where: { submitted in
+              submitted.entries.indices.contains { $0 != leaf && submitted.entries[$0] == entry }
+            }) {
+          hazards += 1
+        }
+      }
+
+      buffer.withUnsafeBufferPointer { pointer in
+        for brick in 0..<brickCount
+        where SparseBrickDirectory.lookup(brick, in: pointer.baseAddress!) != dense[brick] {
+          mismatches += 1
+        }
+      }
+    }
+
+    let nonUniformLeaves = (0..<directory.leafCount).filter { leaf in
+      let leafEntries = dense[(leaf * leafSize)..<min((leaf + 1) * leafSize, brickCount)]
+      return leafEntries.first! >= flagCount || leafEntries.contains { $0 != leafEntries.first! }
+    }.count
+    expect(mismatches == 0, "\(mismatches) lookups differ from the dense table")
+    expect(directory.usedLeafCount == nonUniformLeaves,
+           "\(directory.usedLeafCount) leaves in use for \(nonUniformLeaves) non-uniform leaves")
+    logger.info("\(quarantine ? "Retired" : "Immediate") leaf reuse: \(directory.usedLeafCount) " +
+                "leaves in use, \(directory.retiredLeafCount) retired, pool of " +
+                "\(directory.leafCapacity), \(hazards) leaves rewritten under a frame in flight")
+    return hazards
+  }
+
+  expect(simulate(quarantine: true) == 0,
+         "a leaf was reused while a frame in flight still pointed to it")
+  expect(simulate(quarantine: false) > 0,
+         "reusing leaves right away never hit a frame in flight, so the check is not sensitive")
+  return passed
+}
+
+// MARK: - Brick Quantizer
+
+/// Checks the reconstruction error of 8-bit quantized bricks.
+let quantizerCheck = SelfCheck(
+  name: "quantizer",
+  arguments: "[bricks]",
+  summary: "Quantizes random and ramp bricks with BrickQuantizer and checks that the " +
+           "reconstructed values are within half a quantization step",
+  run: runQuantizerCheck
+)
+
+/**
+ Quantizes `bricks` random bricks (default 100) of 32³ voxels with random value ranges, plus
+ ramps over the full and a narrow range, a constant brick and bricks whose voxel count is
+ not a multiple of the vector width. Each brick is reconstructed with the returned scale and
+ bias as the shaders do, `value / 255 * scale + bias`, and compared with the 16-bit input.
+
+ - Parameter arguments: Optionally the number of random bricks.
+ - Returns: True if no voxel is off by more than `(max - min) / 510` in 16-bit units, i.e.
+ half a step of the brick's range.
+ - Throws: `SelfCheckError.invalidArguments` if the argument is not a positive integer.
+ */
+func runQuantizerCheck(_ arguments: [String]) throws -> Bool {
+  guard arguments.count <= 1 else { throw SelfCheckError.invalidArguments("quantizer") }
+  let randomBricks = try positiveArgument(arguments, 0, default: 100, check: "quantizer")
+  let voxelCount = 32 * 32 * 32
+
+  var bricks: [(name: String, values: [UInt16])] = []
+  for index in 0..<randomBricks {
+    let low = UInt16.random(in: 0...UInt16.max)
+    let high = index % 4 == 0 ? UInt16.max : UInt16.random(in: low...UInt16.max)
+    bricks.append(("random \(low)...\(high)",
+                   (0..<voxelCount).map { _ in UInt16.random(in: low...high) }))
+  }
+  bricks.append(("full ramp", (0..<voxelCount).map {
+    UInt16(Double($0) / Double(voxelCount - 1) * Double(UInt16.max))
+  }))
+  bricks.append(("narrow ramp", (0..<voxelCount).map { UInt16(20000 + $0 % 300) }))
+  bricks.append(("constant", [UInt16](repeating: 1234, count: voxelCount)))
+  bricks.append(("odd ramp", (0..<1007).map { UInt16($0 * 65) }))
+  bricks.append(("odd random", (0..<13).map { _ in UInt16.random(in: 0...UInt16.max) }))
+
+  var passed = true
+  var worstRatio = 0.0
+  for brick in bricks {
+    let count = brick.values.count
+    let data = UnsafeMutablePointer<UInt8>.allocate(capacity: count * MemoryLayout<UInt16>.stride)
+    defer { data.deallocate() }
+    brick.values.withUnsafeBytes {
+      UnsafeMutableRawPointer(data).copyMemory(from: $0.baseAddress!, byteCount: $0.count)
+    }
+
+    let range = BrickQuantizer.quantize(data, voxelCount: count)
+
+    let spread = Double(brick.values.max()!) - Double(brick.values.min()!)
+    let bound = spread / 510
+    var maxError = 0.0
+    for voxel in 0..<count {
+      let reconstructed = Double(Float(data[voxel]) / 255 * range.x + range.y) * Double(UInt16.max)
+      maxError = max(maxError, abs(reconstructed - Double(brick.values[voxel])))
+    }
+    // Allow for the single precision arithmetic of the quantizer and the shaders.
+    if maxError > bound + 1e-6 * Double(UInt16.max) {
+      logger.error("quantizer: \(brick.name) is off by up to \(maxError), more than \(bound)")
+      passed = false
+    }
+    if bound > 0 {
+      worstRatio = max(worstRatio, maxError / bound)
+    }
+  }
+  logger.info("\(bricks.count) bricks quantized, largest error " +
+              "\(String(format: "%.3f", worstRatio)) of half a step")
+  return passed
+}
+
+// MARK: - Warm Start
+
+/// Checks saving, loading and ranking the bricks of an atlas warm start.
+let warmStartCheck = SelfCheck(
+  name: "warm-start",
+  arguments: "",
+  summary: "Saves and loads an AtlasWarmStart record, checks that files of another version " +
+           "or dataset are rejected, and checks the order of the restored requests",
+  run: runWarmStartCheck
+)
+
+/**
+ Runs the warm start scenarios against the metadata of a synthetic 128³ volume:
+
+ - Round trip: a saved record loads with the same bricks, position and view direction.
+ - Rejection: loading fails with `unsupportedVersion` for a file of another version and with
+   `brickCountMismatch` for a dataset with another number of bricks.
+ - Filtering: `requests(for:)` drops negative, out of range and repeated brick IDs.
+ - Ranking: bricks in front of the camera come before those behind it, nearer before farther,
+   and at equal distance more recently used first; the hit counts strictly decrease.
+
+ - Parameter arguments: None.
+ - Returns: True if all scenarios behave as expected.
+ - Throws: `SelfCheckError.invalidArguments` if arguments are given, or an error if the
+ temporary file cannot be written.
+ */
+func runWarmStartCheck(_ arguments: [String]) throws -> Bool {
+  guard arguments.isEmpty else { throw SelfCheckError.invalidArguments("warm-start") }
+  let metadata = syntheticMetadata(size: 128, brickSize: 8, bytesPerComponent: 1)
+  let brickCount = metadata.brickMetadata.count
+  let url = FileManager.default.temporaryDirectory
+    .appendingPathComponent("warm-start-check-\(UUID().uuidString).json")
+  defer { try? FileManager.default.removeItem(at: url) }
+  var passed = true
+  func expect(_ condition: Bool, _ message: String) {
+    if !condition {
+      logger.error("warm-start: \(message)")
+      passed = false
+    }
+  }
+
+  // Round trip
+  let saved = AtlasWarmStart(brickCount: brickCount, bricks: [42, 7, brickCount - 1],
+                             position: SIMD3<Float>(0.25, 0.5, 1.5),
+                             forward: SIMD3<Float>(0, 0, -1))
+  try saved.save(to: url)
+  do {
+    let loaded = try AtlasWarmStart.load(from: url, brickCount: brickCount)
+    expect(loaded.version == AtlasWarmStart.currentVersion && loaded.bricks == saved.bricks &&
+           loaded.position == saved.position && loaded.forward == saved.forward,
+           "the loaded record differs from the saved one")
+  } catch {
+    expect(false, "loading the saved record failed: \(error.localizedDescription)")
+  }
+
+  // Rejection
+  do {
+    _ = try AtlasWarmStart.load(from: url, brickCount: brickCount + 1)
+    expect(false, "a record of a dataset with another brick count was loaded")
+  } catch AtlasWarmStartError.brickCountMismatch(let stored, let expected) {
+    expect(stored == brickCount && expected == brickCount + 1,
+           "the brick count mismatch reports \(stored) and \(expected)")
+  }
+  var future = saved
+  future.version = AtlasWarmStart.currentVersion + 1
+  try future.save(to: url)
+  do {
+    _ = try AtlasWarmStart.load(from: url, brickCount: brickCount)
+    expect(false, "a record of another version was loaded")
+  } catch AtlasWarmStartError.unsupportedVersion(let version) {
+    expect(version == future.version, "the version error reports version \(version)")
+  }
+
+  // Filtering
+  let filtered = AtlasWarmStart(brickCount: brickCount,
+                                bricks: [-1, 5, 5, brickCount, 7, brickCount + 10, 5],
+                                position: SIMD3<Float>(repeating: 0.5),
+                                forward: SIMD3<Float>(1, 0, 0)).requests(for: metadata)
+  expect(filtered.IDs.sorted() == [5, 7] && filtered.hits.count == 2,
+         "requests \(filtered.IDs) remained, expected 5 and 7")
+
+  // Ranking: level 0 has 16³ bricks of 1/16 edge length and the camera looks along +x from
+  // the center. Two bricks in front are equally near, one in front is farther, and the
+  // nearest one is behind the camera.
+  func brick(_ x: Int, _ y: Int, _ z: Int) -> Int { x + y * 16 + z * 256 }
+  let nearFront = brick(9, 7, 7)
+  let nearFrontOther = brick(9, 8, 8)
+  let farFront = brick(12, 7, 7)
+  let behind = brick(7, 7, 7)
+  let ranked = AtlasWarmStart(brickCount: brickCount,
+                              bricks: [behind, farFront, nearFrontOther, nearFront],
+                              position: SIMD3<Float>(repeating: 0.5),
+                              forward: SIMD3<Float>(1, 0, 0)).requests(for: metadata)
+  let expectedOrder = [nearFrontOther, nearFront, farFront, behind]
+  expect(ranked.IDs == expectedOrder,
+         "requests are ranked \(ranked.IDs), expected \(expectedOrder)")
+  expect(zip(ranked.hits, ranked.hits.dropFirst()).allSatisfy { $0 > $1 },
+         "the hit counts \(ranked.hits) do not decrease")
+
+  return passed
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+ Software, and to permit persons to whom the Software is furnished to do so, subject
+ to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,392 @@
+import Foundation
+
+// MARK: - Transfer Estimation
+
+/// Checks the transfer estimates against links of known bandwidth and latency.
+let transferEstimatorCheck = SelfCheck(
+  name: "transfer-estimator",
+  arguments: "<local_file> [rounds]",
+  summary: "Serves the dataset's bricks over shaped in-process links and compares the " +
+           "estimated round trip time and throughput with the configured ones",
+  run: runTransferEstimatorCheck
+)
+
+/// A link with a fixed bandwidth and latency.
+private struct ShapedLink: CustomStringConvertible {
+  /// The bandwidth in bytes per second.
+  let bandwidth: Double
+  /// The round trip time in seconds.
+  let rtt: Double
+
+  var description: String {
+    "\(Int(bandwidth / 1_000_000)) MB/s, \(Int(rtt * 1000)) ms"
+  }
+}
+
+/**
+ Runs `rounds` rounds (default 30) of pipelined requests sized by the data source's own
+ `TransferEstimator` over several shaped links and checks that the estimates converge to
+ the link parameters. The server is emulated in-process on a `SocketTransport` pair: it
+ answers the `OPEN` handshake with the metadata of the local file, and sends every response
+ half a round trip after its request arrived plus the time its payload occupies the link, so
+ responses queue behind each other as on a real bottleneck.
+
+ - Parameter arguments: The local dataset file, and optionally the number of rounds.
+ - Returns: True if the RTT estimate is within 25% (at least 5 ms) and the throughput
+ estimate within 25% of the link on every link.
+ - Throws: An error if the file cannot be opened or the emulated connection fails.
+ */
+func runTransferEstimatorCheck(_ arguments: [String]) throws -> Bool {
+  guard (1...2).contains(arguments.count) else {
+    throw SelfCheckError.invalidArguments("transfer-estimator")
+  }
+  let rounds = try positiveArgument(arguments, 1, default: 30, check: "transfer-estimator")
+  let metadata = try BORGVRMetaData(filename: arguments[0])
+  let brickSizes = metadata.brickMetadata.map { $0.size }
+
+  let links = [
+    ShapedLink(bandwidth: 8_000_000, rtt: 0.02),
+    ShapedLink(bandwidth: 32_000_000, rtt: 0.06),
+    ShapedLink(bandwidth: 100_000_000, rtt: 0.15),
+  ]
+
+  var passed = true
+  for link in links {
+    let (clientTransport, serverTransport) = try SocketTransport.makePair()
+    let server = Task.detached {
+      try await emulateServer(on: AsyncConnection(transport: serverTransport),
+                              metadata: metadata, link: link)
+    }
+    defer {
+      server.cancel()
+      clientTransport.cancel()
+      serverTransport.cancel()
+    }
+
+    let source = try RemoteDataSource(connection: AsyncConnection(transport: clientTransport),
+                                      datasetID: "shaped", protocolVersion: WireProtocol.version,
+                                      logger: nil)
+    var cursor = 0
+    for _ in 0..<rounds {
+      let estimator = source.transferEstimator
+      let roundBytes = estimator.roundBytes(latencyBudget: 0.1)
+      var indices: [Int] = []
+      var bytes = 0
+      while bytes < roundBytes {
+        indices.append(cursor)
+        bytes += brickSizes[cursor]
+        cursor = (cursor + 1) % brickSizes.count
+      }
+      let batches = TransferEstimator.split(indices, sizes: indices.map { brickSizes[$0] },
+                                            targetBytes: estimator.batchBytes(latencyBudget: 0.1),
+                                            maxCount: 1024)
+      try source.getRawBricksPipelined(batches: batches) { _, _, _ in }
+    }
+
+    let metrics = source.transferEstimator.metrics
+    let rttError = abs(metrics.minRTT - link.rtt)
+    let throughputError = abs(metrics.throughput - link.bandwidth) / link.bandwidth
+    let linkPassed = rttError <= max(0.005, 0.25 * link.rtt) && throughputError <= 0.25
+    let result = linkPassed ? "ok" : "FAILED"
+    logger.info("\(link): estimated \(String(format: "%.1f", metrics.minRTT * 1000)) ms " +
+                "(smoothed \(String(format: "%.1f", metrics.smoothedRTT * 1000)) ms), " +
+                "\(String(format: "%.1f", metrics.throughput / 1_000_000)) MB/s " +
+                "after \(metrics.sampleCount) rounds: \(result)")
+    passed = passed && linkPassed
+  }
+  return passed
+}
+
+/**
+ Plays a server behind a shaped link until the connection closes: answers the `OPEN` and,
+ with version 2, the protocol switch command, then answers every `getBricks` frame or, with
+ version 1, every `GETBRICKS` command with zeroed bricks of the requested sizes. Control
+ frames and other commands are ignored.
+
+ - Parameters:
+ - connection: The server side of the connection.
+ - metadata: The metadata sent to the client.
+ - link: The link to emulate.
+ - protocolVersion: The wire protocol version the client uses.
+ - Throws: An error once the connection fails or closes.
+ */
+private func emulateServer(on connection: AsyncConnection, metadata: BORGVRMetaData,
+                           link: ShapedLink,
+                           protocolVersion: Int = WireProtocol.version) async throws {
+  func sendBinaryResponse(_ payload: Data) async throws {
+    var message = Data(from: UInt32(payload.count).littleEndian)
+    message.append(payload)
+    try await connection.send(message)
+  }
+  _ = try await connection.receiveText(terminator: "\n")
+  try await sendBinaryResponse(metadata.toData())
+  if protocolVersion >= WireProtocol.version {
+    _ = try await connection.receiveText(terminator: "\n")
+    try await sendBinaryResponse(Data(WireProtocol.switchAcknowledgement.utf8))
+  }
+
+  // Responses are released by a separate task at the time they finish crossing the link,
+  // so the reader keeps timestamping requests as they arrive.
+  let (responses, continuation) = AsyncStream.makeStream(of: (deadline: Double, frame: Data).self)
+  let sender = Task {
+    for await response in responses {
+      let delay = response.deadline - secondsNow()
+      if delay > 0 {
+        try await Task.sleep(nanoseconds: UInt64(delay * 1_000_000_000))
+      }
+      try await connection.send(response.frame)
+    }
+  }
+  defer {
+    continuation.finish()
+    sender.cancel()
+  }
+
+  var linkBusyUntil = 0.0
+  while true {
+    guard protocolVersion >= WireProtocol.version else {
+      let command = try await connection.receiveText(terminator: "\n", timeout: 3600)
+      let arrival = secondsNow() + link.rtt / 2
+      let parts = command.split(whereSeparator: { $0 == " " || $0 == "\n" })
+      guard parts.first == "GETBRICKS" else { continue }
+      let size = parts.dropFirst().compactMap { Int($0) }.reduce(0) {
+        $0 + metadata.brickMetadata[$1].size
+      }
+      linkBusyUntil = max(arrival, linkBusyUntil) + Double(size) / link.bandwidth
+      var message = Data(from: UInt32(size).littleEndian)
+      message.append(Data(count: size))
+      continuation.yield((deadline: linkBusyUntil + link.rtt / 2, frame: message))
+      continue
+    }
+
+    let (header, payload) = try await connection.receiveFrame(timeout: 3600)
+    let arrival = secondsNow() + link.rtt / 2
+    guard header.type == .getBricks else { continue }
+    let (indices, _) = try WireProtocol.decodeGetBricks(payload, maxCount: Int.max,
+                                                        brickCount: metadata.brickMetadata.count)
+    let size = indices.reduce(0) { $0 + metadata.brickMetadata[$1].size }
+    linkBusyUntil = max(arrival, linkBusyUntil) + Double(size) / link.bandwidth
+    let frame = try WireProtocol.frame(.bricks, requestID: header.requestID,
+                                       payload: Data(count: size))
+    continuation.yield((deadline: linkBusyUntil + link.rtt / 2, frame: frame))
+  }
+}
+
+/// The current monotonic time in seconds.
+private func secondsNow() -> Double {
+  Double(DispatchTime.now().uptimeNanoseconds) / 1_000_000_000
+}
+
+// MARK: - Pipelining
+
+/// Compares sequential version 1 requests with pipelined version 2 requests on a slow link.
+let pipeliningBenchmark = SelfCheck(
+  name: "pipelining",
+  arguments: "<local_file> [rtt_ms] [rounds] [bricks_per_request]",
+  summary: "Serves the same bricks over a delayed in-process link with version 1 GETBRICKS " +
+           "commands and with pipelined version 2 requests, and reports MB/s for both",
+  run: runPipeliningBenchmark
+)
+
+/**
+ Requests `rounds` rounds (default 20) of four batches of `bricks_per_request` bricks
+ (default 64) over an in-process link with a round trip time of `rtt_ms` milliseconds
+ (default 40) and 100 MB/s, once with wire protocol version 1, which sends one `GETBRICKS`
+ command and waits for its response before the next, and once with version 2, which sends
+ the four batches of a round at once. Both runs request the same bricks, in the same order,
+ from the emulated server of the transfer estimator check.
+
+ - Parameter arguments: The local dataset file, and optionally the round trip time, the
+ number of rounds and the number of bricks per request.
+ - Returns: True if every response had the size of the requested bricks.
+ - Throws: An error if the file cannot be opened or the emulated connection fails.
+ */
+func runPipeliningBenchmark(_ arguments: [String]) throws -> Bool {
+  guard (1...4).contains(arguments.count) else {
+    throw SelfCheckError.invalidArguments("pipelining")
+  }
+  let rttMilliseconds = try positiveArgument(arguments, 1, default: 40, check: "pipelining")
+  let rounds = try positiveArgument(arguments, 2, default: 20, check: "pipelining")
+  let bricksPerRequest = try positiveArgument(arguments, 3, default: 64, check: "pipelining")
+  let metadata = try BORGVRMetaData(filename: arguments[0])
+  let brickSizes = metadata.brickMetadata.map { $0.size }
+  let link = ShapedLink(bandwidth: 100_000_000, rtt: Double(rttMilliseconds) / 1000)
+
+  let requests = (0..<rounds).map { round in
+    (0..<4).map { batch in
+      (0..<bricksPerRequest).map {
+        ((round * 4 + batch) * bricksPerRequest + $0) % brickSizes.count
+      }
+    }
+  }
+  logger.info("\(link), \(rounds) rounds of 4 requests of \(bricksPerRequest) bricks")
+
+  var passed = true
+  var rates: [Int: Double] = [:]
+  for protocolVersion in [1, WireProtocol.version] {
+    let (clientTransport, serverTransport) = try SocketTransport.makePair()
+    let server = Task.detached {
+      try await emulateServer(on: AsyncConnection(transport: serverTransport),
+                              metadata: metadata, link: link, protocolVersion: protocolVersion)
+    }
+    defer {
+      server.cancel()
+      clientTransport.cancel()
+      serverTransport.cancel()
+    }
+
+    let source = try RemoteDataSource(connection: AsyncConnection(transport: clientTransport),
+                                      datasetID: "delayed", protocolVersion: protocolVersion,
+                                      logger: nil)
+    let timer = HighResolutionTimer()
+    timer.start()
+    var bytes = 0
+    for batches in requests {
+      try source.getRawBricksPipelined(batches: batches) { indices, _, data in
+        let expected = indices.reduce(0) { $0 + brickSizes[$1] }
+        if data.count != expected {
+          logger.error("Version \(protocolVersion): expected \(expected) bytes, " +
+                       "received \(data.count)")
+          passed = false
+        }
+        bytes += data.count
+      }
+    }
+    let seconds = timer.stop()
+    rates[protocolVersion] = Double(bytes) / max(seconds, 1e-9)
+    logger.info("Version \(protocolVersion): \(megabytesPerSecond(bytes, seconds)) " +
+                "(\(bytes / (1024 * 1024)) MB in \(String(format: "%.2f", seconds)) s)")
+  }
+  if let sequential = rates[1], let pipelined = rates[WireProtocol.version], sequential > 0 {
+    logger.info("Pipelining is \(String(format: "%.1f", pipelined / sequential))x as fast")
+  }
+  return passed
+}
+
+// MARK: - Request Queue
+
+/// Times the demand request queue with a large backlog.
+let requestQueueBenchmark = SelfCheck(
+  name: "request-queue",
+  arguments: "[queued] [frames]",
+  summary: "Replays frames of repeated brick misses against a backlog of queued requests, " +
+           "with BrickRequestQueue and with the plain array it replaced",
+  run: runRequestQueueBenchmark
+)
+
+/**
+ Queues `queued` distinct bricks (default 100000) of a synthetic eight-level hierarchy, then
+ replays `frames` frames (default 600). Every frame starts a new generation, requests 5% of
+ the backlog again plus 1000 new bricks, and serves one round of 1024 bricks, as the demand
+ lane does. The same workload runs against the plain array `CachingRemoteDataSource` used
+ before, which appends duplicates and filters served bricks out on every round.
+
+ - Parameter arguments: Optionally the backlog size and the number of frames.
+ - Returns: True if the queue served every distinct brick exactly once.
+ - Throws: `SelfCheckError.invalidArguments` if an argument is not a positive integer.
+ */
+func runRequestQueueBenchmark(_ arguments: [String]) throws -> Bool {
+  guard arguments.count <= 2 else { throw SelfCheckError.invalidArguments("request-queue") }
+  let queued = try positiveArgument(arguments, 0, default: 100_000, check: "request-queue")
+  let frames = try positiveArgument(arguments, 1, default: 600, check: "request-queue")
+  let newPerFrame = 1000
+  let roundSize = 1024
+
+  // Each level has an eighth of the bricks of the next finer one.
+  var levels: [UInt8] = []
+  var levelSize = (queued + frames * newPerFrame) * 7 / 8 + 1
+  for level in 0..<8 {
+    levels += [UInt8](repeating: UInt8(level), count: max(1, levelSize))
+    levelSize /= 8
+  }
+  let order = Array(0..<levels.count).shuffled()
+  let backlog = Array(order.prefix(queued))
+
+  // The same requests for both variants.
+  var requests: [[Int]] = []
+  var next = queued
+  for _ in 0..<frames {
+    var frame = (0..<queued / 20).map { _ in backlog[Int.random(in: 0..<queued)] }
+    frame += order[min(order.count, next)..<min(order.count, next + newPerFrame)]
+    next += newPerFrame
+    requests.append(frame)
+  }
+
+  var queue = BrickRequestQueue(levels: levels)
+  var served = [Bool](repeating: false, count: levels.count)
+  var servedTwice = 0
+  let timer = HighResolutionTimer()
+  timer.start()
+  for index in backlog {
+    queue.push(index)
+  }
+  for frame in requests {
+    queue.newGeneration()
+    for index in frame where !served[index] {
+      queue.push(index)
+    }
+    for _ in 0..<roundSize {
+      guard let index = queue.popFirst() else { break }
+      if served[index] { servedTwice += 1 }
+      served[index] = true
+    }
+  }
+  let queueSeconds = timer.stop()
+  let backlogLeft = queue.count
+  while let index = queue.popFirst() {
+    if served[index] { servedTwice += 1 }
+    served[index] = true
+  }
+  let distinct = Set(backlog + requests.joined()).count
+  let allServed = served.filter { $0 }.count == distinct
+
+  var list: [Int] = []
+  var listServed = [Bool](repeating: false, count: levels.count)
+  timer.start()
+  list += backlog
+  for frame in requests {
+    list += frame
+    list.removeAll { listServed[$0] }
+    let take = min(roundSize, list.count)
+    for index in list.prefix(take) {
+      listServed[index] = true
+    }
+    list.removeFirst(take)
+  }
+  let listSeconds = timer.stop()
+
+  let operations = Double(queued + requests.reduce(0) { $0 + $1.count } + frames * roundSize)
+  logger.info("BrickRequestQueue: \(String(format: "%.3f", queueSeconds)) s, " +
+              "\(String(format: "%.0f", queueSeconds / operations * 1e9)) ns per request, " +
+              "\(backlogLeft) bricks queued at the end")
+  logger.info("Plain array: \(String(format: "%.3f", listSeconds)) s, " +
+              "\(String(format: "%.0f", listSeconds / operations * 1e9)) ns per request, " +
+              "\(list.count) entries queued at the end")
+  if servedTwice > 0 || !allServed {
+    logger.error("The queue served \(servedTwice) bricks twice or missed some of \(distinct)")
+    return false
+  }
+  return true
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+ Software, and to permit persons to whom the Software is furnished to do so, subject
+ to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,109 @@
+import Foundation
+
+/**
+ A check or benchmark of a single component that runs without a GPU or headset, selected by
+ name in mode T.
+ */
+struct SelfCheck {
+  /// The name that selects the check on the command line.
+  let name: String
+  /// The arguments the check expects, for the usage message.
+  let arguments: String
+  /// What the check does, for the usage message.
+  let summary: String
+  /// Runs the check. Returns false if it found a problem; throws if it could not run.
+  let run: ([String]) throws -> Bool
+}
+
+/**
+ An error type for self checks that cannot run.
+ */
+enum SelfCheckError: Error, LocalizedError {
+  /// The arguments do not match what the check expects.
+  case invalidArguments(String)
+
+  /// A localized description of the error.
+  var errorDescription: String? {
+    switch self {
+      case .invalidArguments(let check):
+        return "Invalid arguments for check \(check)."
+    }
+  }
+}
+
+/// All self checks, in the order they are listed in the usage message.
+let selfChecks: [SelfCheck] = [
+  serverLoadCheck,
+  brickSendBenchmark,
+  transferEstimatorCheck,
+  pipeliningBenchmark,
+  requestQueueBenchmark,
+  pageReplacementBenchmark,
+  evictionReplayBenchmark,
+  brickLoaderCheck,
+  frameRingCheck,
+  sparseDirectoryCheck,
+  quantizerCheck,
+  warmStartCheck,
+]
+
+/// The list of self checks for the usage message.
+var selfCheckUsage: String {
+  selfChecks.map { check in
+    "        \(check.name) \(check.arguments)\n            \(check.summary)"
+  }.joined(separator: "\n")
+}
+
+/**
+ Parses an optional positive integer argument.
+
+ - Parameters:
+ - arguments: The arguments of the check.
+ - index: The position of the argument.
+ - defaultValue: The value if the argument is missing.
+ - check: The name of the check, for the error.
+ - Returns: The value.
+ - Throws: `SelfCheckError.invalidArguments` if the argument is not a positive integer.
+ */
+func positiveArgument(_ arguments: [String], _ index: Int, default defaultValue: Int,
+                      check: String) throws -> Int {
+  guard index < arguments.count else { return defaultValue }
+  guard let value = Int(arguments[index]), value > 0 else {
+    throw SelfCheckError.invalidArguments(check)
+  }
+  return value
+}
+
+/**
+ Formats a byte rate in MB/s.
+
+ - Parameters:
+ - bytes: The number of bytes.
+ - seconds: The duration in seconds.
+ - Returns: The rate with one decimal.
+ */
+func megabytesPerSecond(_ bytes: Int, _ seconds: Double) -> String {
+  String(format: "%.1f MB/s", Double(bytes) / max(seconds, 1e-9) / (1024 * 1024))
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+ Software, and to permit persons to whom the Software is furnished to do so, subject
+ to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
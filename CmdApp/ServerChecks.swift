@@ -0,0 +1,326 @@
+import Foundation
+import Network
+
+// MARK: - Concurrent Connections
+
+/// Runs many clients against a BorgVR server at the same time.
+let serverLoadCheck = SelfCheck(
+  name: "server-load",
+  arguments: "<host> <port> <dataset_id> <local_file> [connections] [rounds]",
+  summary: "Requests random bricks on several connections at once, half of them with the " +
+           "version 1 text protocol, and compares every brick with a local copy of the dataset",
+  run: runServerLoadCheck
+)
+
+/**
+ Opens `connections` connections to a running server (default 8) and has each of them
+ request `rounds` rounds (default 50) of four batches of random bricks at the same time.
+ Every other connection stays on wire protocol version 1 and sends the batches as `OPEN` and
+ `GETBRICKS` text commands one after another; the rest pipeline them with version 2 if the
+ server supports it. Every received brick is compared with the same brick of the local copy
+ of the dataset, so responses that are interleaved within a connection or mixed up between
+ connections fail the check. Reports the total throughput, and the slowest per-connection
+ throughput of each protocol version.
+
+ - Parameter arguments: The host, port, dataset ID, local dataset file, and optionally the
+ number of connections and rounds.
+ - Returns: True if all connections received exactly the requested bricks.
+ - Throws: An error if the server or the local file cannot be opened.
+ */
+func runServerLoadCheck(_ arguments: [String]) throws -> Bool {
+  guard (4...6).contains(arguments.count), let port = UInt16(arguments[1]) else {
+    throw SelfCheckError.invalidArguments("server-load")
+  }
+  let host = arguments[0]
+  let datasetID = arguments[2]
+  let connectionCount = try positiveArgument(arguments, 4, default: 8, check: "server-load")
+  let rounds = try positiveArgument(arguments, 5, default: 50, check: "server-load")
+
+  let reference = try BORGVRFileData(filename: arguments[3])
+  let brickMetadata = reference.getMetadata().brickMetadata
+
+  let manager = BORGVRRemoteDataManager(host: host, port: port, logger: nil, notifier: nil)
+  try manager.connect(timeout: 5)
+  let maxBricks = manager.maxBricksPerGetRequest
+  let protocolVersion = manager.protocolVersion
+  logger.info("Server speaks wire protocol \(protocolVersion), at most \(maxBricks) bricks " +
+              "per request; starting \(connectionCount) connections")
+
+  let lock = NSLock()
+  var failures: [String] = []
+  var totalBytes = 0
+  var slowestRates: [Int: Double] = [:]
+
+  let group = DispatchGroup()
+  let clientQueue = DispatchQueue(label: "ServerLoadCheck", attributes: .concurrent)
+  let timer = HighResolutionTimer()
+  timer.start()
+
+  for client in 0..<connectionCount {
+    clientQueue.async(group: group) {
+      do {
+        let connection = try AsyncConnection.blocking {
+          try await AsyncConnection.connect(host: host, port: port, timeout: 5)
+        }
+        let clientVersion = client % 2 == 1 ? 1 : protocolVersion
+        let source = try RemoteDataSource(connection: connection, datasetID: datasetID,
+                                          protocolVersion: clientVersion, logger: nil)
+        guard source.getMetadata().brickMetadata.count == brickMetadata.count else {
+          lock.withLock { failures.append("Client \(client): the dataset does not match the local file") }
+          return
+        }
+
+        let clientTimer = HighResolutionTimer()
+        clientTimer.start()
+        var bytes = 0
+        for _ in 0..<rounds {
+          let batches = (0..<4).map { _ in
+            (0..<Int.random(in: 1...maxBricks)).map { _ in Int.random(in: 0..<brickMetadata.count) }
+          }
+          try source.getRawBricksPipelined(batches: batches) { indices, _, data in
+            var offset = 0
+            for index in indices {
+              let brick = brickMetadata[index]
+              let matches = brick.size == 0 || data.withUnsafeBytes { received in
+                offset + brick.size <= received.count &&
+                memcmp(received.baseAddress! + offset,
+                       reference.rawBrickPointer(brickMeta: brick), brick.size) == 0
+              }
+              guard matches else {
+                throw BORGVRDataError.networkError(
+                  message: "brick \(index) differs from the local copy")
+              }
+              offset += brick.size
+            }
+            bytes += data.count
+          }
+        }
+        let seconds = clientTimer.stop()
+        lock.withLock {
+          totalBytes += bytes
+          slowestRates[clientVersion] = min(slowestRates[clientVersion] ?? .infinity,
+                                            Double(bytes) / max(seconds, 1e-9))
+        }
+      } catch {
+        lock.withLock { failures.append("Client \(client): \(error.localizedDescription)") }
+      }
+    }
+  }
+  group.wait()
+  let seconds = timer.stop()
+
+  for failure in failures {
+    logger.error(failure)
+  }
+  logger.info("Received \(totalBytes / (1024 * 1024)) MB in \(String(format: "%.2f", seconds)) s, " +
+              "\(megabytesPerSecond(totalBytes, seconds)) in total")
+  for (version, rate) in slowestRates.sorted(by: { $0.key < $1.key }) {
+    logger.info("Slowest version \(version) connection: \(megabytesPerSecond(Int(rate), 1))")
+  }
+  return failures.isEmpty
+}
+
+// MARK: - Brick Response Throughput
+
+/// Compares the old copying GETBRICKS response with the zero-copy one.
+let brickSendBenchmark = SelfCheck(
+  name: "brick-send",
+  arguments: "<local_file> [rounds] [bricks_per_response]",
+  summary: "Sends GETBRICKS responses over loopback, once copied into a message and once " +
+           "straight from the mapping, and reports MB/s for both",
+  run: runBrickSendBenchmark
+)
+
+/**
+ Sends `rounds` responses (default 200) of `bricks_per_response` random bricks (default 64)
+ over a loopback connection, first the way `TCPServer` built them before responses were sent
+ from the mapping (every brick copied into a scratch buffer, appended to a Data, and the whole
+ response copied again behind its size prefix), then the way it sends them now (no-copy Data
+ slices of the mapping inside one batch). The client only counts the received bytes, so the
+ difference is the cost of building the response.
+
+ - Parameter arguments: The local dataset file, and optionally the number of rounds and the
+ number of bricks per response.
+ - Returns: True if every response arrived with the expected size.
+ - Throws: An error if the file cannot be opened or the loopback connection fails.
+ */
+func runBrickSendBenchmark(_ arguments: [String]) throws -> Bool {
+  guard (1...3).contains(arguments.count) else {
+    throw SelfCheckError.invalidArguments("brick-send")
+  }
+  let rounds = try positiveArgument(arguments, 1, default: 200, check: "brick-send")
+  let bricksPerResponse = try positiveArgument(arguments, 2, default: 64, check: "brick-send")
+
+  let dataset = try BORGVRFileData(filename: arguments[0])
+  let brickMetadata = dataset.getMetadata().brickMetadata
+  let (server, client) = try loopbackPair()
+  defer {
+    server.cancel()
+    client.cancel()
+  }
+
+  let scratch = dataset.allocateBrickBuffer()
+  defer { scratch.deallocate() }
+
+  let senders: [(name: String, send: ([BrickMetadata], Int) throws -> Void)] = [
+    ("copy", { bricks, totalSize in
+      var brickData = Data(capacity: totalSize)
+      for brick in bricks {
+        try dataset.getRawBrick(brickMeta: brick, outputBuffer: scratch)
+        brickData.append(Data(bytes: scratch, count: brick.size))
+      }
+      var message = Data()
+      message.append(Data(from: Int32(totalSize)))
+      message.append(brickData)
+      server.send(content: message, completion: .idempotent)
+    }),
+    ("zero-copy", { bricks, totalSize in
+      server.batch {
+        server.send(content: Data(from: Int32(totalSize)), completion: .idempotent)
+        for brick in bricks where brick.size > 0 {
+          let content = Data(bytesNoCopy: dataset.rawBrickPointer(brickMeta: brick),
+                             count: brick.size,
+                             deallocator: .custom({ _, _ in withExtendedLifetime(dataset) {} }))
+          server.send(content: content, completion: .idempotent)
+        }
+      }
+    }),
+  ]
+
+  var passed = true
+  for sender in senders {
+    let timer = HighResolutionTimer()
+    timer.start()
+    var bytes = 0
+    for _ in 0..<rounds {
+      let bricks = (0..<bricksPerResponse).map { _ in
+        brickMetadata[Int.random(in: 0..<brickMetadata.count)]
+      }
+      let totalSize = bricks.reduce(0) { $0 + $1.size }
+      try sender.send(bricks, totalSize)
+      let received = try receiveByteCount(client, MemoryLayout<Int32>.size + totalSize)
+      if received != MemoryLayout<Int32>.size + totalSize {
+        logger.error("\(sender.name): expected \(MemoryLayout<Int32>.size + totalSize) bytes, " +
+                     "received \(received)")
+        passed = false
+      }
+      bytes += received
+    }
+    let seconds = timer.stop()
+    logger.info("\(sender.name): \(megabytesPerSecond(bytes, seconds)) " +
+                "(\(bytes / (1024 * 1024)) MB in \(String(format: "%.2f", seconds)) s)")
+  }
+  return passed
+}
+
+/**
+ Opens a TCP connection to itself on the loopback interface.
+
+ - Returns: The accepted server side and the client side, both ready.
+ - Throws: An error if the listener or either side fails to start.
+ */
+func loopbackPair() throws -> (server: NWConnection, client: NWConnection) {
+  let queue = DispatchQueue(label: "LoopbackPair")
+  let listener = try NWListener(using: .tcp, on: .any)
+  defer { listener.cancel() }
+
+  let listening = DispatchSemaphore(value: 0)
+  let accepted = DispatchSemaphore(value: 0)
+  var server: NWConnection?
+  listener.stateUpdateHandler = { state in
+    if case .ready = state { listening.signal() }
+  }
+  listener.newConnectionHandler = { connection in
+    server = connection
+    accepted.signal()
+  }
+  listener.start(queue: queue)
+  guard listening.wait(timeout: .now() + 5) == .success, let port = listener.port else {
+    throw BORGVRDataError.networkError(message: "loopback listener did not start")
+  }
+
+  let client = NWConnection(host: "127.0.0.1", port: port, using: .tcp)
+  try startAndWait(client, on: queue)
+  guard accepted.wait(timeout: .now() + 5) == .success, let server else {
+    client.cancel()
+    throw BORGVRDataError.networkError(message: "loopback connection was not accepted")
+  }
+  try startAndWait(server, on: queue)
+  return (server, client)
+}
+
+/**
+ Starts a connection and waits until it is ready.
+
+ - Parameters:
+ - connection: The connection to start.
+ - queue: The queue for its callbacks.
+ - Throws: An error if the connection fails or is not ready within five seconds.
+ */
+private func startAndWait(_ connection: NWConnection, on queue: DispatchQueue) throws {
+  let ready = DispatchSemaphore(value: 0)
+  connection.stateUpdateHandler = { state in
+    switch state {
+      case .ready, .failed, .cancelled: ready.signal()
+      default: break
+    }
+  }
+  connection.start(queue: queue)
+  guard ready.wait(timeout: .now() + 5) == .success, connection.state == .ready else {
+    throw BORGVRDataError.networkError(message: "loopback connection did not become ready")
+  }
+  connection.stateUpdateHandler = nil
+}
+
+/**
+ Receives and discards the given number of bytes.
+
+ - Parameters:
+ - connection: The connection to read from.
+ - count: The number of bytes to receive.
+ - Returns: The number of bytes received, less than `count` if the connection closed.
+ - Throws: An error if receiving fails.
+ */
+private func receiveByteCount(_ connection: NWConnection, _ count: Int) throws -> Int {
+  var received = 0
+  while received < count {
+    let done = DispatchSemaphore(value: 0)
+    var chunk = 0
+    var failure: Error?
+    var closed = false
+    connection.receive(minimumIncompleteLength: 1, maximumLength: count - received) {
+      data, _, isComplete, error in
+      chunk = data?.count ?? 0
+      failure = error
+      closed = isComplete
+      done.signal()
+    }
+    done.wait()
+    if let failure { throw failure }
+    received += chunk
+    if closed && chunk == 0 { break }
+  }
+  return received
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of
+ Duisburg-Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in the
+ Software without restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the
+ Software, and to permit persons to whom the Software is furnished to do so, subject
+ to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
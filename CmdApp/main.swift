@@ -8,13 +8,21 @@ let logger = PrintfLogger(useColors: false, etaFormat: .mmss)
 
  - DicomConversion: Converts DICOM files.
  - QVISConversion: Converts a QVIS volume.
+ - SliceStackConversion: Converts a directory of raw slice files.
+ - Repack: Re-bricks an existing BorgVR file with new parameters.
  - DemoDataCreation: Generates demo volume data.
+ - PrefetchReplay: Replays a recorded head pose trace through the prefetch planner.
+ - SelfCheck: Runs a self check or benchmark of a single component.
  */
 enum Mode: String {
   case DicomConversion = "D"
   case QVISConversion = "Q"
   case NRRDConversion = "N"
+  case SliceStackConversion = "S"
+  case Repack = "R"
   case DemoDataCreation = "C"
+  case PrefetchReplay = "P"
+  case SelfCheck = "T"
 }
 
 /**
@@ -28,6 +36,24 @@ enum DatasetType: String {
   case FractalData = "F"
 }
 
+/**
+ Optional settings that restrict which part of the source volume is converted.
+
+ - roiMin: The first voxel of the region of interest (inclusive), or `nil` for the whole volume.
+ - roiMax: The end of the region of interest (exclusive), or `nil` for the whole volume.
+ - startLevel: The hierarchy level the output starts at; level `k` decimates the source by `2^k`.
+ */
+struct ConversionOptions {
+  var roiMin: Vec3<Int>? = nil
+  var roiMax: Vec3<Int>? = nil
+  var startLevel: Int = 0
+
+  /// Indicates whether the options change the converted volume at all.
+  var isIdentity: Bool {
+    return roiMin == nil && startLevel == 0
+  }
+}
+
 /**
  A structure encapsulating common parameters for volume conversion.
 
@@ -38,6 +64,7 @@ struct CommonParameters {
   let datasetDescription: String
   let maxBrickSize: Int
   let overlap: Int
+  var options = ConversionOptions()
 }
 
 /**
@@ -62,6 +89,23 @@ struct HeaderFileModeParameters {
   let common: CommonParameters
 }
 
+/**
+ Parameters specific to slice stack conversion mode.
+
+ - inputDirectory: The directory containing one raw file per z-slice.
+ - byteDepth: The number of bytes per voxel.
+ - sizeX: The slice size along the X axis.
+ - sizeY: The slice size along the Y axis.
+ - common: Shared parameters such as output filename and brick configuration.
+ */
+struct SliceStackModeParameters {
+  let inputDirectory: String
+  let byteDepth: Int
+  let sizeX: Int
+  let sizeY: Int
+  let common: CommonParameters
+}
+
 /**
  Parameters specific to demo data creation mode.
 
@@ -83,6 +127,30 @@ struct CreateModeParameters {
   let common: CommonParameters
 }
 
+/**
+ Parameters specific to prefetch replay mode.
+
+ - datasetFilename: The BorgVR file the trace was recorded with.
+ - traceFilename: The pose trace written by the VisionApp.
+ - horizon: The number of seconds the planner extrapolates the view.
+ */
+struct ReplayModeParameters {
+  let datasetFilename: String
+  let traceFilename: String
+  let horizon: Double
+}
+
+/**
+ Parameters specific to self check mode.
+
+ - check: The selected check.
+ - arguments: The arguments passed on to the check.
+ */
+struct SelfCheckModeParameters {
+  let check: SelfCheck
+  let arguments: [String]
+}
+
 /// A usage error message displayed when invalid parameters are provided.
 let usageErrorMessage = """
 Invalid parameters.
@@ -112,6 +180,25 @@ Mode N — Read a NRRD or NHDR file
         max_brick_size    : Positive integer specifying the maximum brick size
         overlap           : Positive integer specifying the overlap between bricks
 
+Mode S — Read a stack of raw slice files (one file per z-slice) from a directory
+    (args[0]) S <input_directory> <byte_depth> <size_x> <size_y> <output_filename> <description> <max_brick_size> <overlap>
+        input_directory   : Path to the directory containing the slice files (sorted by name)
+        byte_depth        : Bytes per voxel (e.g., 1, 2)
+        size_x            : Slice size along X (positive integer)
+        size_y            : Slice size along Y (positive integer)
+        output_filename   : Name of the output file to create
+        description       : Short description of the dataset
+        max_brick_size    : Positive integer specifying the maximum brick size
+        overlap           : Positive integer specifying the overlap between bricks
+
+Mode R — Repack an existing BorgVR file with a new brick size and overlap (alias: repack)
+    (args[0]) R <input_filename> <output_filename> <description> <max_brick_size> <overlap>
+        input_filename    : Path to the existing BorgVR data file
+        output_filename   : Name of the output file to create
+        description       : Short description of the dataset ('-' keeps the original one)
+        max_brick_size    : Positive integer specifying the maximum brick size
+        overlap           : Positive integer specifying the overlap between bricks
+
 Mode C — Create a volume file using a specified algorithm
     (args[0]) C <L|F> <byte_depth> <component_count> <size_x> <size_y> <size_z> <output_filename> <description> <max_brick_size> <overlap>
         L or F            : Choose generation algorithm ('L' = linearly increasing, 'F' = Mandelbulb)
@@ -124,19 +211,101 @@ Mode C — Create a volume file using a specified algorithm
         description       : Short description of the dataset
         max_brick_size    : Positive integer specifying the maximum brick size
         overlap           : Positive integer specifying the overlap between bricks
+
+Mode P — Replay a recorded head pose trace through the prefetch planner
+    (args[0]) P <input_filename> <trace_filename> [horizon]
+        input_filename    : Path to the BorgVR data file the trace was recorded with
+        trace_filename    : Path to the pose trace (JSON Lines) recorded by the VisionApp
+        horizon           : Seconds to extrapolate the view (default 1.0)
+
+Mode T — Run a self check or benchmark
+    (args[0]) T <check> [arguments]
+\(selfCheckUsage)
+
+Options (all conversion modes, may appear anywhere after the mode)
+    --roi x0,y0,z0,x1,y1,z1   : Convert only the voxels in [x0,x1) x [y0,y1) x [z0,z1)
+    --start-level k           : Start the hierarchy at level k, i.e., decimate the source by 2^k
 """
 
 /**
- Parses command-line arguments and returns the selected mode along with associated parameters.
+ Removes the conversion options from the command-line arguments and parses them.
 
  - Parameter args: The array of command-line arguments.
+ - Returns: The remaining positional arguments and the parsed options.
+ - Note: This function exits the application if an option is malformed.
+ */
+func extractConversionOptions(_ args: [String]) -> ([String], ConversionOptions) {
+  var positional: [String] = []
+  var options = ConversionOptions()
+
+  var i = 0
+  while i < args.count {
+    switch args[i] {
+      case "--roi":
+        let values = i + 1 < args.count
+          ? args[i + 1].split(separator: ",").compactMap { Int($0) }
+          : []
+        guard values.count == 6,
+              values[0] >= 0, values[1] >= 0, values[2] >= 0,
+              values[0] < values[3], values[1] < values[4], values[2] < values[5] else {
+          logger.error("Error: --roi expects x0,y0,z0,x1,y1,z1 with 0 <= min < max.")
+          exit(1)
+        }
+        options.roiMin = Vec3<Int>(x: values[0], y: values[1], z: values[2])
+        options.roiMax = Vec3<Int>(x: values[3], y: values[4], z: values[5])
+        i += 2
+
+      case "--start-level":
+        guard i + 1 < args.count, let level = Int(args[i + 1]), (0..<31).contains(level) else {
+          logger.error("Error: --start-level expects a non-negative integer.")
+          exit(1)
+        }
+        options.startLevel = level
+        i += 2
+
+      default:
+        positional.append(args[i])
+        i += 1
+    }
+  }
+
+  return (positional, options)
+}
+
+/**
+ Wraps a volume according to the conversion options.
+
+ - Parameters:
+ - volume: The full source volume.
+ - options: The region of interest and start level to apply.
+ - Returns: `volume` itself if no options are set, otherwise a `SubVolumeAccessor` that only
+ reads the requested part of `volume`.
+ - Throws: `SubVolumeAccessor.Error` if the region does not fit the volume.
+ */
+func applyConversionOptions(_ options: ConversionOptions,
+                            to volume: VolumeDataAccessor) throws -> VolumeDataAccessor {
+  if options.isIdentity { return volume }
+
+  let subVolume = try SubVolumeAccessor(source: volume,
+                                        regionMin: options.roiMin,
+                                        regionMax: options.roiMax,
+                                        factor: 1 << options.startLevel)
+  logger.info("Converting \(subVolume.size) voxels of the \(volume.size) source volume.")
+  return subVolume
+}
+
+/**
+ Parses command-line arguments and returns the selected mode along with associated parameters.
+
+ - Parameter arguments: The array of command-line arguments, possibly including conversion options.
  - Returns: A tuple containing the selected `Mode` and its corresponding parameters (of type DModeParameters, QModeParameters, or CModeParameters).
  - Note: This function exits the application if the arguments are invalid.
  */
-func parseArguments(_ args: [String]) -> (Mode, Any) {
+func parseArguments(_ arguments: [String]) -> (Mode, Any) {
   var result: (Mode, Any)
+  let (args, options) = extractConversionOptions(arguments)
 
-  guard args.count >= 2, let mode = Mode(rawValue: args[1]) else {
+  guard args.count >= 2, let mode = Mode(rawValue: args[1] == "repack" ? "R" : args[1]) else {
     logger.error(usageErrorMessage)
     exit(1)
   }
@@ -160,14 +329,15 @@ func parseArguments(_ args: [String]) -> (Mode, Any) {
           outputFilename: args[3],
           datasetDescription: args[4],
           maxBrickSize: maxBrickSize,
-          overlap: overlap
+          overlap: overlap,
+          options: options
         )
       )
       result.1 = params
 
-    case .QVISConversion, .NRRDConversion:
+    case .QVISConversion, .NRRDConversion, .Repack:
       guard args.count == 7 else {
-        logger.error("Error: Invalid number of arguments for mode Q or N.\n\(usageErrorMessage)")
+        logger.error("Error: Invalid number of arguments for mode \(mode.rawValue).\n\(usageErrorMessage)")
         exit(1)
       }
       guard let maxBrickSize = Int(args[5]), maxBrickSize > 0,
@@ -181,7 +351,34 @@ func parseArguments(_ args: [String]) -> (Mode, Any) {
           outputFilename: args[3],
           datasetDescription: args[4],
           maxBrickSize: maxBrickSize,
-          overlap: overlap
+          overlap: overlap,
+          options: options
+        )
+      )
+      result.1 = params
+
+    case .SliceStackConversion:
+      guard args.count == 10,
+            let byteDepth = Int(args[3]), byteDepth > 0,
+            let sizeX = Int(args[4]), sizeX > 0,
+            let sizeY = Int(args[5]), sizeY > 0,
+            let maxBrickSize = Int(args[8]), maxBrickSize > 0,
+            let overlap = Int(args[9]), overlap > 0
+      else {
+        logger.error("Error: Invalid arguments for mode S.\n\(usageErrorMessage)")
+        exit(1)
+      }
+      let params = SliceStackModeParameters(
+        inputDirectory: args[2],
+        byteDepth: byteDepth,
+        sizeX: sizeX,
+        sizeY: sizeY,
+        common: CommonParameters(
+          outputFilename: args[6],
+          datasetDescription: args[7],
+          maxBrickSize: maxBrickSize,
+          overlap: overlap,
+          options: options
         )
       )
       result.1 = params
@@ -211,10 +408,31 @@ func parseArguments(_ args: [String]) -> (Mode, Any) {
           outputFilename: args[8],
           datasetDescription: args[9],
           maxBrickSize: maxBrickSize,
-          overlap: overlap
+          overlap: overlap,
+          options: options
         )
       )
       result.1 = params
+
+    case .PrefetchReplay:
+      guard args.count == 4 || args.count == 5 else {
+        logger.error("Error: Invalid number of arguments for mode P.\n\(usageErrorMessage)")
+        exit(1)
+      }
+      guard let horizon = args.count == 5 ? Double(args[4]) : 1.0, horizon >= 0 else {
+        logger.error("Error: horizon must be a non-negative number.")
+        exit(1)
+      }
+      result.1 = ReplayModeParameters(datasetFilename: args[2],
+                                      traceFilename: args[3],
+                                      horizon: horizon)
+
+    case .SelfCheck:
+      guard args.count >= 3, let check = selfChecks.first(where: { $0.name == args[2] }) else {
+        logger.error("Error: Unknown or missing check for mode T.\n\(usageErrorMessage)")
+        exit(1)
+      }
+      result.1 = SelfCheckModeParameters(check: check, arguments: Array(args.dropFirst(3)))
   }
 
   return result
@@ -235,6 +453,7 @@ func parseArguments(_ args: [String]) -> (Mode, Any) {
  - overlap: The overlap between adjacent bricks.
  - outputFilename: The name of the output file to create.
  - description: A short description of the dataset.
+ - options: An optional region of interest and start level.
  - Throws: An error if reading or reorganizing the volume fails.
  */
 func convertRawVolume(inputFilename: String,
@@ -246,8 +465,9 @@ func convertRawVolume(inputFilename: String,
                       overlap: Int,
                       outputFilename: String,
                       datasetDescription: String,
-                      metaDescription:String) throws {
-  let volume = try RawFileAccessor(
+                      metaDescription:String,
+                      options: ConversionOptions = ConversionOptions()) throws {
+  let rawVolume = try RawFileAccessor(
     filename: inputFilename,
     size: size,
     bytesPerComponent: bytesPerVoxel,
@@ -256,6 +476,7 @@ func convertRawVolume(inputFilename: String,
     offset: offset,
     readOnly: true
   )
+  let volume = try applyConversionOptions(options, to: rawVolume)
 
   // Create a reorganizer to partition the volume into bricks.
   let reorganizer = BrickedVolumeReorganizer(
@@ -324,7 +545,8 @@ func convertDICOMStack(_ params: DicomModeParameters) {
                          overlap: params.common.overlap,
                          outputFilename: params.common.outputFilename,
                          datasetDescription: params.common.datasetDescription,
-                         metaDescription:"")
+                         metaDescription:"",
+                         options: params.common.options)
 
     try FileManager.default.removeItem(at: tempURL)
   } catch {
@@ -358,7 +580,8 @@ func convertNRRDVolume(_ params: HeaderFileModeParameters) {
                          overlap: params.common.overlap,
                          outputFilename: params.common.outputFilename,
                          datasetDescription: params.common.datasetDescription,
-                         metaDescription: "")
+                         metaDescription: "",
+                         options: params.common.options)
 
     if parser.dataIsTempCopy {
       try FileManager.default.removeItem(at: URL(fileURLWithPath: parser.absoluteFilename))
@@ -395,7 +618,93 @@ func convertQVISVolume(_ params: HeaderFileModeParameters) {
                          overlap: params.common.overlap,
                          outputFilename: params.common.outputFilename,
                          datasetDescription: params.common.datasetDescription,
-                         metaDescription:"")
+                         metaDescription:"",
+                         options: params.common.options)
+  } catch {
+    logger.error("Error: \(error.localizedDescription)")
+    exit(1)
+  }
+}
+
+/**
+ Converts a directory of raw slice files into the BorgVR file format.
+
+ The slices are accessed in place through a `SliceStackAccessor`, so no concatenated
+ temporary copy of the volume is written.
+
+ - Parameter params: The parameters for slice stack conversion.
+ */
+func convertSliceStack(_ params: SliceStackModeParameters) {
+  do {
+    logger.info("Scanning directory for slice files...")
+
+    let stack = try SliceStackAccessor(
+      directory: params.inputDirectory,
+      width: params.sizeX,
+      height: params.sizeY,
+      bytesPerComponent: params.byteDepth,
+      componentCount: 1,
+      aspect: Vec3<Float>(x: 1, y: 1, z: 1)
+    )
+
+    logger.info("Found \(stack.size.z) slices. Converting slice stack to BorgVR file format ...")
+
+    let volume = try applyConversionOptions(params.common.options, to: stack)
+
+    let reorganizer = BrickedVolumeReorganizer(
+      inputVolume: volume,
+      brickSize: params.common.maxBrickSize,
+      overlap: params.common.overlap,
+      extensionStrategy: .fillZeroes
+    )
+    try reorganizer
+      .reorganize(
+        to: params.common.outputFilename,
+        datasetDescription: params.common.datasetDescription,
+        metaDescription: "",
+        useCompressor: true,
+        logger: logger
+      )
+  } catch {
+    logger.error("Error: \(error.localizedDescription)")
+    exit(1)
+  }
+}
+
+/**
+ Re-bricks an existing BorgVR file with new brick parameters.
+
+ The full-resolution level is read back from the bricks of the input file through a
+ `BrickedVolumeAccessor`, so the original source data is not needed. The coarser levels
+ are recomputed from it.
+
+ - Parameter params: The parameters for repacking.
+ */
+func repackVolume(_ params: HeaderFileModeParameters) {
+  do {
+    logger.info("Opening BorgVR file ...")
+
+    let bricked = try BrickedVolumeAccessor(filename: params.inputFilename)
+    logger.info("Repacking \(bricked) ...")
+
+    let volume = try applyConversionOptions(params.common.options, to: bricked)
+
+    let reorganizer = BrickedVolumeReorganizer(
+      inputVolume: volume,
+      brickSize: params.common.maxBrickSize,
+      overlap: params.common.overlap,
+      extensionStrategy: .fillZeroes
+    )
+    try reorganizer
+      .reorganize(
+        to: params.common.outputFilename,
+        datasetDescription: params.common.datasetDescription == "-"
+          ? bricked.datasetDescription
+          : params.common.datasetDescription,
+        metaDescription: bricked.metaDescription,
+        useCompressor: true,
+        logger: logger
+      )
   } catch {
     logger.error("Error: \(error.localizedDescription)")
     exit(1)
@@ -447,7 +756,8 @@ func generateVolume(_ params: CreateModeParameters) {
                          overlap: params.common.overlap,
                          outputFilename: params.common.outputFilename,
                          datasetDescription: params.common.datasetDescription,
-                         metaDescription:"")
+                         metaDescription:"",
+                         options: params.common.options)
 
     try FileManager.default.removeItem(at: tempURL)
   } catch {
@@ -456,6 +766,86 @@ func generateVolume(_ params: CreateModeParameters) {
   }
 }
 
+/**
+ Replays a recorded head pose trace through the prefetch planner and reports how many of the
+ bricks the renderer requested had been predicted before their first request.
+
+ Poses are fed to the planner in trace order and a plan is computed every `planInterval`
+ seconds of trace time, as in the VisionApp.
+
+ - Parameter params: The parameters for the replay.
+ */
+func replayPoseTrace(_ params: ReplayModeParameters) {
+  do {
+    let metadata = try BORGVRMetaData(filename: params.datasetFilename)
+    let entries = try PrefetchPlanner.readTrace(
+      from: URL(fileURLWithPath: params.traceFilename))
+    guard let parameters = entries.first?.parameters else {
+      logger.error("Error: The trace does not start with the LOD parameters.")
+      exit(1)
+    }
+
+    let planner = PrefetchPlanner(metadata: metadata, parameters: parameters,
+                                  horizon: params.horizon)
+    let planTimer = HighResolutionTimer()
+    var planSeconds = 0.0
+    var planCount = 0
+    var lastPlanTime = -Double.infinity
+    var predicted = Set<Int>()
+    var requested = Set<Int>()
+    var hits = 0
+
+    for entry in entries {
+      if let pose = entry.pose {
+        planner.record(pose)
+        if pose.time - lastPlanTime >= planner.planInterval {
+          planTimer.start()
+          predicted.formUnion(planner.plan(at: pose.time))
+          planSeconds += planTimer.stop()
+          planCount += 1
+          lastPlanTime = pose.time
+        }
+      }
+      for index in entry.requested ?? [] where requested.insert(index).inserted {
+        if predicted.contains(index) { hits += 1 }
+      }
+    }
+
+    guard planCount > 0 else {
+      logger.error("Error: The trace contains no poses.")
+      exit(1)
+    }
+    let hitRatio = requested.isEmpty ? 0 : Double(hits) / Double(requested.count)
+    let unused = predicted.subtracting(requested).count
+    logger.info("Replayed \(planCount) plans, \(String(format: "%.2f", planSeconds / Double(planCount) * 1000)) ms per plan")
+    logger.info("\(hits) of \(requested.count) requested bricks were predicted " +
+                "(\(String(format: "%.1f", hitRatio * 100)) %)")
+    logger.info("\(predicted.count) bricks predicted, \(unused) of them never requested")
+  } catch {
+    logger.error("Error: \(error.localizedDescription)")
+    exit(1)
+  }
+}
+
+/**
+ Runs a self check and exits with an error if it fails.
+
+ - Parameter params: The parameters for the check.
+ */
+func runSelfCheck(_ params: SelfCheckModeParameters) {
+  do {
+    if try params.check.run(params.arguments) {
+      logger.info("Check \(params.check.name) passed")
+    } else {
+      logger.error("Check \(params.check.name) failed")
+      exit(1)
+    }
+  } catch {
+    logger.error("Error: \(error.localizedDescription)")
+    exit(1)
+  }
+}
+
 let timer = HighResolutionTimer()
 timer.start()
 logger.setMinimumLogLevel(.info)
@@ -477,6 +867,18 @@ switch mode {
   case .NRRDConversion:
     guard let params = params as? HeaderFileModeParameters else { exit(1) }
     convertNRRDVolume(params)
+  case .SliceStackConversion:
+    guard let params = params as? SliceStackModeParameters else { exit(1) }
+    convertSliceStack(params)
+  case .Repack:
+    guard let params = params as? HeaderFileModeParameters else { exit(1) }
+    repackVolume(params)
+  case .PrefetchReplay:
+    guard let params = params as? ReplayModeParameters else { exit(1) }
+    replayPoseTrace(params)
+  case .SelfCheck:
+    guard let params = params as? SelfCheckModeParameters else { exit(1) }
+    runSelfCheck(params)
 }
 
 let total = timer.stop()
@@ -0,0 +1,107 @@
+import Foundation
+
+// Brick responses of a single protocol version 2 connection that are waiting
+// to be sent. Only a small window of responses is handed to the network stack
+// at a time, everything behind it stays in this queue where it can still be
+// reordered or dropped when the client's view changes.
+//
+// The queue is not synchronized, all calls must happen on the queue of the
+// connection it belongs to.
+final class BrickSendQueue {
+  struct Entry {
+    let requestID: UInt32
+    var priority: Int
+    let sequence: Int
+    let bricks: [BrickMetadata]
+    let totalSize: Int
+    let shared: SharedDataset
+  }
+
+  // Number of responses handed to the network stack at the same time
+  let window: Int
+
+  private var entries: [Entry] = []
+  private var nextSequence = 0
+  private(set) var inFlight = 0
+
+  var pendingCount: Int { entries.count }
+
+  init(window: Int = 2) {
+    self.window = max(1, window)
+  }
+
+  func enqueue(requestID: UInt32, priority: Int, bricks: [BrickMetadata], shared: SharedDataset) {
+    entries.append(Entry(requestID: requestID,
+                         priority: priority,
+                         sequence: nextSequence,
+                         bricks: bricks,
+                         totalSize: bricks.reduce(0) { $0 + $1.size },
+                         shared: shared))
+    nextSequence += 1
+  }
+
+  // Returns the most urgent entry (lowest priority value, oldest first) if
+  // the send window has room. The caller must call completed() once the
+  // network stack is done with it.
+  func popNext() -> Entry? {
+    guard inFlight < window, !entries.isEmpty else { return nil }
+    var best = 0
+    for i in 1..<entries.count {
+      let candidate = entries[i]
+      let current = entries[best]
+      if (candidate.priority, candidate.sequence) < (current.priority, current.sequence) {
+        best = i
+      }
+    }
+    inFlight += 1
+    return entries.remove(at: best)
+  }
+
+  func completed() {
+    inFlight = max(0, inFlight - 1)
+  }
+
+  // Drops the given requests, or all requests if the list is empty, and
+  // returns the IDs that were actually dropped.
+  func cancel(_ requestIDs: [UInt32]) -> [UInt32] {
+    let cancelAll = requestIDs.isEmpty
+    let ids = Set(requestIDs)
+    var cancelled: [UInt32] = []
+    entries.removeAll { entry in
+      guard cancelAll || ids.contains(entry.requestID) else { return false }
+      cancelled.append(entry.requestID)
+      return true
+    }
+    return cancelled
+  }
+
+  func reprioritize(_ priorities: [(requestID: UInt32, priority: Int)]) {
+    for update in priorities {
+      if let i = entries.firstIndex(where: { $0.requestID == update.requestID }) {
+        entries[i].priority = update.priority
+      }
+    }
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-
+ Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,105 @@
+import Foundation
+
+// An opened dataset that is shared by all connections working on it. The
+// metadata is parsed and the file is mapped only once, and the serialized
+// metadata sent in response to OPEN is built only once.
+final class SharedDataset {
+  let id: String
+  let dataset: BORGVRFileData
+  let metadataBlob: Data
+
+  init(id: String, filename: String) throws {
+    self.id = id
+    self.dataset = try BORGVRFileData(filename: filename)
+    self.metadataBlob = dataset.getMetadata().toData()
+  }
+}
+
+// Reference counted registry of the datasets currently opened by clients,
+// keyed by the dataset's unique ID. A dataset is closed as soon as the last
+// connection using it releases it.
+//
+// Opening a dataset maps the file and serializes its metadata, which can take
+// a while, so it happens outside the lock. The first OPEN of an ID inserts an
+// entry that later OPENs of the same ID wait on, so they still end up sharing
+// one mapping, while OPENs of other datasets and releases go ahead.
+final class DatasetRegistry {
+  // A dataset that is open or being opened by the connection that created the
+  // entry. Its fields are only accessed while holding `condition`.
+  private final class Entry {
+    var dataset: SharedDataset?
+    var error: Error?
+    var refCount = 1
+  }
+
+  private let condition = NSCondition()
+  private var entries: [String: Entry] = [:]
+
+  var openDatasetCount: Int {
+    condition.withLock { entries.values.filter { $0.dataset != nil }.count }
+  }
+
+  func acquire(_ info: DatasetInfo) throws -> SharedDataset {
+    condition.lock()
+    if let entry = entries[info.id] {
+      entry.refCount += 1
+      while entry.dataset == nil && entry.error == nil {
+        condition.wait()
+      }
+      condition.unlock()
+      if let error = entry.error { throw error }
+      return entry.dataset!
+    }
+    let entry = Entry()
+    entries[info.id] = entry
+    condition.unlock()
+
+    let result = Result { try SharedDataset(id: info.id, filename: info.filename) }
+
+    condition.lock()
+    defer { condition.unlock() }
+    switch result {
+      case .success(let dataset):
+        entry.dataset = dataset
+      case .failure(let error):
+        // Connections waiting for this entry fail as well; a later OPEN tries again.
+        entry.error = error
+        entries[info.id] = nil
+    }
+    condition.broadcast()
+    return try result.get()
+  }
+
+  func release(_ dataset: SharedDataset) {
+    condition.withLock {
+      guard let entry = entries[dataset.id], entry.dataset === dataset else { return }
+      if entry.refCount > 1 {
+        entry.refCount -= 1
+      } else {
+        entries[dataset.id] = nil
+      }
+    }
+  }
+}
+
+/*
+ Copyright (c) 2025 Computer Graphics and Visualization Group, University of Duisburg-
+ Essen
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ software and associated documentation files (the "Software"), to deal in the Software
+ without restriction, including without limitation the rights to use, copy, modify,
+ merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ permit persons to whom the Software is furnished to do so, subject to the following
+ conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies
+ or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -7,28 +7,51 @@ class TCPServer {
   let port: NWEndpoint.Port
   let queue = DispatchQueue(label: "TCPServerQueue")
   var listener: NWListener?
-  var activeConnections: [NWConnection] = []
   var isRunning = false
   var logger: LoggerBase?
 
+  // Every connection is served on its own serial queue. All of these queues
+  // target this concurrent pool, so GCD schedules the clients fairly across
+  // the available cores and one client pulling large batches no longer
+  // blocks the others.
+  private let workerPool = DispatchQueue(label: "TCPServerWorkerPool",
+                                         qos: .userInitiated,
+                                         attributes: .concurrent)
+  private var connectionCounter = 0
+
+  // Guards activeConnections and connectionDatasets, which are accessed
+  // from all connection queues.
+  private let stateLock = NSLock()
+  private var _activeConnections: [NWConnection] = []
+
+  var activeConnections: [NWConnection] {
+    stateLock.withLock { _activeConnections }
+  }
+
   // Maximum number of bricks allowed in a single GETBRICKS request
   let maxBricksPerGetRequest: Int
 
   /// Dataset list received from the GUI
   private var datasets: [DatasetInfo]
 
-  // Dataset and its reusable brick buffer for a single connection
+  // Datasets opened by any connection, shared between all connections
+  let registry = DatasetRegistry()
+
+  // Shared dataset opened by a single connection. The dataset is released
+  // back to the registry when the entry goes away.
   final class ConnectionDataset {
-    let dataset: BORGVRFileData
-    let buffer: UnsafeMutablePointer<UInt8>
+    let shared: SharedDataset
+    private let registry: DatasetRegistry
 
-    init(dataset: BORGVRFileData) {
-      self.dataset = dataset
-      self.buffer = dataset.allocateBrickBuffer()
+    var dataset: BORGVRFileData { shared.dataset }
+
+    init(shared: SharedDataset, registry: DatasetRegistry) {
+      self.shared = shared
+      self.registry = registry
     }
 
     deinit {
-      buffer.deallocate()
+      registry.release(shared)
     }
   }
 
@@ -63,28 +86,40 @@ class TCPServer {
 
   func stop() {
     listener?.cancel()
-    activeConnections.forEach { connection in
+    let connections = stateLock.withLock {
+      let connections = _activeConnections
+      _activeConnections.removeAll()
+      return connections
+    }
+    connections.forEach { connection in
       closeConnection(for: connection)
       connection.cancel()
     }
-    activeConnections.removeAll()
     isRunning = false
     logger?.info("Server stopped.")
   }
 
   private func handleNewConnection(_ connection: NWConnection) {
-    activeConnections.append(connection)
+    let connectionQueue = stateLock.withLock {
+      _activeConnections.append(connection)
+      connectionCounter += 1
+      return DispatchQueue(label: "TCPServerConnection\(connectionCounter)",
+                           target: workerPool)
+    }
 
     connection.stateUpdateHandler = { [weak self] state in
       switch state {
         case .cancelled, .waiting, .failed(_):
-          self?.closeConnection(for: connection)
-          self?.activeConnections.removeAll(where: { $0 === connection })
+          guard let self = self else { return }
+          self.closeConnection(for: connection)
+          self.stateLock.withLock {
+            self._activeConnections.removeAll(where: { $0 === connection })
+          }
         default:
           break
       }
     }
-    connection.start(queue: queue)
+    connection.start(queue: connectionQueue)
     receiveLine(on: connection, buffer: "")
   }
   
@@ -121,6 +156,20 @@ class TCPServer {
         let request = newBuffer[..<newlineRange.lowerBound].trimmingCharacters(in: .whitespacesAndNewlines)
         newBuffer = String(newBuffer[newlineRange.upperBound...])
 
+        if request == WireProtocol.switchCommand {
+          // The client waits for the acknowledgement before it sends any
+          // frame, so nothing may follow the switch command.
+          guard newBuffer.isEmpty,
+                self.connectionDataset(for: ObjectIdentifier(connection)) != nil else {
+            connection.cancel()
+            return
+          }
+          self.sendBinaryResponse(data: Data(WireProtocol.switchAcknowledgement.utf8),
+                                  connection: connection)
+          self.receiveFrame(on: connection, sendQueue: BrickSendQueue())
+          return
+        }
+
         if !self.processCommand(request, connection: connection) {
           connection.cancel()
           return
@@ -137,6 +186,144 @@ class TCPServer {
     }
   }
 
+  // MARK: - Wire protocol version 2
+
+  private func receiveExactly(_ count: Int, on connection: NWConnection,
+                              completion: @escaping (Data) -> Void) {
+    if count == 0 {
+      completion(Data())
+      return
+    }
+    connection.receive(minimumIncompleteLength: count, maximumLength: count) { [weak self] data, _, isComplete, error in
+      guard let self = self else { return }
+      if let error = error {
+        self.logger?.warning("Client disconnected with error: \(error)")
+        self.closeConnection(for: connection)
+        return
+      }
+      guard let data = data, data.count == count else {
+        if isComplete {
+          self.logger?.info("Client disconnected normally.")
+        }
+        self.closeConnection(for: connection)
+        connection.cancel()
+        return
+      }
+      completion(data)
+    }
+  }
+
+  private func receiveFrame(on connection: NWConnection, sendQueue: BrickSendQueue) {
+    receiveExactly(WireProtocol.FrameHeader.size, on: connection) { [weak self] headerData in
+      guard let self = self else { return }
+      let header: WireProtocol.FrameHeader
+      do {
+        header = try WireProtocol.FrameHeader(from: headerData)
+      } catch {
+        self.logger?.error("Closing connection: \(error.localizedDescription)")
+        connection.cancel()
+        return
+      }
+      self.receiveExactly(header.payloadLength, on: connection) { [weak self] payload in
+        guard let self = self else { return }
+        if self.processFrame(header, payload: payload, sendQueue: sendQueue, connection: connection) {
+          self.receiveFrame(on: connection, sendQueue: sendQueue)
+        } else {
+          connection.cancel()
+        }
+      }
+    }
+  }
+
+  private func processFrame(_ header: WireProtocol.FrameHeader, payload: Data,
+                            sendQueue: BrickSendQueue, connection: NWConnection) -> Bool {
+    switch header.type {
+      case .getBricks:
+        guard let datasetEntry = connectionDataset(for: ObjectIdentifier(connection)) else {
+          return false
+        }
+        let brickMetadata = datasetEntry.dataset.getMetadata().brickMetadata
+        let indices: [Int]
+        let priority: Int
+        do {
+          (indices, priority) = try WireProtocol.decodeGetBricks(payload,
+                                                                 maxCount: maxBricksPerGetRequest,
+                                                                 brickCount: brickMetadata.count)
+        } catch WireProtocol.Error.indexOutOfRange {
+          // A bad index only fails this request, the connection stays usable.
+          sendFrame(.error, requestID: header.requestID,
+                    payload: Data("Invalid brick index".utf8), connection: connection)
+          return true
+        } catch {
+          return false
+        }
+        guard !indices.isEmpty else { return false }
+        let bricks = indices.map { brickMetadata[$0] }
+        guard bricks.reduce(0, { $0 + $1.size }) <= WireProtocol.maxPayloadLength else {
+          sendFrame(.error, requestID: header.requestID,
+                    payload: Data("Response too large".utf8), connection: connection)
+          return true
+        }
+        sendQueue.enqueue(requestID: header.requestID, priority: priority,
+                          bricks: bricks, shared: datasetEntry.shared)
+        pumpSendQueue(sendQueue, connection: connection)
+        return true
+
+      case .cancel:
+        guard let requestIDs = try? WireProtocol.decodeCancel(payload) else { return false }
+        let cancelled = sendQueue.cancel(requestIDs)
+        for requestID in cancelled {
+          sendFrame(.cancelled, requestID: requestID, payload: Data(), connection: connection)
+        }
+        logger?.dev("Cancelled \(cancelled.count) pending brick requests")
+        return true
+
+      case .reprioritize:
+        guard let priorities = try? WireProtocol.decodeReprioritize(payload) else { return false }
+        sendQueue.reprioritize(priorities)
+        return true
+
+      default:
+        // Response types are never sent by clients.
+        return false
+    }
+  }
+
+  // Hands queued responses to the network stack until the send window is
+  // full. Runs again whenever a response has been processed, on the
+  // connection's queue like the frame handling itself.
+  private func pumpSendQueue(_ sendQueue: BrickSendQueue, connection: NWConnection) {
+    while let entry = sendQueue.popNext() {
+      // Requests are size checked when they arrive, so encoding cannot fail here.
+      guard let responseHeader = try? WireProtocol.FrameHeader(type: .bricks,
+                                                               requestID: entry.requestID,
+                                                               payloadLength: entry.totalSize).encode() else {
+        sendQueue.completed()
+        continue
+      }
+      sendBrickResponse(header: responseHeader, bricks: entry.bricks,
+                        shared: entry.shared, connection: connection) { [weak self] in
+        sendQueue.completed()
+        self?.pumpSendQueue(sendQueue, connection: connection)
+      }
+    }
+  }
+
+  private func sendFrame(_ type: WireProtocol.MessageType, requestID: UInt32, payload: Data,
+                         connection: NWConnection) {
+    guard let frame = try? WireProtocol.frame(type, requestID: requestID, payload: payload) else {
+      logger?.error("Failed to send frame: payload of \(payload.count) bytes is too large")
+      return
+    }
+    connection.send(content: frame, completion: .contentProcessed({ error in
+      if let error = error {
+        self.logger?.error("Failed to send frame: \(error)")
+      }
+    }))
+  }
+
+  // MARK: - Wire protocol version 1
+
   private func processCommand(_ command: String, connection: NWConnection) -> Bool {
     let components = command.split(separator: " ")
     guard let cmd = components.first else {
@@ -171,13 +358,12 @@ class TCPServer {
     }
 
     let connectionID = ObjectIdentifier(connection)
-    if connectionDatasets[connectionID] != nil {
+    if setConnectionDataset(nil, for: connectionID) != nil {
       logger?.info("Closing previous dataset for connection")
-      connectionDatasets[connectionID] = nil
     }
 
-    if let data = try? BORGVRFileData(filename: dataset.filename) {
-      connectionDatasets[connectionID] = ConnectionDataset(dataset: data)
+    if let shared = try? registry.acquire(dataset) {
+      setConnectionDataset(ConnectionDataset(shared: shared, registry: registry), for: connectionID)
 
       let filename = URL(fileURLWithPath: dataset.filename).lastPathComponent
       if case let .hostPort(host, _) = connection.endpoint {
@@ -186,8 +372,9 @@ class TCPServer {
       } else {
         logger?.info("Opened dataset \(filename) ID=\(connectionID.hashValue)")
       }
+      logger?.dev("Datasets open on the server: \(registry.openDatasetCount)")
 
-      sendBinaryResponse(data: data.getMetadata().toData(), connection: connection)
+      sendBinaryResponse(data: shared.metadataBlob, connection: connection)
       return true
     } else {
       logger?.error("Failed to open dataset \(idString)")
@@ -207,29 +394,44 @@ class TCPServer {
       return false
     }
 
-    let connectionID = ObjectIdentifier(connection)
-    guard let datasetEntry = connectionDatasets[connectionID] else {
+    guard let datasetEntry = connectionDataset(for: ObjectIdentifier(connection)) else {
       return false
     }
 
-    var totalSize = 0
-    for index in indices {
-      let brickMeta = datasetEntry.dataset.getMetadata().brickMetadata[index]
-      totalSize += brickMeta.size
+    let brickMetadata = datasetEntry.dataset.getMetadata().brickMetadata
+    guard indices.allSatisfy({ brickMetadata.indices.contains($0) }) else {
+      logger?.error("Invalid brick index in GETBRICKS request")
+      return false
     }
 
-    do {
-      var brickData = Data(capacity: totalSize)
-      for index in indices {
-        let brickMeta = datasetEntry.dataset.getMetadata().brickMetadata[index]
-        try datasetEntry.dataset.getRawBrick(brickMeta: brickMeta, outputBuffer: datasetEntry.buffer)
-        brickData.append(Data(bytes: datasetEntry.buffer, count: brickMeta.size))
+    let bricks = indices.map { brickMetadata[$0] }
+    let totalSize = bricks.reduce(0) { $0 + $1.size }
+    sendBrickResponse(header: Data(from: Int32(totalSize)), bricks: bricks,
+                      shared: datasetEntry.shared, connection: connection)
+    return true
+  }
+
+  // Sends the bricks straight from the memory-mapped file. Every brick becomes
+  // a no-copy Data that references the mapping and keeps the shared dataset
+  // alive until the network stack is done with it; the sends are batched so
+  // they leave as one contiguous response behind the given header.
+  private func sendBrickResponse(header: Data, bricks: [BrickMetadata],
+                                 shared: SharedDataset, connection: NWConnection,
+                                 completion: (() -> Void)? = nil) {
+    connection.batch {
+      connection.send(content: header, completion: .idempotent)
+      for brick in bricks where brick.size > 0 {
+        let content = Data(bytesNoCopy: shared.dataset.rawBrickPointer(brickMeta: brick),
+                           count: brick.size,
+                           deallocator: .custom({ _, _ in withExtendedLifetime(shared) {} }))
+        connection.send(content: content, completion: .idempotent)
       }
-      sendBinaryResponse(data: brickData, connection: connection)
-      return true
-    } catch {
-      logger?.error("Failed to get bricks: \(error)")
-      return false
+      connection.send(content: nil, completion: .contentProcessed({ error in
+        if let error = error {
+          self.logger?.error("Failed to send bricks: \(error)")
+        }
+        completion?()
+      }))
     }
   }
 
@@ -259,15 +461,31 @@ class TCPServer {
     let kv = KeyValuePairHandler()
     kv.set("VERSION",TCPServer.protocolVersionName)
     kv.set("MAX_BRICKS_PER_GET_REQUEST",maxBricksPerGetRequest)
+    kv.set(WireProtocol.infoKey, "1,\(WireProtocol.version)")
     let serverInfo = kv.synthesize() + "\n"
 
     connection.send(content: serverInfo.data(using: .utf8), completion: .contentProcessed({ _ in }))
     return true
   }
 
+  // The returned entry stays valid even if the connection closes concurrently,
+  // as the caller holds a strong reference to it.
+  private func connectionDataset(for connectionID: ObjectIdentifier) -> ConnectionDataset? {
+    stateLock.withLock { connectionDatasets[connectionID] }
+  }
+
+  @discardableResult
+  private func setConnectionDataset(_ entry: ConnectionDataset?,
+                                    for connectionID: ObjectIdentifier) -> ConnectionDataset? {
+    stateLock.withLock {
+      let previous = connectionDatasets[connectionID]
+      connectionDatasets[connectionID] = entry
+      return previous
+    }
+  }
+
   private func closeConnection(for connection: NWConnection) {
-    let connectionID = ObjectIdentifier(connection)
-    connectionDatasets[connectionID] = nil
+    setConnectionDataset(nil, for: ObjectIdentifier(connection))
   }
 }
 
@@ -108,8 +108,8 @@ class RuntimeAppModel {
 
   /// A flag indicating if mixed immersion style is enabled.
   var mixedImmersionStyle: Bool = true
-  /// The maximum number of buffers in the swap chain
-  let maxBuffersInFlight = 1
+  /// The maximum number of frames in flight, and of the per-frame buffers in rotation
+  let maxBuffersInFlight = 2
   /// Indicates whether multisampling should be used if available.
   let useMultisamplingIfAvailable = false
 
@@ -53,9 +53,16 @@ final class StoredAppModel: ObservableObject {
     "borderMode": "zeroes",
     "screenSpaceError": 1.0,
     "initialBricks": 4000,
+    "warmStartAtlas": true,
     "minHashTableSize": 16,
     "maxProbingAttempts": 32,
     "atlasSizeMB": 1500,
+    "quantizeAtlas": false,
+    "pagingBudgetBricks": 64,
+    "pagingBudgetMB": 16,
+    "pagingBudgetMicroseconds": 4000,
+    "evictionReservedLevels": 2,
+    "evictionReservedPages": 256,
     "oversampling": 1.0,
     "oversamplingMode": OversamplingMode.dynamicMode.rawValue,
     "dropFPS": 20,
@@ -65,6 +72,7 @@ final class StoredAppModel: ObservableObject {
     "disableFoveation": false,
     "requestLowResLOD": true,
     "stopOnMiss": false,
+    "recordPoseTrace": false,
     "showProfiling": false,
     "showNotifications": false,
     "enableVoiceInput": false,
@@ -103,12 +111,26 @@ final class StoredAppModel: ObservableObject {
   @AppStorage("screenSpaceError") var screenSpaceError: Double = StoredAppModel.double("screenSpaceError")
   /// Initial number of bricks to load.
   @AppStorage("initialBricks") var initialBricks: Int = StoredAppModel.int("initialBricks")
+  /// Whether the resident bricks are saved on close and paged in when the dataset is reopened.
+  @AppStorage("warmStartAtlas") var warmStartAtlas: Bool = StoredAppModel.bool("warmStartAtlas")
   /// Minimum size (in MB) of the the bricks represented be the internal hash table.
   @AppStorage("minHashTableSize") var minHashTableSize: Int = StoredAppModel.int("minHashTableSize")
   ///  Maximum linear probing attempts in the hash table before giving up
   @AppStorage("maxProbingAttempts") var maxProbingAttempts: Int = StoredAppModel.int("maxProbingAttempts")
   /// Size of the texture atlas in megabytes.
   @AppStorage("atlasSizeMB") var atlasSizeMB: Int = StoredAppModel.int("atlasSizeMB")
+  /// Whether 16-bit data is stored as 8 bits with a per-brick range in the atlas.
+  @AppStorage("quantizeAtlas") var quantizeAtlas: Bool = StoredAppModel.bool("quantizeAtlas")
+  /// Maximum number of bricks copied into the atlas per frame.
+  @AppStorage("pagingBudgetBricks") var pagingBudgetBricks: Int = StoredAppModel.int("pagingBudgetBricks")
+  /// Maximum amount of brick data (in MB) copied into the atlas per frame.
+  @AppStorage("pagingBudgetMB") var pagingBudgetMB: Int = StoredAppModel.int("pagingBudgetMB")
+  /// Maximum time (in microseconds) spent paging bricks into the atlas per frame.
+  @AppStorage("pagingBudgetMicroseconds") var pagingBudgetMicroseconds: Int = StoredAppModel.int("pagingBudgetMicroseconds")
+  /// Number of coarsest levels whose bricks are protected from eviction by finer bricks.
+  @AppStorage("evictionReservedLevels") var evictionReservedLevels: Int = StoredAppModel.int("evictionReservedLevels")
+  /// Number of atlas pages reserved for bricks of the protected levels.
+  @AppStorage("evictionReservedPages") var evictionReservedPages: Int = StoredAppModel.int("evictionReservedPages")
   /// The oversampling factor for rendering.
   @AppStorage("oversampling") var oversampling: Double = StoredAppModel.double("oversampling")
   /// The oversampling mode ("static" or "dynamic").
@@ -127,6 +149,8 @@ final class StoredAppModel: ObservableObject {
   @AppStorage("requestLowResLOD") var requestLowResLOD: Bool = StoredAppModel.bool("requestLowResLOD")
   /// Whether the raycaster should terminate if a brick is missing
   @AppStorage("stopOnMiss") var stopOnMiss: Bool = StoredAppModel.bool("stopOnMiss")
+  /// Whether head poses and brick requests are written to a trace file for offline analysis
+  @AppStorage("recordPoseTrace") var recordPoseTrace: Bool = StoredAppModel.bool("recordPoseTrace")
   /// Whether the Profiling Button should be displayed
   @AppStorage("showProfiling") var showProfiling: Bool = StoredAppModel.bool("showProfiling")
   /// Whether the app displays notifictaions of background events
@@ -21,11 +21,14 @@ uint simpleHash(uint value) {
  Reports a missing brick by inserting its index into a GPU-side atomic hash table.
 
  Uses atomic compare-and-swap with linear probing to handle collisions,
- retrying up to MAX_PROBING_ATTEMPTS times.
+ retrying up to MAX_PROBING_ATTEMPTS times. The table is followed by one counter per slot
+ that counts the reports of the brick in that slot, which approximates how much of the
+ screen needs the brick.
 
  - Parameters:
  - brickIndex: The index of the missing brick to record.
- - atomicBuffer: A device pointer to an array of `atomic_uint` representing the hash table.
+ - atomicBuffer: A device pointer to an array of `atomic_uint` representing the hash table,
+ followed by HASHTABLE_SIZE counters.
  */
 void reportMissingBrick(uint brickIndex, device atomic_uint* atomicBuffer) {
   // Compute the initial hash slot index using modulo table size.
@@ -43,9 +46,11 @@ void reportMissingBrick(uint brickIndex, device atomic_uint* atomicBuffer) {
                                               memory_order_relaxed,
                                               memory_order_relaxed)) {
       // Successfully stored the brickIndex.
+      atomic_fetch_add_explicit(&atomicBuffer[HASHTABLE_SIZE + slot], 1u, memory_order_relaxed);
       break;
     } else if (expected == brickIndex) {
-      // The brickIndex is already present in this slot; no further action needed.
+      // The brickIndex is already present in this slot; only count the report.
+      atomic_fetch_add_explicit(&atomicBuffer[HASHTABLE_SIZE + slot], 1u, memory_order_relaxed);
       break;
     }
     // Otherwise, continue probing the next slot.
@@ -1,90 +1,165 @@
+import Foundation
 import Metal
 
 /**
- A GPU-based hashtable implemented via a Metal buffer for atomic updates in shaders.
-
- GPUHashtable creates a shared storage buffer initialized to all 0xFF values
- (indicating empty slots), provides methods to bind the buffer to a shader,
- retrieve and reset the hashtable contents, and query its size.
+ A GPU-based hashtable implemented via Metal buffers for atomic updates in shaders.
+
+ GPUHashtable creates one shared storage buffer per frame in flight, initialized to all
+ 0xFF values (indicating empty slots). Behind the slots, each buffer holds a counter per
+ slot with the number of times its brick was reported.
+
+ The buffers are used round robin by `frames`: `bind` binds the buffer of the current frame
+ and `readBack(after:)` reads that buffer on the command buffer's completion handler, so the
+ render thread never waits for the GPU. The entries of all frames completed since the last
+ call are collected with `takeEntries()`. A buffer is only bound again once the frame that
+ used it has completed, which the caller guarantees by keeping at most `bufferCount`
+ frames in flight. The completion handler also reports the frame to `frames`, so other
+ per-frame resources, such as the atlas pages, can be fenced on it.
  */
 class GPUHashtable {
+  /// A brick reported as missing, with the number of times it was reported.
+  struct Entry {
+    let brickID: UInt32
+    let hits: UInt32
+  }
+
   /// The size of the hashtable (number of buckets), always aligned to 64.
   private var tableSize: Int
-  /// A Metal buffer used for atomic operations on the GPU.
-  private var atomicBuffer: MTLBuffer
+  /// The Metal buffers used for atomic operations on the GPU, one per frame in flight.
+  private var atomicBuffers: [MTLBuffer]
+  /// The frames in flight; its slot selects the buffer of the current frame.
+  let frames: FrameRing
+
+  /// Protects `completedHits`, which the completion handlers write.
+  private let completedLock = NSLock()
+  /// The hits per brick of all frames that completed since the last `takeEntries` call.
+  private var completedHits: [UInt32: UInt32] = [:]
 
   /// The number of buckets in the hashtable.
   var size: Int {
     tableSize
   }
 
+  /// The number of buffers, i.e. the maximum number of frames in flight.
+  var bufferCount: Int {
+    atomicBuffers.count
+  }
+
   /**
    Initializes a new GPUHashtable with a minimum table size, aligned to 64 entries.
 
    - Parameters:
    - minTableElementCount: The minimum desired number of buckets.
-   - device: The `MTLDevice` used to create the underlying Metal buffer.
+   - bufferCount: The number of buffers, which must be at least the number of frames in
+   flight.
+   - device: The `MTLDevice` used to create the underlying Metal buffers.
    - Note: The actual table size will be rounded up to the next multiple of 64.
    - logger: An optional logger.
    */
-  init(minTableElementCount: Int, device: MTLDevice, logger: LoggerBase? = nil) {
+  init(minTableElementCount: Int, bufferCount: Int = 1, device: MTLDevice,
+       logger: LoggerBase? = nil) {
     // Align the table size to a multiple of 64 for optimal GPU atomic operations.
     self.tableSize = (minTableElementCount + 63) & -64
     if self.tableSize != minTableElementCount {
       logger?.dev("Requested table size of \(minTableElementCount) elements rounded up to \(tableSize).")
     }
 
-    // Compute the total buffer size in bytes.
-    let bufferSize = tableSize * MemoryLayout<UInt32>.stride
+    // Compute the size of each buffer in bytes, for the slots and their counters.
+    let bufferSize = 2 * tableSize * MemoryLayout<UInt32>.stride
 
-    // Create a shared buffer for CPU/GPU access.
-    guard let buffer = device.makeBuffer(length: bufferSize, options: [.storageModeShared]) else {
-      fatalError("Failed to create Metal buffer for GPUHashtable.")
+    // Create shared buffers for CPU/GPU access.
+    self.atomicBuffers = (0..<max(1, bufferCount)).map { _ in
+      guard let buffer = device.makeBuffer(length: bufferSize, options: [.storageModeShared]) else {
+        fatalError("Failed to create Metal buffer for GPUHashtable.")
+      }
+      return buffer
     }
-    self.atomicBuffer = buffer
+    self.frames = FrameRing(slotCount: atomicBuffers.count)
 
-    // Initialize all entries to 0xFF (UInt32.max) indicating empty slots.
-    memset(atomicBuffer.contents(), 0xFF, bufferSize)
+    for buffer in atomicBuffers {
+      reset(buffer)
+    }
+  }
+
+  /**
+   Marks all slots of a buffer as empty (0xFF) and sets all counters to zero.
+
+   - Parameter buffer: The buffer to reset.
+   */
+  private func reset(_ buffer: MTLBuffer) {
+    let slotBytes = tableSize * MemoryLayout<UInt32>.stride
+    memset(buffer.contents(), 0xFF, slotBytes)
+    memset(buffer.contents() + slotBytes, 0, slotBytes)
   }
 
   /**
-   Binds the hashtable buffer to the given fragment shader argument index.
+   Binds the buffer of the current frame to the given fragment shader argument index.
 
    - Parameters:
    - encoder: The `MTLRenderCommandEncoder` used for encoding draw calls.
    - index: The fragment shader buffer index at which to bind the hashtable.
    */
   func bind(to encoder: MTLRenderCommandEncoder, index: Int) {
-    encoder.setFragmentBuffer(atomicBuffer, offset: 0, index: index)
+    assert(frames.currentSlotIsFree, "GPUHashtable buffer bound while its last frame is in flight")
+    encoder.setFragmentBuffer(atomicBuffers[frames.currentSlot], offset: 0, index: index)
   }
 
   /**
-   Retrieves the current hashtable values after GPU execution, then resets the buffer.
+   Schedules the read back of the current frame's buffer and advances to the next buffer.
 
-   This method waits for the provided command buffer to complete,
-   reads back all non-empty entries (those not equal to `UInt32.max`),
-   clears the buffer to `UInt32.max` for the next frame, and returns the values.
+   Once the command buffer has completed, its completion handler collects all non-empty
+   entries (those not equal to `UInt32.max`) with their report counts, clears the buffer
+   for its next use and reports the frame as completed to `frames`. Must be called once per
+   frame, before the command buffer is committed.
 
-   - Parameter commandBuffer: The `MTLCommandBuffer` whose execution must complete before reading back data.
-   - Returns: An array of `UInt32` containing all valid hashtable entries.
+   - Parameters:
+   - commandBuffer: The `MTLCommandBuffer` of the current frame.
+   - completion: Called on the completion handler after the buffer has been reset, e.g.
+   to release the frame's in-flight slot.
    */
-  func getValues(from commandBuffer: MTLCommandBuffer) -> [UInt32] {
-    // Ensure GPU work is finished before reading.
-    commandBuffer.waitUntilCompleted()
+  func readBack(after commandBuffer: MTLCommandBuffer, completion: (() -> Void)? = nil) {
+    let (frame, slot) = frames.submit()
+    let buffer = atomicBuffers[slot]
+    commandBuffer.addCompletedHandler { [weak self, frames] _ in
+      self?.collect(from: buffer)
+      frames.complete(frame)
+      completion?()
+    }
+  }
 
+  /**
+   Adds the occupied slots of a completed buffer to `completedHits`, then resets it.
+
+   - Parameter buffer: The buffer of a completed frame.
+   */
+  private func collect(from buffer: MTLBuffer) {
     // Bind the buffer contents to a UInt32 pointer.
-    let pointer = atomicBuffer.contents().bindMemory(to: UInt32.self, capacity: tableSize)
+    let pointer = buffer.contents().bindMemory(to: UInt32.self, capacity: 2 * tableSize)
 
-    // Copy the contents into a Swift array.
-    var hashTableValues = Array(UnsafeBufferPointer(start: pointer, count: tableSize))
-    // Remove sentinel values (UInt32.max) indicating empty buckets.
-    hashTableValues.removeAll { $0 == UInt32.max }
+    completedLock.lock()
+    // Collect the occupied slots, skipping the sentinel values (UInt32.max).
+    for slot in 0..<tableSize where pointer[slot] != UInt32.max {
+      completedHits[pointer[slot], default: 0] &+= pointer[tableSize + slot]
+    }
+    completedLock.unlock()
+
+    // Reset the buffer for the next use.
+    reset(buffer)
+  }
 
-    // Reset the buffer back to all 0xFF for the next use.
-    let bufferSize = atomicBuffer.length
-    memset(atomicBuffer.contents(), 0xFF, bufferSize)
+  /**
+   Returns the bricks reported as missing by all frames that completed since the last call.
+   A brick reported by several frames is returned once, with the sum of its report counts.
+
+   - Returns: The bricks reported as missing, with their report counts.
+   */
+  func takeEntries() -> [Entry] {
+    completedLock.lock()
+    let hits = completedHits
+    completedHits.removeAll(keepingCapacity: true)
+    completedLock.unlock()
 
-    return hashTableValues
+    return hits.map { Entry(brickID: $0.key, hits: $0.value) }
   }
 }
 
@@ -192,6 +192,8 @@ float3 computeNormal(
  - vRayDir: The ray direction vector.
  - vCurrentPos: The current intersection estimate.
  - fIsoval: The isovalue threshold.
+ - valueRange: The scale and bias of the brick's page that map sampled values back to the
+ normalized data range, (1, 0) unless the atlas holds quantized bricks.
  - volume: The 3D volume texture.
  - s: The sampler state.
  - Returns: A refined intersection point closer to the isosurface.
@@ -200,6 +202,7 @@ inline float3 refineIsosurface(
                                float3 vRayDir,
                                float3 vCurrentPos,
                                float fIsoval,
+                               float2 valueRange,
                                texture3d<half, access::sample> volume [[texture(0)]],
                                sampler s
                                ) {
@@ -207,7 +210,7 @@ inline float3 refineIsosurface(
   vCurrentPos -= vRayDir;
   for (int i = 0; i < 5; i++) {
     vRayDir /= 2.0;
-    float voxel = volume.sample(s, vCurrentPos).x;
+    float voxel = fma(float(volume.sample(s, vCurrentPos).x), valueRange.x, valueRange.y);
     if (voxel >= fIsoval) {
       vCurrentPos -= vRayDir;
     } else {
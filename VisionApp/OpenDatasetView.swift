@@ -362,8 +362,8 @@ To add datasets, you have two options:
           logger: runtimeAppModel.logger,
           notifier: runtimeAppModel.notifier
         )
-        try manager.connect(timeout: storedAppModel.timeout)
-        let remoteDatasets = try manager.requestDatasetList()
+        try await manager.connect(timeout: storedAppModel.timeout)
+        let remoteDatasets = try await manager.requestDatasetList()
         for dataset in remoteDatasets {
           datasets.append(RuntimeAppModel.DatasetEntry(
             identifier: dataset.id,
@@ -29,6 +29,15 @@ struct SettingsView: View {
 
   @State private var tempAtlasSize: String = ""
   @State private var atlasErrorMsg: String?
+
+  @State private var tempPagingBricks: String = ""
+  @State private var tempPagingMB: String = ""
+  @State private var tempPagingMicroseconds: String = ""
+  @State private var pagingBudgetErrorMsg: String?
+
+  @State private var tempReservedLevels: String = ""
+  @State private var tempReservedPages: String = ""
+  @State private var reservedErrorMsg: String?
   
   @State private var tempOversampling: String = ""
   @State private var oversamplingErrorMsg: String?
@@ -237,6 +246,10 @@ struct SettingsView: View {
             if let error = bricksErrorMsg {
               Text(error).foregroundColor(.red).font(.caption)
             }
+            Toggle(
+              "Restore the bricks of the last session",
+              isOn: $storedAppModel.warmStartAtlas
+            )
             
             HStack {
               Text("Size of Bricks represented by the Hash Table (MB)")
@@ -279,6 +292,68 @@ struct SettingsView: View {
             if let error = atlasErrorMsg {
               Text(error).foregroundColor(.red).font(.caption)
             }
+            Toggle(
+              "Store 16-bit data as 8-bit in the atlas",
+              isOn: $storedAppModel.quantizeAtlas
+            )
+
+            HStack {
+              Text("Bricks paged in per Frame")
+              Spacer()
+              TextField("Brick count", text: $tempPagingBricks, onCommit: validatePagingBudget)
+                .onChange(of: tempPagingBricks) { validatePagingBudget() }
+                .textFieldStyle(RoundedBorderTextFieldStyle())
+                .keyboardType(.numberPad)
+                .frame(width: 100)
+                .onAppear { tempPagingBricks = String(storedAppModel.pagingBudgetBricks) }
+            }
+            HStack {
+              Text("Data paged in per Frame (MB)")
+              Spacer()
+              TextField("Size", text: $tempPagingMB, onCommit: validatePagingBudget)
+                .onChange(of: tempPagingMB) { validatePagingBudget() }
+                .textFieldStyle(RoundedBorderTextFieldStyle())
+                .keyboardType(.numberPad)
+                .frame(width: 100)
+                .onAppear { tempPagingMB = String(storedAppModel.pagingBudgetMB) }
+            }
+            HStack {
+              Text("Paging Time per Frame (µs)")
+              Spacer()
+              TextField("Time", text: $tempPagingMicroseconds, onCommit: validatePagingBudget)
+                .onChange(of: tempPagingMicroseconds) { validatePagingBudget() }
+                .textFieldStyle(RoundedBorderTextFieldStyle())
+                .keyboardType(.numberPad)
+                .frame(width: 100)
+                .onAppear { tempPagingMicroseconds = String(storedAppModel.pagingBudgetMicroseconds) }
+            }
+            if let error = pagingBudgetErrorMsg {
+              Text(error).foregroundColor(.red).font(.caption)
+            }
+
+            HStack {
+              Text("Protected Coarse Levels")
+              Spacer()
+              TextField("Level count", text: $tempReservedLevels, onCommit: validateReservedPages)
+                .onChange(of: tempReservedLevels) { validateReservedPages() }
+                .textFieldStyle(RoundedBorderTextFieldStyle())
+                .keyboardType(.numberPad)
+                .frame(width: 100)
+                .onAppear { tempReservedLevels = String(storedAppModel.evictionReservedLevels) }
+            }
+            HStack {
+              Text("Pages reserved for Coarse Levels")
+              Spacer()
+              TextField("Page count", text: $tempReservedPages, onCommit: validateReservedPages)
+                .onChange(of: tempReservedPages) { validateReservedPages() }
+                .textFieldStyle(RoundedBorderTextFieldStyle())
+                .keyboardType(.numberPad)
+                .frame(width: 100)
+                .onAppear { tempReservedPages = String(storedAppModel.evictionReservedPages) }
+            }
+            if let error = reservedErrorMsg {
+              Text(error).foregroundColor(.red).font(.caption)
+            }
 
             Toggle(
               "Request Low Res LOD",
@@ -288,6 +363,10 @@ struct SettingsView: View {
               "Stop raycasting when a missing brick is hit",
               isOn: $storedAppModel.stopOnMiss
             )
+            Toggle(
+              "Record head pose traces of remote datasets",
+              isOn: $storedAppModel.recordPoseTrace
+            )
             Toggle(
               "Show Profiling Options",
               isOn: $storedAppModel.showProfiling
@@ -402,7 +481,7 @@ struct SettingsView: View {
         logger:nil,
         notifier: nil
       )
-      try manager.connect(timeout: storedAppModel.timeout)
+      try await manager.connect(timeout: storedAppModel.timeout)
     } catch {
       await MainActor.run {connectionValid = false}
       return
@@ -458,6 +537,30 @@ struct SettingsView: View {
     }
   }
   
+  private func validatePagingBudget() {
+    if let bricks = Int(tempPagingBricks), bricks >= 1,
+       let megabytes = Int(tempPagingMB), megabytes >= 1,
+       let microseconds = Int(tempPagingMicroseconds), microseconds >= 1 {
+      storedAppModel.pagingBudgetBricks = bricks
+      storedAppModel.pagingBudgetMB = megabytes
+      storedAppModel.pagingBudgetMicroseconds = microseconds
+      pagingBudgetErrorMsg = nil
+    } else {
+      pagingBudgetErrorMsg = "Invalid value. Must be an integer of at least 1."
+    }
+  }
+
+  private func validateReservedPages() {
+    if let levels = Int(tempReservedLevels), levels >= 0,
+       let pages = Int(tempReservedPages), pages >= 0 {
+      storedAppModel.evictionReservedLevels = levels
+      storedAppModel.evictionReservedPages = pages
+      reservedErrorMsg = nil
+    } else {
+      reservedErrorMsg = "Invalid value. Must be an integer of at least 0."
+    }
+  }
+
   private func validateOversampling() {
     tempOversampling = tempOversampling.replacingOccurrences(of: ",", with: ".")
     if let value = Double(tempOversampling), value > 0 {
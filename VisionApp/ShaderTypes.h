@@ -37,6 +37,9 @@ typedef NSInteger EnumBackingType;
 #define STOP_ON_MISS 0                      ///< Whether the raycaster should terminate if a brick is missing
 #endif
 
+/// Number of consecutive bricks per leaf of the brick metadata directory.
+#define BRICK_LEAF_SIZE 1024
+
 /**
  BrickIDFlags:
  Flags indicating the page state of a brick in the volume cache.
@@ -72,8 +75,9 @@ typedef NS_ENUM(EnumBackingType, FragmentBufferIndex)
 {
   FragmentBufferIndexUniforms   = 0,  ///< Buffer containing fragment uniforms.
   FragmentBufferIndexLevelTable = 1,  ///< Buffer containing LOD level information.
-  FragmentBufferIndexBrickMeta  = 2,  ///< Buffer containing per-brick metadata.
-  FragmentBufferIndexHashTable  = 3   ///< Buffer used as the GPU-side hash table.
+  FragmentBufferIndexBrickMeta  = 2,  ///< Buffer containing the per-brick metadata directory.
+  FragmentBufferIndexHashTable  = 3,  ///< Buffer used as the GPU-side hash table.
+  FragmentBufferIndexPageRanges = 4   ///< Buffer containing the value scale and bias per atlas page.
 };
 
 /**
@@ -63,6 +63,7 @@ vertex VertexToFragment vertexShader(
  - levelData: Buffer containing LOD level metadata.
  - brickMeta: Buffer containing per-brick metadata.
  - hashBuffer: Atomic hash table buffer for missing-brick tracking.
+ - pageRanges: Buffer containing the value scale and bias of each atlas page.
  - Returns: The accumulated RGBA color after compositing along the ray.
  */
 fragment half4 fragmentShaderTF(
@@ -73,7 +74,8 @@ fragment half4 fragmentShaderTF(
                                 device const FragmentUniformsArray& uniformsArray [[buffer(FragmentBufferIndexUniforms)]],
                                 device const LevelData* levelData                [[buffer(FragmentBufferIndexLevelTable)]],
                                 device const uint* brickMeta                     [[buffer(FragmentBufferIndexBrickMeta)]],
-                                device atomic_uint* hashBuffer                   [[buffer(FragmentBufferIndexHashTable)]]
+                                device atomic_uint* hashBuffer                   [[buffer(FragmentBufferIndexHashTable)]],
+                                device const float2* pageRanges                  [[buffer(FragmentBufferIndexPageRanges)]]
                                 ) {
   FragmentUniforms uniforms = uniformsArray.uniforms[amp_id];
   constexpr sampler s(address::clamp_to_border, filter::linear);
@@ -136,7 +138,8 @@ fragment half4 fragmentShaderTF(
                                 brickResult.poolBrickInfo.poolExitCoords,
                                 i / float(iSteps)
                                 );
-        float volumeValue = volumeAtlas.sample(s, poolCoords).r;
+        float volumeValue = reconstructValue(volumeAtlas.sample(s, poolCoords).r,
+                                             brickResult.page, pageRanges);
         half4 current = transferFunc.sample(s, volumeValue * uniforms.transferBias);
         // Opacity correction
         current.a = 1.0 - pow(1.0 - current.a, ocFactor);
@@ -172,6 +175,7 @@ fragment half4 fragmentShaderTF(
  - levelData: Buffer containing LOD level metadata.
  - brickMeta: Buffer containing per-brick metadata.
  - hashBuffer: Atomic hash table buffer for missing-brick tracking.
+ - pageRanges: Buffer containing the value scale and bias of each atlas page.
  - Returns: The accumulated RGBA color after compositing along the ray.
  */
 fragment half4 fragmentShaderTFLighting(
@@ -182,7 +186,8 @@ fragment half4 fragmentShaderTFLighting(
                                 device const FragmentUniformsArray& uniformsArray [[buffer(FragmentBufferIndexUniforms)]],
                                 device const LevelData* levelData                [[buffer(FragmentBufferIndexLevelTable)]],
                                 device const uint* brickMeta                   [[buffer(FragmentBufferIndexBrickMeta)]],
-                                device atomic_uint* hashBuffer                   [[buffer(FragmentBufferIndexHashTable)]]
+                                device atomic_uint* hashBuffer                   [[buffer(FragmentBufferIndexHashTable)]],
+                                device const float2* pageRanges                  [[buffer(FragmentBufferIndexPageRanges)]]
                                 ) {
   FragmentUniforms uniforms = uniformsArray.uniforms[amp_id];
   constexpr sampler s(address::clamp_to_border, filter::linear);
@@ -245,7 +250,8 @@ fragment half4 fragmentShaderTFLighting(
                                 brickResult.poolBrickInfo.poolExitCoords,
                                 i / float(iSteps)
                                 );
-        float volumeValue = volumeAtlas.sample(s, poolCoords).r;
+        float volumeValue = reconstructValue(volumeAtlas.sample(s, poolCoords).r,
+                                             brickResult.page, pageRanges);
         half4 current = transferFunc.sample(s, volumeValue * uniforms.transferBias);
         // Opacity correction
         current.a = 1.0 - pow(1.0 - current.a, ocFactor);
@@ -298,7 +304,8 @@ fragment half4 fragmentShaderIso(
                                  device const FragmentUniformsArray& uniformsArray [[buffer(FragmentBufferIndexUniforms)]],
                                  device const LevelData* levelData                 [[buffer(FragmentBufferIndexLevelTable)]],
                                  device const uint* brickMeta                    [[buffer(FragmentBufferIndexBrickMeta)]],
-                                 device atomic_uint* hashBuffer                    [[buffer(FragmentBufferIndexHashTable)]]
+                                 device atomic_uint* hashBuffer                    [[buffer(FragmentBufferIndexHashTable)]],
+                                 device const float2* pageRanges                   [[buffer(FragmentBufferIndexPageRanges)]]
                                  ) {
   FragmentUniforms uniforms = uniformsArray.uniforms[amp_id];
   constexpr sampler s(address::clamp_to_border, filter::linear);
@@ -349,12 +356,14 @@ fragment half4 fragmentShaderIso(
                                 brickResult.poolBrickInfo.poolExitCoords,
                                 i / float(iSteps)
                                 );
-        float value = volumeAtlas.sample(s, poolCoords).r;
+        float value = reconstructValue(volumeAtlas.sample(s, poolCoords).r,
+                                       brickResult.page, pageRanges);
         if (value >= uniforms.isoValue) {
           poolCoords = refineIsosurface(
                                         voxelSpaceDirection,
                                         poolCoords,
                                         uniforms.isoValue,
+                                        pageRanges[brickResult.page],
                                         volumeAtlas,
                                         s
                                         );
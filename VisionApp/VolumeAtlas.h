@@ -13,6 +13,17 @@ uint getBrickIndex(uint4 brickCoords, device const LevelData *levelArray) {
          brickCoords.z * level.bricksXTimesBricksY;
 }
 
+/**
+ Looks up the metadata of a brick in the two-level brick directory. The directory holds
+ one entry per BRICK_LEAF_SIZE bricks, which is either a flag shared by all of them or
+ BI_FLAG_COUNT plus the offset of the leaf holding their metadata.
+ */
+uint getBrickInfo(uint brickIndex, device const uint *brickMeta) {
+  uint entry = brickMeta[brickIndex / BRICK_LEAF_SIZE];
+  if (entry < BI_FLAG_COUNT) return entry;
+  return brickMeta[entry - BI_FLAG_COUNT + brickIndex % BRICK_LEAF_SIZE];
+}
+
 uint4 computeBrickCoords(float3 normEntryCoords,
                          device const LevelData *levelArray, uint LOD) {
   LevelData level = levelArray[LOD];
@@ -87,6 +98,7 @@ PoolBrickInformation normCoordsToPoolCoords(float3 normEntryCoords,
 struct BrickInformation {
   uint LOD;
   uint brickIndex;
+  uint page;                // atlas page of a non-empty brick
   bool empty;
   bool substitute;
   float3 normExitCoords;
@@ -108,7 +120,7 @@ BrickInformation getBrick(float3 normEntryCoords, uint iLOD,
 
   uint4 brickCoords = computeBrickCoords(normEntryCoords, levelArray, info.LOD);
   uint  brickIndex  = getBrickIndex(brickCoords, levelArray);
-  uint  brickInfo   = brickMeta[brickIndex];
+  uint  brickInfo   = getBrickInfo(brickIndex, brickMeta);
 
   info.brickIndex = brickIndex;
   info.substitute = brickInfo == BI_MISSING;
@@ -125,7 +137,7 @@ BrickInformation getBrick(float3 normEntryCoords, uint iLOD,
       info.LOD++;
       brickCoords = computeBrickCoords(normEntryCoords, levelArray, info.LOD);
       brickIndex  = getBrickIndex(brickCoords, levelArray);
-      brickInfo   = brickMeta[brickIndex];
+      brickInfo   = getBrickInfo(brickIndex, brickMeta);
     } while (brickInfo == BI_MISSING);
 
 #if REQUEST_LOWRES_LOD == 1
@@ -144,7 +156,7 @@ BrickInformation getBrick(float3 normEntryCoords, uint iLOD,
     for (uint lowResLOD = info.LOD+1; lowResLOD<LEVEL_COUNT;++lowResLOD) {
       uint4 lowResBrickCoords = computeBrickCoords(normEntryCoords, levelArray, lowResLOD);
       uint lowResBrickIndex  = getBrickIndex(lowResBrickCoords, levelArray);
-      uint lowResBrickInfo = brickMeta[lowResBrickIndex];
+      uint lowResBrickInfo = getBrickInfo(lowResBrickIndex, brickMeta);
       if (lowResBrickInfo == BI_CHILD_EMPTY) {
         brickCoords = lowResBrickCoords;
         brickInfo = lowResBrickInfo;
@@ -159,6 +171,7 @@ BrickInformation getBrick(float3 normEntryCoords, uint iLOD,
   info.normExitCoords = brickExit(normEntryCoords, direction, cubeBounds, corners);
   if (info.empty) return info;
 
+  info.page = brickInfo - BI_FLAG_COUNT;
   info.poolBrickInfo = normCoordsToPoolCoords(normEntryCoords,
                                               info.normExitCoords,
                                               corners,
@@ -172,6 +185,15 @@ uint computeLOD(float dist) {
              uint(log2(LOD_FACTOR*(dist)/LEVEL_ZERO_WORLD_SPACE_ERROR)));
 }
 
+/**
+ Converts a value sampled from the atlas back to the normalized data range. Each page
+ stores a scale and bias, which are (1, 0) unless the atlas holds quantized bricks.
+ */
+float reconstructValue(float atlasValue, uint page, device const float2 *pageRanges) {
+  float2 range = pageRanges[page];
+  return fma(atlasValue, range.x, range.y);
+}
+
 float3 getSampleDelta() {
   return 1.0/POOL_SIZE;
 }